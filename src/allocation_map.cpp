@@ -0,0 +1,124 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "allocation_map.h"
+
+#include <cassert>
+
+namespace badgerdb {
+
+const PageId AllocationMap::PAGES_PER_GROUP;
+const std::size_t AllocationMap::WORDS_PER_GROUP;
+
+AllocationMap::AllocationMap()
+    : num_pages_(1) {
+}
+
+void AllocationMap::resize(const PageId num_pages) {
+  // Bits past the end of the file are always clear, so shrinking only needs
+  // to clear the bits that fall off.
+  for (PageId i = num_pages; i < num_pages_; ++i) {
+    if (isUsed(i)) {
+      markFree(i);
+    }
+  }
+  num_pages_ = num_pages;
+  const std::size_t num_groups =
+      num_pages_ <= 1 ? 0 : groupOf(num_pages_ - 1) + 1;
+  words_.resize(num_groups * WORDS_PER_GROUP, 0);
+  used_in_group_.resize(num_groups, 0);
+}
+
+bool AllocationMap::isUsed(const PageId page_number) const {
+  if (page_number == Page::INVALID_NUMBER || page_number >= num_pages_) {
+    return false;
+  }
+  const PageId bit = page_number - 1;
+  return (words_[bit / 64] >> (bit % 64)) & 1;
+}
+
+void AllocationMap::markUsed(const PageId page_number) {
+  assert(page_number != Page::INVALID_NUMBER && page_number < num_pages_);
+  assert(!isUsed(page_number));
+  const PageId bit = page_number - 1;
+  words_[bit / 64] |= std::uint64_t(1) << (bit % 64);
+  ++used_in_group_[groupOf(page_number)];
+}
+
+void AllocationMap::markFree(const PageId page_number) {
+  assert(isUsed(page_number));
+  const PageId bit = page_number - 1;
+  words_[bit / 64] &= ~(std::uint64_t(1) << (bit % 64));
+  --used_in_group_[groupOf(page_number)];
+}
+
+PageId AllocationMap::nextUsed(const PageId page_number) const {
+  // Bit index of the first candidate page (page_number + 1).
+  std::size_t bit = page_number;
+  const std::size_t end = num_pages_ - 1;
+  while (bit < end) {
+    const std::size_t group = bit / PAGES_PER_GROUP;
+    if (used_in_group_[group] == 0) {
+      // Nothing used in this group; skip straight to the next one.
+      bit = (group + 1) * PAGES_PER_GROUP;
+      continue;
+    }
+    const std::uint64_t word = words_[bit / 64] >> (bit % 64);
+    if (word != 0) {
+      bit += __builtin_ctzll(word);
+      return bit < end ? static_cast<PageId>(bit + 1) : Page::INVALID_NUMBER;
+    }
+    bit = (bit / 64 + 1) * 64;
+  }
+  return Page::INVALID_NUMBER;
+}
+
+PageId AllocationMap::lastUsed() const {
+  for (std::size_t group = used_in_group_.size(); group-- > 0;) {
+    if (used_in_group_[group] == 0) {
+      continue;
+    }
+    for (std::size_t i = (group + 1) * WORDS_PER_GROUP; i-- > 0;) {
+      if (words_[i] != 0) {
+        return static_cast<PageId>(i * 64 + (63 - __builtin_clzll(words_[i])) + 1);
+      }
+    }
+  }
+  return Page::INVALID_NUMBER;
+}
+
+PageId AllocationMap::nextFree(const PageId page_number) const {
+  std::size_t bit = page_number == Page::INVALID_NUMBER ? 0 : page_number - 1;
+  const std::size_t end = num_pages_ - 1;
+  while (bit < end) {
+    const std::size_t group = bit / PAGES_PER_GROUP;
+    if (used_in_group_[group] == PAGES_PER_GROUP) {
+      // Group is full; skip straight to the next one.
+      bit = (group + 1) * PAGES_PER_GROUP;
+      continue;
+    }
+    const std::uint64_t word = ~words_[bit / 64] >> (bit % 64);
+    if (word != 0) {
+      bit += __builtin_ctzll(word);
+      return bit < end ? static_cast<PageId>(bit + 1) : Page::INVALID_NUMBER;
+    }
+    bit = (bit / 64 + 1) * 64;
+  }
+  return Page::INVALID_NUMBER;
+}
+
+void AllocationMap::recount() {
+  for (std::size_t group = 0; group < used_in_group_.size(); ++group) {
+    std::uint32_t used = 0;
+    for (std::size_t i = 0; i < WORDS_PER_GROUP; ++i) {
+      used += __builtin_popcountll(words_[group * WORDS_PER_GROUP + i]);
+    }
+    used_in_group_[group] = used;
+  }
+}
+
+}
@@ -0,0 +1,170 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "page.h"
+
+namespace badgerdb {
+
+/**
+ * @brief In-memory copy of a file's page allocation bitmap.
+ *
+ * Pages are grouped into runs of PAGES_PER_GROUP consecutive page numbers.
+ * Each group is described by one bitmap page on disk holding one bit per page
+ * (set if the page is in use).  Alongside the bits, the map keeps the number
+ * of used pages in every group; this free-space directory lets searches skip
+ * whole groups that are full (when looking for a free page) or empty (when
+ * looking for a used page) without touching their bits.
+ *
+ * @warning This class is not threadsafe.
+ */
+class AllocationMap {
+ public:
+  /**
+   * Number of pages described by one bitmap page.
+   */
+  static const PageId PAGES_PER_GROUP = Page::SIZE * 8;
+
+  /**
+   * Number of 64-bit words in one bitmap page.
+   */
+  static const std::size_t WORDS_PER_GROUP = PAGES_PER_GROUP / 64;
+
+  /**
+   * Returns the group holding the given page.
+   *
+   * @param page_number   Number of page.
+   * @return  Group number of the page.
+   */
+  static std::uint32_t groupOf(const PageId page_number) {
+    return (page_number - 1) / PAGES_PER_GROUP;
+  }
+
+  /**
+   * Returns the index, within its group's bitmap page, of the word holding
+   * the bit for the given page.
+   *
+   * @param page_number   Number of page.
+   * @return  Word index within the group.
+   */
+  static std::size_t wordInGroup(const PageId page_number) {
+    return ((page_number - 1) % PAGES_PER_GROUP) / 64;
+  }
+
+  /**
+   * Constructs an empty map describing a file with no pages.
+   */
+  AllocationMap();
+
+  /**
+   * Resizes the map to describe page numbers below <num_pages>.  Newly
+   * described pages are free.
+   *
+   * @param num_pages   Number of pages in the file, counting the header.
+   */
+  void resize(const PageId num_pages);
+
+  /**
+   * Returns the number of bitmap groups needed for the described pages.
+   */
+  std::uint32_t numGroups() const {
+    return static_cast<std::uint32_t>(used_in_group_.size());
+  }
+
+  /**
+   * Returns true if the given page is in use.  Pages outside the map are
+   * never in use.
+   *
+   * @param page_number   Number of page.
+   */
+  bool isUsed(const PageId page_number) const;
+
+  /**
+   * Marks the given page as used.
+   *
+   * @param page_number   Number of page.
+   */
+  void markUsed(const PageId page_number);
+
+  /**
+   * Marks the given page as free.
+   *
+   * @param page_number   Number of page.
+   */
+  void markFree(const PageId page_number);
+
+  /**
+   * Returns the lowest-numbered used page after <page_number>, or
+   * Page::INVALID_NUMBER if there is none.
+   *
+   * @param page_number   Page to start after; Page::INVALID_NUMBER to start
+   *                      at the beginning of the file.
+   */
+  PageId nextUsed(const PageId page_number) const;
+
+  /**
+   * Returns the highest-numbered used page, or Page::INVALID_NUMBER if no page
+   * is in use.
+   */
+  PageId lastUsed() const;
+
+  /**
+   * Returns the lowest-numbered free page at or after <page_number>, or
+   * Page::INVALID_NUMBER if there is none.
+   *
+   * @param page_number   Page to start at.
+   */
+  PageId nextFree(const PageId page_number) const;
+
+  /**
+   * Returns the bitmap word holding the bit for the given page, as it should
+   * be stored on disk.
+   *
+   * @param page_number   Number of page.
+   */
+  std::uint64_t wordContaining(const PageId page_number) const {
+    return words_[(page_number - 1) / 64];
+  }
+
+  /**
+   * Returns the WORDS_PER_GROUP words of the given group's bitmap page.
+   *
+   * @param group   Group number.
+   */
+  std::uint64_t* groupWords(const std::uint32_t group) {
+    return &words_[group * WORDS_PER_GROUP];
+  }
+
+  /**
+   * Recomputes the free-space directory from the bitmap words.  Must be
+   * called after filling groups through groupWords().
+   */
+  void recount();
+
+ private:
+  /**
+   * Number of pages described, counting the file header.
+   */
+  PageId num_pages_;
+
+  /**
+   * Bitmap words; bit (n - 1) is set if page n is in use.
+   */
+  std::vector<std::uint64_t> words_;
+
+  /**
+   * Number of used pages in each group.
+   */
+  std::vector<std::uint32_t> used_in_group_;
+};
+
+}
@@ -0,0 +1,164 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace badgerdb {
+namespace bench {
+
+/**
+ * @brief Wall-clock stopwatch for benchmarks.
+ */
+class Timer {
+ public:
+  /**
+   * Constructs a timer that starts running immediately.
+   */
+  Timer() : start_(std::chrono::steady_clock::now()) {}
+
+  /**
+   * Restarts the timer.
+   */
+  void reset() { start_ = std::chrono::steady_clock::now(); }
+
+  /**
+   * Returns the time elapsed since the timer was started, in seconds.
+   */
+  double seconds() const {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start_).count();
+  }
+
+ private:
+  /**
+   * Time the timer was started.
+   */
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Deletes the named file if it exists, so benchmarks can start from scratch
+ * after an interrupted run.
+ *
+ * @param filename  Name of the file.
+ */
+void removeIfExists(const std::string& filename);
+
+/**
+ * Returns the number of heap allocations made through operator new since
+ * the program started.  Take the difference across a measured section.
+ */
+std::uint64_t allocationCount();
+
+/**
+ * Bulk-loads a file under different growth policies and reports the average
+ * latency of File::allocatePage.
+ */
+void fileGrowth();
+
+/**
+ * Measures the space returned by File::reclaimSpace and how reclaiming
+ * affects the cost of allocating the freed pages again.
+ */
+void reclaim();
+
+/**
+ * Flushes 100k dirty buffer pool pages one write at a time in random and in
+ * sorted order, and through BufMgr::flushFile and BufMgr::flushAll, which
+ * merge adjacent pages into vectored writes.
+ */
+void flush();
+
+/**
+ * Times constructing buffer pools of increasing size, against eagerly
+ * initializing the same number of pages.
+ */
+void startup();
+
+/**
+ * Runs a skewed random read workload against a small buffer pool with and
+ * without a CompressedPageCache tier of the same size, and compares the
+ * tier's decompression cost with reading pages from the file.
+ */
+void compressedTier();
+
+/**
+ * Runs a skewed random read workload against a small buffer pool over a
+ * file with artificially slowed reads, with and without a FilePageCache
+ * tier in front of it.
+ */
+void fileTier();
+
+/**
+ * Times CRC-32C over a page with and without the crc32 instruction, and
+ * compares File::readPage with and without checksum verification.
+ */
+void checksum();
+
+/**
+ * Compares the size and the scan throughput, from the OS cache and from the
+ * device, of an uncompressed and a compressed file holding the same records.
+ */
+void compression();
+
+/**
+ * Scans every record of a set of pages with a predicate on a few bytes,
+ * through copying PageIterator and through the zero-copy view iterator, and
+ * reports time and heap allocations per record.
+ */
+void recordScan();
+
+/**
+ * Loads serialized records onto pages through temporary strings, through
+ * the pointer and length overload of Page::insertRecord and through
+ * Page::insertRecords, and reports time and heap allocations per record.
+ */
+void ingest();
+
+/**
+ * Deletes random records from a full page and inserts new ones in their
+ * place, and reports the average cost of a delete and of an insert.
+ */
+void churn();
+
+/**
+ * Times finding a free slot on a page of small records, and scanning such
+ * a page when it is full and when most of its slots are free.
+ */
+void slots();
+
+/**
+ * Updates random records on a full page with values of the same length,
+ * one byte longer and back again, and reports the cost of each.
+ */
+void updates();
+
+/**
+ * Compares slotted pages and FixedPages of records of several sizes:
+ * records per page and the cost of an insert, a lookup and a scan.
+ */
+void fixedPages();
+
+/**
+ * Scans the same fixed-length records on slotted pages, FixedPages and
+ * PaxPages with filters of several selectivities on one column.
+ */
+void paxScan();
+
+/**
+ * Filters records on their bytes with RecordScanner's scalar, SSE2 and AVX2
+ * kernels, and by copying each record out, for integer ranges of several
+ * selectivities, bytes at an offset and substrings.
+ */
+void predicateScan();
+
+}
+}
@@ -0,0 +1,104 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include "bench.h"
+#include "file.h"
+
+namespace {
+
+/**
+ * A benchmark that can be selected by name on the command line.
+ */
+struct Benchmark {
+  const char* name;
+  void (*run)();
+};
+
+const Benchmark benchmarks[] = {
+  {"file_growth", badgerdb::bench::fileGrowth},
+  {"reclaim", badgerdb::bench::reclaim},
+  {"flush", badgerdb::bench::flush},
+  {"startup", badgerdb::bench::startup},
+  {"compressed_tier", badgerdb::bench::compressedTier},
+  {"file_tier", badgerdb::bench::fileTier},
+  {"checksum", badgerdb::bench::checksum},
+  {"compression", badgerdb::bench::compression},
+  {"record_scan", badgerdb::bench::recordScan},
+  {"ingest", badgerdb::bench::ingest},
+  {"churn", badgerdb::bench::churn},
+  {"slots", badgerdb::bench::slots},
+  {"updates", badgerdb::bench::updates},
+  {"fixed_pages", badgerdb::bench::fixedPages},
+  {"pax_scan", badgerdb::bench::paxScan},
+  {"predicate_scan", badgerdb::bench::predicateScan},
+};
+
+/**
+ * Number of calls to the global operator new so far.
+ */
+std::atomic<std::uint64_t> num_allocations(0);
+
+}
+
+/**
+ * Replaces the global allocation functions so benchmarks can count heap
+ * allocations.  The array and sized forms all end up here.
+ */
+void* operator new(std::size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* memory = std::malloc(size == 0 ? 1 : size);
+  if (memory == NULL) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+namespace badgerdb {
+namespace bench {
+
+void removeIfExists(const std::string& filename) {
+  if (File::exists(filename)) {
+    File::remove(filename);
+  }
+}
+
+std::uint64_t allocationCount() {
+  return num_allocations.load(std::memory_order_relaxed);
+}
+
+}
+}
+
+/**
+ * Runs the benchmarks named on the command line, or all of them if none are
+ * named.
+ */
+int main(int argc, char** argv) {
+  const std::size_t num_benchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+  for (std::size_t i = 0; i < num_benchmarks; ++i) {
+    bool selected = argc < 2;
+    for (int arg = 1; arg < argc; ++arg) {
+      selected = selected || std::strcmp(argv[arg], benchmarks[i].name) == 0;
+    }
+    if (selected) {
+      std::cout << "== " << benchmarks[i].name << " ==" << "\n";
+      benchmarks[i].run();
+      std::cout << "\n";
+    }
+  }
+  return 0;
+}
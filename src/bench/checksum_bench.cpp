@@ -0,0 +1,107 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "crc32c.h"
+#include "file.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+/**
+ * Returns the average time, in microseconds, to read <count> random pages
+ * of <file>.
+ */
+double readMicros(File& file, const PageId num_pages, const int count) {
+  std::mt19937 random(7);
+  Timer timer;
+  for (int i = 0; i < count; ++i) {
+    file.readPage(1 + random() % num_pages);
+  }
+  return timer.seconds() * 1e6 / count;
+}
+
+}
+
+void checksum() {
+  const int rounds = 200000;
+  std::vector<char> page(Page::SIZE);
+  std::mt19937 random(1);
+  for (std::size_t i = 0; i < page.size(); ++i) {
+    page[i] = static_cast<char>(random());
+  }
+
+  std::uint32_t sink = 0;
+  std::cout << "CRC-32C of an " << Page::SIZE / 1024 << " KB page ("
+            << (Crc32c::accelerated() ? "crc32 instruction" : "no crc32 instruction")
+            << "):\n";
+  Timer timer;
+  for (int i = 0; i < rounds; ++i) {
+    sink += Crc32c::extend(i, &page[0], page.size());
+  }
+  double seconds = timer.seconds();
+  std::cout << "  extend:         " << std::fixed << std::setprecision(3)
+            << seconds * 1e6 / rounds << " us/page ("
+            << std::setprecision(1)
+            << page.size() * double(rounds) / seconds / (1 << 30) << " GB/s)\n";
+  timer.reset();
+  for (int i = 0; i < rounds / 10; ++i) {
+    sink += Crc32c::extendPortable(i, &page[0], page.size());
+  }
+  seconds = timer.seconds();
+  std::cout << "  extendPortable: " << std::setprecision(3)
+            << seconds * 1e6 / (rounds / 10) << " us/page ("
+            << std::setprecision(1)
+            << page.size() * double(rounds / 10) / seconds / (1 << 30)
+            << " GB/s)\n";
+
+  const PageId num_pages = 16384;
+  const std::string filename = "bench.crc";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    for (PageId n = 0; n < num_pages; ++n) {
+      Page new_page = file.allocatePage();
+      new_page.insertRecord("checksummed");
+      file.writePage(new_page);
+    }
+    file.sync();
+
+    std::cout << "File::readPage of random pages from the OS cache:\n";
+    std::cout << "  without verification: " << std::setprecision(2)
+              << readMicros(file, num_pages, 100000) << " us/page\n";
+    file.setChecksums(true);
+    std::cout << "  with verification:    "
+              << readMicros(file, num_pages, 100000) << " us/page\n";
+
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd >= 0) {
+      ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      ::close(fd);
+    }
+    std::cout << "File::readPage from the device, with verification: "
+              << readMicros(file, num_pages, 2000) << " us/page\n";
+  }
+  File::remove(filename);
+  // Keeps the checksum loops from being optimized away.
+  if (sink == 1) {
+    std::cout << "\n";
+  }
+}
+
+}
+}
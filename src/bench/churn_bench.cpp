@@ -0,0 +1,130 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "page.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const int ROUNDS = 1000000;
+
+/**
+ * Fills <page> with records of random length drawn from <lengths>.
+ */
+void fillPage(Page& page, std::vector<RecordId>& rids,
+              std::uniform_int_distribution<std::size_t>& lengths,
+              std::mt19937& random, const std::vector<char>& bytes) {
+  while (true) {
+    const std::size_t length = lengths(random);
+    if (!page.hasSpaceForRecord(length)) {
+      break;
+    }
+    rids.push_back(page.insertRecord(&bytes[0], length));
+  }
+}
+
+/**
+ * Runs two churn patterns on pages of records of <min_length> to
+ * <max_length> bytes and prints the average cost of a delete and of an
+ * insert in each.
+ */
+void churnPage(const std::size_t min_length, const std::size_t max_length) {
+  std::mt19937 random(9);
+  std::uniform_int_distribution<std::size_t> lengths(min_length, max_length);
+  const std::vector<char> bytes(max_length, 'r');
+
+  // Steady churn: every round deletes a random record from a full page and
+  // inserts a new one of random length in its place, if it fits.
+  Page page;
+  std::vector<RecordId> rids;
+  fillPage(page, rids, lengths, random, bytes);
+  const std::size_t records_per_page = rids.size();
+  double delete_seconds = 0;
+  double insert_seconds = 0;
+  int deletes = 0;
+  int inserts = 0;
+  Timer timer;
+  for (int i = 0; i < ROUNDS; ++i) {
+    RecordId& rid = rids[random() % rids.size()];
+    const std::size_t length = lengths(random);
+    timer.reset();
+    page.deleteRecord(rid);
+    delete_seconds += timer.seconds();
+    ++deletes;
+    if (page.hasSpaceForRecord(length)) {
+      timer.reset();
+      rid = page.insertRecord(&bytes[0], length);
+      insert_seconds += timer.seconds();
+      ++inserts;
+    } else {
+      rid = page.insertRecord(&bytes[0], min_length);
+    }
+  }
+  std::cout << "  " << std::setw(3) << min_length << "-" << std::setw(3)
+            << std::left << max_length << std::right << " bytes, "
+            << std::setw(3) << records_per_page << "/page  steady:     "
+            << "delete " << std::fixed << std::setprecision(0) << std::setw(5)
+            << delete_seconds * 1e9 / deletes << " ns, insert "
+            << std::setw(5) << insert_seconds * 1e9 / inserts << " ns\n";
+
+  // Batch churn: delete half of a full page's records, then refill it.
+  delete_seconds = insert_seconds = 0;
+  deletes = inserts = 0;
+  while (deletes < ROUNDS) {
+    std::shuffle(rids.begin(), rids.end(), random);
+    const std::size_t keep = rids.size() / 2;
+    timer.reset();
+    for (std::size_t n = keep; n < rids.size(); ++n) {
+      page.deleteRecord(rids[n]);
+    }
+    delete_seconds += timer.seconds();
+    deletes += rids.size() - keep;
+    rids.resize(keep);
+    std::vector<std::size_t> new_lengths;
+    std::size_t free_space = page.getFreeSpace();
+    while (true) {
+      const std::size_t length = lengths(random);
+      if (length + page.getSlotSize() > free_space) {
+        break;
+      }
+      new_lengths.push_back(length);
+      free_space -= length + page.getSlotSize();
+    }
+    timer.reset();
+    for (std::size_t n = 0; n < new_lengths.size(); ++n) {
+      rids.push_back(page.insertRecord(&bytes[0], new_lengths[n]));
+    }
+    insert_seconds += timer.seconds();
+    inserts += new_lengths.size();
+  }
+  std::cout << "                             batch:      delete "
+            << std::setw(5) << delete_seconds * 1e9 / deletes
+            << " ns, insert " << std::setw(5)
+            << insert_seconds * 1e9 / inserts << " ns\n";
+}
+
+}
+
+void churn() {
+  std::cout << "Delete/insert churn on a full page (steady times include "
+               "about 20 ns of timer overhead):\n";
+  churnPage(8, 24);
+  churnPage(40, 120);
+  churnPage(200, 600);
+}
+
+}
+}
@@ -0,0 +1,129 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "bench.h"
+#include "buffer.h"
+#include "compressed_page_cache.h"
+#include "file.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+/**
+ * Drops the file's pages from the operating system's cache, so the next
+ * reads go to the device.
+ */
+void dropOsCache(const std::string& filename) {
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+  }
+}
+
+/**
+ * Returns the average time, in microseconds, to read <count> random pages
+ * of <file> straight from the file.
+ */
+double fileReadMicros(File& file, const PageId num_pages, const int count) {
+  std::mt19937 random(7);
+  Timer timer;
+  for (int i = 0; i < count; ++i) {
+    file.readPage(1 + random() % num_pages);
+  }
+  return timer.seconds() * 1e6 / count;
+}
+
+}
+
+void compressedTier() {
+  const PageId num_pages = 16384;
+  const std::uint32_t frames = 1024;
+  const int num_reads = 200000;
+  const std::string filename = "bench.tier";
+  removeIfExists(filename);
+  {
+    // Pages about two thirds full of short, repetitive records.
+    File file = File::create(filename);
+    char record[64];
+    for (PageId n = 0; n < num_pages; ++n) {
+      Page new_page = file.allocatePage();
+      for (int r = 0; r < 100; ++r) {
+        std::snprintf(record, sizeof(record), "customer %08u order %06d status %s",
+                      new_page.page_number() * 100 + r, r * 37 % 1000,
+                      r % 3 == 0 ? "SHIPPED" : "PENDING");
+        new_page.insertRecord(record);
+      }
+      file.writePage(new_page);
+    }
+    file.sync();
+
+    std::cout << num_pages << " pages (" << num_pages * (Page::SIZE / 1024) / 1024
+              << " MB), pool of " << frames << " frames ("
+              << frames * (Page::SIZE / 1024) / 1024 << " MB), "
+              << num_reads << " random reads over the first quarter\n";
+    for (int with_tier = 0; with_tier < 2; ++with_tier) {
+      // Same memory again, spent on the compressed tier.
+      CompressedPageCache tier(std::size_t(frames) * Page::SIZE);
+      BufMgr buffers(frames);
+      if (with_tier) {
+        buffers.addCacheTier(&tier);
+      }
+      std::mt19937 random(42);
+      Page* page;
+      Timer timer;
+      for (int i = 0; i < num_reads; ++i) {
+        // Reads concentrated on the first quarter of the file.
+        const PageId page_number = 1 + random() % (num_pages / 4);
+        buffers.readPage(&file, page_number, page);
+        buffers.unPinPage(&file, page_number, false);
+      }
+      const double seconds = timer.seconds();
+      std::cout << "  " << (with_tier ? "with" : "without")
+                << " compressed tier: " << std::fixed << std::setprecision(2)
+                << seconds * 1e6 / num_reads << " us/read";
+      if (with_tier) {
+        const CompressedPageCacheStats& stats = tier.stats();
+        const std::uint64_t pool_hits = num_reads - (stats.hits + stats.misses);
+        std::cout << ", pool hits " << std::setprecision(1)
+                  << 100.0 * pool_hits / num_reads << "%, tier hits "
+                  << 100.0 * stats.hits / num_reads << "%, effective "
+                  << 100.0 * (pool_hits + stats.hits) / num_reads << "%\n"
+                  << "    tier holds " << stats.pages << " pages in "
+                  << stats.bytes / 1024 << " KB (ratio "
+                  << std::setprecision(2)
+                  << double(stats.pages) * Page::SIZE / stats.bytes
+                  << "x); compress " << stats.compress_ns / 1e3 / stats.stores
+                  << " us/page, decompress "
+                  << stats.decompress_ns / 1e3 / stats.hits << " us/page";
+      }
+      std::cout << "\n";
+    }
+
+    std::cout << "  file read from OS cache:  " << std::fixed
+              << std::setprecision(2) << fileReadMicros(file, num_pages, 20000)
+              << " us/page\n";
+    dropOsCache(filename);
+    std::cout << "  file read from device:    "
+              << fileReadMicros(file, num_pages, 2000) << " us/page\n";
+  }
+  File::remove(filename);
+}
+
+}
+}
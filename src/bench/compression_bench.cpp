@@ -0,0 +1,161 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "file.h"
+#include "file_iterator.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const PageId NUM_PAGES = 32768;
+const PageId BATCH_PAGES = 64;
+
+/**
+ * Fills <file> with pages of customer-like records, which repeat field
+ * names and share prefixes the way real tuples do.
+ */
+void fill(File& file) {
+  std::mt19937 random(3);
+  static const char* const cities[] = {"Madison", "Milwaukee", "Green Bay",
+                                       "Eau Claire", "La Crosse"};
+  char record[128];
+  int id = 0;
+  for (PageId n = 0; n < NUM_PAGES; n += BATCH_PAGES) {
+    std::vector<Page> pages(BATCH_PAGES);
+    std::vector<const Page*> to_write;
+    for (PageId i = 0; i < BATCH_PAGES; ++i) {
+      pages[i] = file.allocatePage();
+      while (true) {
+        std::snprintf(record, sizeof(record),
+                      "id=%08d name=customer%06u city=%s balance=%u.%02u",
+                      id, static_cast<unsigned>(random() % 1000000),
+                      cities[random() % 5],
+                      static_cast<unsigned>(random() % 100000),
+                      static_cast<unsigned>(random() % 100));
+        if (!pages[i].hasSpaceForRecord(record)) {
+          break;
+        }
+        pages[i].insertRecord(record);
+        ++id;
+      }
+      to_write.push_back(&pages[i]);
+    }
+    file.writePages(to_write);
+  }
+  file.sync();
+}
+
+/**
+ * Returns the bytes the named file takes on disk.
+ */
+std::uint64_t diskBytes(const std::string& filename) {
+  struct stat status;
+  if (::stat(filename.c_str(), &status) != 0) {
+    return 0;
+  }
+  return std::uint64_t(status.st_blocks) * 512;
+}
+
+/**
+ * Drops the named file from the OS page cache.
+ */
+void dropCache(const std::string& filename) {
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+  }
+}
+
+/**
+ * Reads every page of <file> in batches with File::readPages and returns the
+ * throughput in MB of pages per second.
+ */
+double scanBatches(File& file) {
+  std::vector<Page> pages(BATCH_PAGES);
+  Timer timer;
+  for (PageId n = 1; n <= NUM_PAGES; n += BATCH_PAGES) {
+    file.readPages(n, BATCH_PAGES, &pages[0]);
+  }
+  return NUM_PAGES * double(Page::SIZE) / timer.seconds() / (1 << 20);
+}
+
+/**
+ * Reads every page of <file> through a FileIterator and returns the
+ * throughput in MB of pages per second.
+ */
+double scanIterator(File& file) {
+  std::size_t free_space = 0;
+  Timer timer;
+  for (FileIterator iter = file.begin(); iter != file.end(); ++iter) {
+    free_space += (*iter).getFreeSpace();
+  }
+  const double seconds = timer.seconds();
+  // Keeps the loop from being optimized away.
+  if (free_space == 1) {
+    std::cout << "\n";
+  }
+  return NUM_PAGES * double(Page::SIZE) / seconds / (1 << 20);
+}
+
+}
+
+void compression() {
+  const std::string names[2] = {"bench.raw", "bench.lz"};
+  std::cout << NUM_PAGES << " pages of customer records:\n";
+  std::cout << "                 disk MB  ratio  scan MB/s (cached)   "
+               "scan MB/s (device)\n";
+  std::cout << "                                 batches  iterator    "
+               "batches  iterator\n";
+  for (int compressed = 0; compressed < 2; ++compressed) {
+    const std::string& filename = names[compressed];
+    removeIfExists(filename);
+    {
+      File file = File::create(filename, compressed != 0);
+      fill(file);
+      const std::uint64_t disk = diskBytes(filename);
+      const double ratio =
+          compressed
+          ? NUM_PAGES * double(Page::SIZE) /
+            file.compressionStats().stored_bytes
+          : 1.0;
+      // Warm the OS cache first.
+      scanBatches(file);
+      const double cached_batches = scanBatches(file);
+      const double cached_iterator = scanIterator(file);
+      dropCache(filename);
+      const double device_batches = scanBatches(file);
+      dropCache(filename);
+      const double device_iterator = scanIterator(file);
+      std::cout << (compressed ? "  compressed   " : "  uncompressed ")
+                << std::fixed << std::setprecision(1) << std::setw(9)
+                << disk / double(1 << 20) << std::setprecision(2)
+                << std::setw(7) << ratio << std::setprecision(0)
+                << std::setw(10) << cached_batches << std::setw(10)
+                << cached_iterator << std::setw(11) << device_batches
+                << std::setw(10) << device_iterator << "\n";
+    }
+    File::remove(filename);
+  }
+}
+
+}
+}
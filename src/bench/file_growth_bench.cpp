@@ -0,0 +1,66 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <iomanip>
+#include <iostream>
+
+#include "bench.h"
+#include "file.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+/**
+ * Appends <num_pages> pages to a fresh file grown under <policy> and returns
+ * the average allocatePage latency in microseconds.
+ */
+double bulkLoad(const GrowthPolicy& policy, const PageId num_pages) {
+  const std::string filename = "bench.growth";
+  removeIfExists(filename);
+  double micros_per_page;
+  {
+    File file = File::create(filename);
+    file.setGrowth(policy);
+    Timer timer;
+    for (PageId i = 0; i < num_pages; ++i) {
+      file.allocatePage();
+    }
+    file.sync();
+    micros_per_page = timer.seconds() * 1e6 / num_pages;
+  }
+  File::remove(filename);
+  return micros_per_page;
+}
+
+}
+
+void fileGrowth() {
+  const PageId num_pages = 16384;
+  struct {
+    const char* name;
+    GrowthPolicy policy;
+  } cases[] = {
+    {"one page at a time", {1, false, 0}},
+    {"64 KB extents", {8, false, 0}},
+    {"1 MB extents", {128, false, 0}},
+    {"doubling, 1 MB - 64 MB", {128, true, 8192}},
+  };
+
+  std::cout << "Bulk load of " << num_pages << " pages ("
+            << num_pages * Page::SIZE / (1 << 20) << " MB)\n";
+  for (std::size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+    const double micros = bulkLoad(cases[i].policy, num_pages);
+    std::cout << "  " << std::left << std::setw(26) << cases[i].name
+              << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << micros << " us/page\n";
+  }
+}
+
+}
+}
@@ -0,0 +1,78 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "bench.h"
+#include "buffer.h"
+#include "file.h"
+#include "file_page_cache.h"
+
+namespace badgerdb {
+namespace bench {
+
+void fileTier() {
+  const PageId num_pages = 8192;
+  const std::uint32_t frames = 256;
+  const std::uint32_t cache_pages = 4096;
+  const std::uint32_t slow_read_us = 200;
+  const int num_reads = 20000;
+  const std::string filename = "bench.slow";
+  const std::string cache_filename = "bench.cache";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    for (PageId n = 0; n < num_pages; ++n) {
+      Page new_page = file.allocatePage();
+      new_page.insertRecord("slow tier page");
+      file.writePage(new_page);
+    }
+    file.sync();
+    // Both files share a disk here, so the data file's reads are slowed down
+    // to stand in for network or spinning storage.
+    file.setReadLatency(slow_read_us);
+
+    std::cout << num_pages << " pages read with " << slow_read_us
+              << " us added latency, pool of " << frames
+              << " frames, cache file of " << cache_pages << " pages, "
+              << num_reads << " random reads over the first quarter\n";
+    for (int with_tier = 0; with_tier < 2; ++with_tier) {
+      FilePageCache tier(cache_filename, cache_pages);
+      BufMgr buffers(frames);
+      if (with_tier) {
+        buffers.addCacheTier(&tier);
+      }
+      std::mt19937 random(42);
+      Page* page;
+      Timer timer;
+      for (int i = 0; i < num_reads; ++i) {
+        const PageId page_number = 1 + random() % (num_pages / 4);
+        buffers.readPage(&file, page_number, page);
+        buffers.unPinPage(&file, page_number, false);
+      }
+      const double seconds = timer.seconds();
+      std::cout << "  " << (with_tier ? "with" : "without")
+                << " cache file: " << std::fixed << std::setprecision(2)
+                << seconds * 1e6 / num_reads << " us/read";
+      if (with_tier) {
+        const FilePageCacheStats& stats = tier.stats();
+        const std::uint64_t pool_hits = num_reads - (stats.hits + stats.misses);
+        std::cout << ", pool hits " << std::setprecision(1)
+                  << 100.0 * pool_hits / num_reads << "%, cache file hits "
+                  << 100.0 * stats.hits / num_reads << "%, "
+                  << stats.evictions << " evictions";
+      }
+      std::cout << "\n";
+    }
+  }
+  File::remove(filename);
+}
+
+}
+}
@@ -0,0 +1,140 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "fixed_page.h"
+#include "page.h"
+#include "page_iterator.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::size_t NUM_PAGES = 256;
+const int LOOKUPS = 4000000;
+const int SCAN_ROUNDS = 20;
+
+/**
+ * Prints one line of results.  Times are per record.
+ */
+void report(const char* name, const std::size_t records_per_page,
+            const double insert_ns, const double get_ns, const double scan_ns,
+            const std::uint64_t checksum) {
+  std::cout << "    " << std::left << std::setw(10) << name << std::right
+            << std::setw(5) << records_per_page << "/page  insert "
+            << std::fixed << std::setprecision(1) << std::setw(5) << insert_ns
+            << " ns, get " << std::setw(5) << get_ns << " ns, scan "
+            << std::setw(4) << scan_ns << " ns"
+            << (checksum == 42 ? " " : "") << "\n";
+}
+
+/**
+ * Fills NUM_PAGES pages with <RecordSize>-byte records, once as slotted
+ * Pages and once as FixedPages, then times random lookups and full scans of
+ * both.
+ */
+template <std::size_t RecordSize>
+void compareLayouts() {
+  std::mt19937 random(13);
+  char record[RecordSize];
+  for (std::size_t i = 0; i < RecordSize; ++i) {
+    record[i] = static_cast<char>('a' + i % 26);
+  }
+  std::cout << "  " << RecordSize << "-byte records:\n";
+
+  // The pages are not part of a file, so every record ID has page number
+  // Page::INVALID_NUMBER, and records fill slots 1 to <per_page>.
+  std::vector<Page> pages(NUM_PAGES);
+  std::size_t num_records = 0;
+  Timer timer;
+  for (std::size_t n = 0; n < NUM_PAGES; ++n) {
+    while (pages[n].hasSpaceForRecord(RecordSize)) {
+      pages[n].insertRecord(record, RecordSize);
+      ++num_records;
+    }
+  }
+  double insert_seconds = timer.seconds();
+  std::size_t per_page = num_records / NUM_PAGES;
+  std::uint64_t checksum = 0;
+  timer.reset();
+  for (int i = 0; i < LOOKUPS; ++i) {
+    const RecordId rid = {Page::INVALID_NUMBER,
+                          SlotId(1 + random() % per_page)};
+    checksum += pages[random() % NUM_PAGES].getRecord(rid)[RecordSize / 2];
+  }
+  double get_seconds = timer.seconds();
+  timer.reset();
+  for (int round = 0; round < SCAN_ROUNDS; ++round) {
+    for (std::size_t n = 0; n < NUM_PAGES; ++n) {
+      for (PageViewIterator iter = pages[n].beginViews();
+           iter != pages[n].endViews(); ++iter) {
+        checksum += (*iter).data[0];
+      }
+    }
+  }
+  double scan_seconds = timer.seconds();
+  report("slotted", per_page, insert_seconds * 1e9 / num_records,
+         get_seconds * 1e9 / LOOKUPS,
+         scan_seconds * 1e9 / (num_records * SCAN_ROUNDS), checksum);
+
+  std::vector<Page> fixed_pages(NUM_PAGES);
+  num_records = 0;
+  timer.reset();
+  for (std::size_t n = 0; n < NUM_PAGES; ++n) {
+    FixedPage<RecordSize> fixed(fixed_pages[n]);
+    while (fixed.hasSpaceForRecord()) {
+      fixed.insertRecord(record);
+      ++num_records;
+    }
+  }
+  insert_seconds = timer.seconds();
+  per_page = num_records / NUM_PAGES;
+  timer.reset();
+  for (int i = 0; i < LOOKUPS; ++i) {
+    const RecordId rid = {Page::INVALID_NUMBER,
+                          SlotId(1 + random() % per_page)};
+    checksum += FixedPage<RecordSize>(fixed_pages[random() % NUM_PAGES])
+                    .getRecord(rid)[RecordSize / 2];
+  }
+  get_seconds = timer.seconds();
+  timer.reset();
+  for (int round = 0; round < SCAN_ROUNDS; ++round) {
+    for (std::size_t n = 0; n < NUM_PAGES; ++n) {
+      const FixedPage<RecordSize> fixed(fixed_pages[n]);
+      for (typename FixedPage<RecordSize>::ViewIterator iter =
+               fixed.beginViews();
+           iter != fixed.endViews(); ++iter) {
+        checksum += (*iter).data[0];
+      }
+    }
+  }
+  scan_seconds = timer.seconds();
+  report("fixed", per_page, insert_seconds * 1e9 / num_records,
+         get_seconds * 1e9 / LOOKUPS,
+         scan_seconds * 1e9 / (num_records * SCAN_ROUNDS), checksum);
+}
+
+}
+
+void fixedPages() {
+  std::cout << "Slotted pages against fixed-length record pages (get copies "
+               "a slotted record, returns a pointer to a fixed one):\n";
+  compareLayouts<8>();
+  compareLayouts<16>();
+  compareLayouts<32>();
+  compareLayouts<64>();
+  compareLayouts<128>();
+}
+
+}
+}
@@ -0,0 +1,101 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "buffer.h"
+#include "file.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+/**
+ * Prints the time taken to write <num_pages> pages and sync them.
+ */
+void report(const char* label, const PageId num_pages, const double seconds) {
+  std::cout << "  " << std::left << std::setw(34) << label << std::right
+            << std::fixed << std::setprecision(2) << seconds * 1e3 << " ms ("
+            << std::setprecision(0) << num_pages / seconds << " pages/s)\n";
+}
+
+}
+
+void flush() {
+  const PageId num_pages = 100000;
+  const std::string filename = "bench.flush";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    for (PageId i = 0; i < num_pages; ++i) {
+      Page new_page = file.allocatePage();
+      new_page.insertRecord("flush benchmark record");
+      file.writePage(new_page);
+    }
+    file.sync();
+
+    // Dirty every page, pinning them in random order so that neither the
+    // frames nor the pin order follow the page order.
+    std::vector<PageId> order(num_pages);
+    for (PageId i = 0; i < num_pages; ++i) {
+      order[i] = i + 1;
+    }
+    std::mt19937 random(42);
+    std::shuffle(order.begin(), order.end(), random);
+    BufMgr buffers(num_pages);
+    std::vector<Page*> dirty(num_pages);
+    for (PageId i = 0; i < num_pages; ++i) {
+      buffers.readPage(&file, order[i], dirty[i]);
+      buffers.unPinPage(&file, order[i], true /* dirty */);
+    }
+    std::cout << "Flushing " << num_pages << " dirty pages ("
+              << num_pages * (Page::SIZE / 1024) / 1024 << " MB)\n";
+
+    Timer timer;
+    for (PageId i = 0; i < num_pages; ++i) {
+      file.writePage(*dirty[i]);
+    }
+    file.sync();
+    report("one write per page, random order:", num_pages, timer.seconds());
+
+    std::vector<Page*> sorted(dirty);
+    std::sort(sorted.begin(), sorted.end(), [](const Page* a, const Page* b) {
+      return a->page_number() < b->page_number();
+    });
+    timer.reset();
+    for (PageId i = 0; i < num_pages; ++i) {
+      file.writePage(*sorted[i]);
+    }
+    file.sync();
+    report("one write per page, sorted:", num_pages, timer.seconds());
+
+    timer.reset();
+    buffers.flushFile(&file);
+    file.sync();
+    report("BufMgr::flushFile, merged runs:", num_pages, timer.seconds());
+
+    for (PageId i = 0; i < num_pages; ++i) {
+      buffers.readPage(&file, order[i], dirty[i]);
+      buffers.unPinPage(&file, order[i], true /* dirty */);
+    }
+    timer.reset();
+    const CheckpointStats& stats = buffers.flushAll();
+    report("BufMgr::flushAll checkpoint:", num_pages, timer.seconds());
+    std::cout << "  (" << stats.pages_written << " pages in " << stats.runs
+              << " runs)\n";
+  }
+  File::remove(filename);
+}
+
+}
+}
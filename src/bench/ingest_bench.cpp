@@ -0,0 +1,104 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "page.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::size_t NUM_RECORDS = 1000000;
+
+/**
+ * Prints one line of results for loading NUM_RECORDS records onto
+ * <num_pages> pages.
+ */
+void report(const char* name, const double seconds,
+            const std::uint64_t allocations, const std::size_t num_pages) {
+  std::cout << "  " << name << std::fixed << std::setprecision(1)
+            << std::setw(7) << seconds * 1e9 / NUM_RECORDS << " ns/record"
+            << std::setprecision(2) << std::setw(7)
+            << double(allocations) / NUM_RECORDS << " allocations/record  ("
+            << num_pages << " pages)\n";
+}
+
+}
+
+void ingest() {
+  // Serialized records, back to back in one buffer, as a loader would
+  // receive them.
+  std::vector<char> buffer;
+  std::vector<RecordView> records(NUM_RECORDS);
+  std::vector<std::size_t> offsets(NUM_RECORDS);
+  char record[128];
+  for (std::size_t n = 0; n < NUM_RECORDS; ++n) {
+    const int length = std::snprintf(
+        record, sizeof(record), "id=%08u name=customer%06u balance=%u",
+        static_cast<unsigned>(n), static_cast<unsigned>(n * 7919 % 1000000),
+        static_cast<unsigned>(n * 31 % 100000));
+    offsets[n] = buffer.size();
+    buffer.insert(buffer.end(), record, record + length);
+  }
+  for (std::size_t n = 0; n < NUM_RECORDS; ++n) {
+    const std::size_t end = n + 1 < NUM_RECORDS ? offsets[n + 1]
+                                                : buffer.size();
+    records[n].data = &buffer[offsets[n]];
+    records[n].length = end - offsets[n];
+  }
+  std::vector<Page> pages(NUM_RECORDS / 100);
+  std::vector<RecordId> record_ids(NUM_RECORDS);
+  std::cout << "Loading " << NUM_RECORDS << " serialized records onto pages:\n";
+
+  std::uint64_t allocations = allocationCount();
+  Timer timer;
+  std::size_t page = 0;
+  for (std::size_t n = 0; n < NUM_RECORDS; ++n) {
+    const std::string data(records[n].data, records[n].length);
+    if (!pages[page].hasSpaceForRecord(data)) {
+      ++page;
+    }
+    record_ids[n] = pages[page].insertRecord(data);
+  }
+  report("std::string:      ", timer.seconds(),
+         allocationCount() - allocations, page + 1);
+
+  pages.assign(pages.size(), Page());
+  allocations = allocationCount();
+  timer.reset();
+  page = 0;
+  for (std::size_t n = 0; n < NUM_RECORDS; ++n) {
+    if (!pages[page].hasSpaceForRecord(records[n])) {
+      ++page;
+    }
+    record_ids[n] = pages[page].insertRecord(records[n].data,
+                                             records[n].length);
+  }
+  report("pointer + length: ", timer.seconds(),
+         allocationCount() - allocations, page + 1);
+
+  pages.assign(pages.size(), Page());
+  allocations = allocationCount();
+  timer.reset();
+  std::size_t done = 0;
+  for (page = 0; done < NUM_RECORDS; ++page) {
+    done += pages[page].insertRecords(&records[done], NUM_RECORDS - done,
+                                      &record_ids[done]);
+  }
+  report("insertRecords:    ", timer.seconds(),
+         allocationCount() - allocations, page);
+}
+
+}
+}
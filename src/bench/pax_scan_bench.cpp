@@ -0,0 +1,248 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "fixed_page.h"
+#include "page.h"
+#include "page_iterator.h"
+#include "pax_page.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::size_t NUM_PAGES = 4096;
+const int ROUNDS = 5;
+
+/**
+ * Layout of the benchmark's 64-byte records: an id, a quantity from 0 to 99
+ * that the scans filter on, a price that they sum, and a name.
+ */
+const std::size_t QUANTITY_OFFSET = 4;
+const std::size_t PRICE_OFFSET = 8;
+const std::size_t RECORD_SIZE = 64;
+
+enum Column { ID, QUANTITY, PRICE, NAME };
+
+/**
+ * Builds record number <n>.
+ */
+void makeRecord(const std::uint32_t n, std::mt19937& random, char* record) {
+  const std::uint32_t quantity = random() % 100;
+  const std::uint64_t price = random() % 10000;
+  std::memset(record, 'n', RECORD_SIZE);
+  std::memcpy(record, &n, 4);
+  std::memcpy(record + QUANTITY_OFFSET, &quantity, 4);
+  std::memcpy(record + PRICE_OFFSET, &price, 8);
+}
+
+/**
+ * Result of one scan: the number of records with quantity below the
+ * threshold and the sum of their prices.
+ */
+struct ScanResult {
+  std::size_t matches;
+  std::uint64_t total;
+};
+
+ScanResult scanSlotted(const std::vector<Page>& pages,
+                       const std::uint32_t threshold) {
+  ScanResult result = {0, 0};
+  for (std::size_t n = 0; n < pages.size(); ++n) {
+    for (PageViewIterator iter = pages[n].beginViews();
+         iter != pages[n].endViews(); ++iter) {
+      std::uint32_t quantity;
+      std::memcpy(&quantity, (*iter).data + QUANTITY_OFFSET, 4);
+      if (quantity < threshold) {
+        std::uint64_t price;
+        std::memcpy(&price, (*iter).data + PRICE_OFFSET, 8);
+        ++result.matches;
+        result.total += price;
+      }
+    }
+  }
+  return result;
+}
+
+ScanResult scanFixed(std::vector<Page>& pages, const std::uint32_t threshold) {
+  ScanResult result = {0, 0};
+  for (std::size_t n = 0; n < pages.size(); ++n) {
+    const FixedPage<RECORD_SIZE> fixed(pages[n]);
+    for (FixedPage<RECORD_SIZE>::ViewIterator iter = fixed.beginViews();
+         iter != fixed.endViews(); ++iter) {
+      std::uint32_t quantity;
+      std::memcpy(&quantity, (*iter).data + QUANTITY_OFFSET, 4);
+      if (quantity < threshold) {
+        std::uint64_t price;
+        std::memcpy(&price, (*iter).data + PRICE_OFFSET, 8);
+        ++result.matches;
+        result.total += price;
+      }
+    }
+  }
+  return result;
+}
+
+/**
+ * Scans the quantity column with PaxPage::ColumnIterator, reading the
+ * price column only for matches.
+ */
+ScanResult scanPaxIterator(std::vector<Page>& pages, const PaxSchema& schema,
+                           const std::uint32_t threshold) {
+  ScanResult result = {0, 0};
+  for (std::size_t n = 0; n < pages.size(); ++n) {
+    const PaxPage pax(pages[n], schema);
+    const ColumnView prices = pax.getColumn(PRICE);
+    for (PaxPage::ColumnIterator iter = pax.beginColumn(QUANTITY);
+         iter != pax.endColumn(); ++iter) {
+      std::uint32_t quantity;
+      std::memcpy(&quantity, *iter, 4);
+      if (quantity < threshold) {
+        std::uint64_t price;
+        std::memcpy(&price,
+                    prices.data + (iter.record_id().slot_number - 1) * 8, 8);
+        ++result.matches;
+        result.total += price;
+      }
+    }
+  }
+  return result;
+}
+
+/**
+ * Scans the quantity column as an array, 64 slots at a time: a branch-free
+ * loop the compiler vectorizes builds a mask of matches, which is ANDed with
+ * the occupancy bits before the matching prices are read.
+ */
+ScanResult scanPaxColumn(std::vector<Page>& pages, const PaxSchema& schema,
+                         const std::uint32_t threshold) {
+  ScanResult result = {0, 0};
+  for (std::size_t n = 0; n < pages.size(); ++n) {
+    const PaxPage pax(pages[n], schema);
+    const ColumnView quantities = pax.getColumn(QUANTITY);
+    const ColumnView prices = pax.getColumn(PRICE);
+    for (std::size_t first = 0; first < quantities.num_slots; first += 64) {
+      const std::size_t count =
+          std::min<std::size_t>(64, quantities.num_slots - first);
+      std::uint32_t values[64];
+      std::memcpy(values, quantities.data + first * 4, count * 4);
+      std::uint64_t matches = 0;
+      for (std::size_t i = 0; i < count; ++i) {
+        matches |= std::uint64_t(values[i] < threshold) << i;
+      }
+      matches &= pax.getOccupancy(first / 64);
+      while (matches != 0) {
+        std::uint64_t price;
+        std::memcpy(&price,
+                    prices.data + (first + __builtin_ctzll(matches)) * 8, 8);
+        ++result.matches;
+        result.total += price;
+        matches &= matches - 1;
+      }
+    }
+  }
+  return result;
+}
+
+void report(const char* name, const double seconds,
+            const std::size_t num_records, const ScanResult& result) {
+  std::cout << "    " << std::left << std::setw(22) << name << std::right
+            << std::fixed << std::setprecision(2) << std::setw(6)
+            << seconds * 1e9 / num_records << " ns/record  ("
+            << result.matches / ROUNDS << " matches, total "
+            << result.total / ROUNDS << ")\n";
+}
+
+}
+
+void paxScan() {
+  std::vector<std::uint16_t> widths;
+  widths.push_back(4);
+  widths.push_back(4);
+  widths.push_back(8);
+  widths.push_back(48);
+  const PaxSchema schema(widths);
+
+  // The same records in each layout, as far as each one fits them.
+  std::mt19937 random(17);
+  std::vector<Page> slotted(NUM_PAGES);
+  std::vector<Page> fixed(NUM_PAGES);
+  std::vector<Page> pax(NUM_PAGES);
+  std::size_t num_records = 0;
+  std::size_t num_slotted = 0;
+  char record[RECORD_SIZE];
+  for (std::size_t n = 0; n < NUM_PAGES; ++n) {
+    FixedPage<RECORD_SIZE> fixed_page(fixed[n]);
+    PaxPage pax_page(pax[n], schema);
+    while (pax_page.hasSpaceForRecord()) {
+      makeRecord(num_records++, random, record);
+      pax_page.insertRecord(record);
+      fixed_page.insertRecord(record);
+      if (slotted[n].hasSpaceForRecord(RECORD_SIZE)) {
+        slotted[n].insertRecord(record, RECORD_SIZE);
+        ++num_slotted;
+      }
+    }
+  }
+  std::cout << "Scanning " << num_records << " 64-byte records ("
+            << num_slotted << " on slotted pages) for quantity < threshold "
+            << "and summing the prices of matches:\n";
+
+  const std::uint32_t thresholds[] = {1, 10, 50, 100};
+  for (std::size_t t = 0; t < sizeof(thresholds) / sizeof(thresholds[0]);
+       ++t) {
+    const std::uint32_t threshold = thresholds[t];
+    std::cout << "  " << threshold << "% selectivity:\n";
+    ScanResult result = {0, 0};
+    Timer timer;
+    for (int round = 0; round < ROUNDS; ++round) {
+      const ScanResult scan = scanSlotted(slotted, threshold);
+      result.matches += scan.matches;
+      result.total += scan.total;
+    }
+    report("slotted pages", timer.seconds(), num_slotted * ROUNDS, result);
+
+    result.matches = result.total = 0;
+    timer.reset();
+    for (int round = 0; round < ROUNDS; ++round) {
+      const ScanResult scan = scanFixed(fixed, threshold);
+      result.matches += scan.matches;
+      result.total += scan.total;
+    }
+    report("fixed pages", timer.seconds(), num_records * ROUNDS, result);
+
+    result.matches = result.total = 0;
+    timer.reset();
+    for (int round = 0; round < ROUNDS; ++round) {
+      const ScanResult scan = scanPaxIterator(pax, schema, threshold);
+      result.matches += scan.matches;
+      result.total += scan.total;
+    }
+    report("PAX, column iterator", timer.seconds(), num_records * ROUNDS,
+           result);
+
+    result.matches = result.total = 0;
+    timer.reset();
+    for (int round = 0; round < ROUNDS; ++round) {
+      const ScanResult scan = scanPaxColumn(pax, schema, threshold);
+      result.matches += scan.matches;
+      result.total += scan.total;
+    }
+    report("PAX, column array", timer.seconds(), num_records * ROUNDS,
+           result);
+  }
+}
+
+}
+}
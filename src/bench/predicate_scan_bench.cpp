@@ -0,0 +1,165 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "page.h"
+#include "page_iterator.h"
+#include "record_scan.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::size_t NUM_PAGES = 2048;
+const int ROUNDS = 10;
+
+/**
+ * Fills <pages> with records of a 32-bit key from 0 to 99, a 64-bit
+ * balance, and text naming a city and a customer.  Returns the number of
+ * records.
+ */
+std::size_t fillPages(std::vector<Page>& pages) {
+  std::mt19937 random(11);
+  static const char* const cities[] = {"Madison", "Milwaukee", "Green Bay",
+                                       "La Crosse"};
+  char record[128];
+  std::size_t num_records = 0;
+  for (std::size_t n = 0; n < pages.size(); ++n) {
+    while (true) {
+      const std::int32_t key = random() % 100;
+      const std::int64_t balance = random() % 1000000;
+      std::memcpy(record, &key, 4);
+      std::memcpy(record + 4, &balance, 8);
+      const int text_length = std::snprintf(
+          record + 12, sizeof(record) - 12, "city=%s name=customer%06u",
+          cities[random() % 4], static_cast<unsigned>(random() % 1000000));
+      const std::size_t length = 12 + text_length;
+      if (!pages[n].hasSpaceForRecord(length)) {
+        break;
+      }
+      pages[n].insertRecord(record, length);
+      ++num_records;
+    }
+  }
+  return num_records;
+}
+
+/**
+ * Copies every record out with PageIterator and tests the copy, as a
+ * caller without the scanner would.
+ */
+std::size_t scanCopies(std::vector<Page>& pages,
+                       const RecordPredicate& predicate) {
+  std::size_t matches = 0;
+  for (std::size_t n = 0; n < pages.size(); ++n) {
+    for (PageIterator iter = pages[n].begin(); iter != pages[n].end();
+         ++iter) {
+      const std::string record = *iter;
+      matches += predicate.matches(record.data(), record.size());
+    }
+  }
+  return matches;
+}
+
+std::size_t scanPages(const std::vector<Page>& pages,
+                      const RecordScanner& scanner,
+                      std::vector<RecordId>& rids) {
+  std::size_t matches = 0;
+  for (std::size_t n = 0; n < pages.size(); ++n) {
+    rids.clear();
+    scanner.scanPage(pages[n], rids);
+    matches += rids.size();
+  }
+  return matches;
+}
+
+/**
+ * Returns the faster of two timings, where 0 means none yet.  The machine
+ * may be shared, so the fastest scan is the most repeatable figure.
+ */
+double bestOf(const double best, const double seconds) {
+  return best == 0 || seconds < best ? seconds : best;
+}
+
+}
+
+void predicateScan() {
+  std::vector<Page> pages(NUM_PAGES);
+  const std::size_t num_records = fillPages(pages);
+  std::cout << "Scanning " << num_records << " records on " << NUM_PAGES
+            << " pages for matching record IDs (ns/record, best of " << ROUNDS
+            << " scans):\n";
+  if (RecordScanner::bestKernel() != SCAN_AVX2) {
+    std::cout << "  (no AVX2 on this CPU: the AVX2 column uses "
+              << (RecordScanner::bestKernel() == SCAN_SSE2 ? "SSE2" : "scalar")
+              << ")\n";
+  }
+  std::cout << "  " << std::left << std::setw(30) << "predicate" << std::right
+            << std::setw(9) << "matches" << std::setw(9) << "copies"
+            << std::setw(9) << "scalar" << std::setw(9) << "SSE2"
+            << std::setw(9) << "AVX2" << "\n";
+
+  struct Case {
+    const char* name;
+    RecordPredicate predicate;
+  };
+  const Case cases[] = {
+      {"key in [0, 0]", RecordPredicate::int32Between(0, 0, 0)},
+      {"key in [0, 9]", RecordPredicate::int32Between(0, 0, 9)},
+      {"key in [0, 49]", RecordPredicate::int32Between(0, 0, 49)},
+      {"key in [0, 99]", RecordPredicate::int32Between(0, 0, 99)},
+      {"balance in [0, 99999]",
+       RecordPredicate::int64Between(4, 0, 99999)},
+      {"city=Madison at 12", RecordPredicate::bytesAt(12, "city=Madison")},
+      {"contains customer0001", RecordPredicate::contains("customer0001")},
+      {"contains Green Bay", RecordPredicate::contains("Green Bay")},
+  };
+  const ScanKernel kernels[] = {SCAN_SCALAR, SCAN_SSE2, SCAN_AVX2};
+  std::vector<RecordId> rids;
+  for (std::size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+    std::size_t matches = 0;
+    double copy_seconds = 0;
+    for (int round = 0; round < ROUNDS; ++round) {
+      Timer timer;
+      matches = scanCopies(pages, cases[c].predicate);
+      copy_seconds = bestOf(copy_seconds, timer.seconds());
+    }
+    std::cout << "  " << std::left << std::setw(30) << cases[c].name
+              << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << 100.0 * matches / num_records << "%"
+              << std::setw(9) << std::setprecision(1)
+              << copy_seconds * 1e9 / num_records;
+
+    for (std::size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k) {
+      const RecordScanner scanner(cases[c].predicate, kernels[k]);
+      std::size_t kernel_matches = 0;
+      double seconds = 0;
+      for (int round = 0; round < ROUNDS; ++round) {
+        Timer timer;
+        kernel_matches = scanPages(pages, scanner, rids);
+        seconds = bestOf(seconds, timer.seconds());
+      }
+      std::cout << std::setw(9) << seconds * 1e9 / num_records;
+      if (kernel_matches != matches) {
+        std::cout << " (wrong: " << kernel_matches << " matches)";
+      }
+    }
+    std::cout << "\n";
+  }
+}
+
+}
+}
@@ -0,0 +1,82 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <iomanip>
+#include <iostream>
+
+#include "bench.h"
+#include "file.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+/**
+ * Fills a fresh file with <num_pages> pages holding one record each.
+ */
+void fill(File& file, const PageId num_pages) {
+  for (PageId i = 0; i < num_pages; ++i) {
+    Page new_page = file.allocatePage();
+    new_page.insertRecord("reclaim benchmark record");
+    file.writePage(new_page);
+  }
+}
+
+/**
+ * Deletes every other page in the first half of the file and the whole
+ * second half, optionally reclaims the space, then times allocating and
+ * writing the same number of pages again.
+ */
+void churn(const PageId num_pages, const bool reclaim) {
+  const std::string filename = "bench.reclaim";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    fill(file, num_pages);
+    file.sync();
+    PageId num_deleted = 0;
+    for (PageId n = 1; n <= num_pages; ++n) {
+      if (n > num_pages / 2 || n % 2 == 0) {
+        file.deletePage(n);
+        ++num_deleted;
+      }
+    }
+
+    if (reclaim) {
+      Timer timer;
+      const ReclaimStats stats = file.reclaimSpace();
+      const double seconds = timer.seconds();
+      std::cout << "  reclaimSpace: " << stats.pages_truncated
+                << " pages truncated, " << stats.pages_punched
+                << " pages punched, " << stats.bytes_reclaimed / 1024
+                << " KB reclaimed in " << std::fixed << std::setprecision(2)
+                << seconds * 1e3 << " ms\n";
+    }
+
+    Timer timer;
+    fill(file, num_deleted);
+    file.sync();
+    std::cout << "  reallocate " << num_deleted << " pages "
+              << (reclaim ? "after reclaiming: " : "without reclaiming: ")
+              << std::fixed << std::setprecision(2)
+              << timer.seconds() * 1e6 / num_deleted << " us/page\n";
+  }
+  File::remove(filename);
+}
+
+}
+
+void reclaim() {
+  const PageId num_pages = 8192;
+  std::cout << "File of " << num_pages << " pages; three quarters deleted\n";
+  churn(num_pages, false /* reclaim */);
+  churn(num_pages, true /* reclaim */);
+}
+
+}
+}
@@ -0,0 +1,120 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "page.h"
+#include "page_iterator.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::size_t NUM_PAGES = 2048;
+const int ROUNDS = 10;
+
+/**
+ * Offset of the city field in every record built by fillPages().
+ */
+const std::size_t CITY_OFFSET = 17;
+
+/**
+ * Fills <pages> with customer-like records whose city field starts at
+ * CITY_OFFSET.  Returns the number of records.
+ */
+std::size_t fillPages(std::vector<Page>& pages) {
+  std::mt19937 random(5);
+  static const char* const cities[] = {"Madison   ", "Milwaukee ",
+                                       "Green Bay ", "La Crosse "};
+  char record[128];
+  std::size_t num_records = 0;
+  for (std::size_t n = 0; n < pages.size(); ++n) {
+    while (true) {
+      std::snprintf(record, sizeof(record),
+                    "id=%08u city=%s name=customer%06u balance=%u",
+                    static_cast<unsigned>(num_records),
+                    cities[random() % 4],
+                    static_cast<unsigned>(random() % 1000000),
+                    static_cast<unsigned>(random() % 100000));
+      if (!pages[n].hasSpaceForRecord(record)) {
+        break;
+      }
+      pages[n].insertRecord(record);
+      ++num_records;
+    }
+  }
+  return num_records;
+}
+
+/**
+ * Prints one line of results for a scan of <num_records> records.
+ */
+void report(const char* name, const double seconds,
+            const std::uint64_t allocations, const std::size_t num_records,
+            const std::size_t matches) {
+  std::cout << "  " << name << std::fixed << std::setprecision(1)
+            << std::setw(8) << seconds * 1e9 / num_records << " ns/record"
+            << std::setprecision(2) << std::setw(8)
+            << double(allocations) / num_records << " allocations/record"
+            << "  (" << matches << " matches)\n";
+}
+
+}
+
+void recordScan() {
+  std::vector<Page> pages(NUM_PAGES);
+  const std::size_t num_records = fillPages(pages) * ROUNDS;
+  const std::string city = "Madison";
+  std::cout << "Scanning " << num_records / ROUNDS << " records on "
+            << NUM_PAGES << " pages for city = " << city << ", " << ROUNDS
+            << " times:\n";
+
+  std::size_t matches = 0;
+  std::uint64_t allocations = allocationCount();
+  Timer timer;
+  for (int round = 0; round < ROUNDS; ++round) {
+    for (std::size_t n = 0; n < pages.size(); ++n) {
+      for (PageIterator iter = pages[n].begin(); iter != pages[n].end();
+           ++iter) {
+        const std::string record = *iter;
+        matches += record.compare(CITY_OFFSET, city.size(), city) == 0;
+      }
+    }
+  }
+  double seconds = timer.seconds();
+  report("PageIterator:    ", seconds, allocationCount() - allocations,
+         num_records, matches);
+
+  matches = 0;
+  allocations = allocationCount();
+  timer.reset();
+  for (int round = 0; round < ROUNDS; ++round) {
+    for (std::size_t n = 0; n < pages.size(); ++n) {
+      for (PageViewIterator iter = pages[n].beginViews();
+           iter != pages[n].endViews(); ++iter) {
+        const RecordView record = *iter;
+        matches += record.length >= CITY_OFFSET + city.size() &&
+            std::memcmp(record.data + CITY_OFFSET, city.data(),
+                        city.size()) == 0;
+      }
+    }
+  }
+  seconds = timer.seconds();
+  report("PageViewIterator:", seconds, allocationCount() - allocations,
+         num_records, matches);
+}
+
+}
+}
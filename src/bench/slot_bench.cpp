@@ -0,0 +1,101 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "page.h"
+#include "page_iterator.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const int ROUNDS = 1000000;
+
+/**
+ * Fills <page> with 4-byte records, leaving <spare> bytes free, and returns
+ * their IDs.
+ */
+std::vector<RecordId> fillPage(Page& page, const std::size_t spare) {
+  std::vector<RecordId> rids;
+  while (page.getFreeSpace() >= spare + 4 + page.getSlotSize()) {
+    rids.push_back(page.insertRecord("slot", 4));
+  }
+  return rids;
+}
+
+/**
+ * Returns the average time, in nanoseconds, to scan every record of <page>
+ * with the view iterator.
+ */
+double scanNanos(const Page& page, const int scans) {
+  std::size_t bytes = 0;
+  Timer timer;
+  for (int i = 0; i < scans; ++i) {
+    for (PageViewIterator iter = page.beginViews(); iter != page.endViews();
+         ++iter) {
+      bytes += (*iter).length;
+    }
+  }
+  const double seconds = timer.seconds();
+  // Keeps the loop from being optimized away.
+  if (bytes == 1) {
+    std::cout << "\n";
+  }
+  return seconds * 1e9 / scans;
+}
+
+}
+
+void slots() {
+  std::mt19937 random(11);
+  Page page;
+  // Leave some free space, so inserts only rarely have to compact the page.
+  std::vector<RecordId> rids = fillPage(page, 1024);
+  std::cout << "Page of " << rids.size() << " 4-byte records:\n";
+
+  // Each round frees one random slot and inserts a record, which has to
+  // find it again.  (A page compaction every 250 rounds is included.)
+  Timer timer;
+  double insert_seconds = 0;
+  for (int i = 0; i < ROUNDS; ++i) {
+    RecordId& rid = rids[random() % (rids.size() - 1)];
+    page.deleteRecord(rid);
+    timer.reset();
+    rid = page.insertRecord("slot", 4);
+    insert_seconds += timer.seconds();
+  }
+  std::cout << "  insert into the one free slot: " << std::fixed
+            << std::setprecision(0) << insert_seconds * 1e9 / ROUNDS
+            << " ns (including about 20 ns of timer overhead)\n";
+
+  std::cout << "  scan, dense:          " << std::setw(6)
+            << scanNanos(page, 100000) << " ns/page\n";
+  // Free a run of slots, then most of the rest, keeping the last record so
+  // the slot array keeps its size.
+  std::shuffle(rids.begin(), rids.end() - 1, random);
+  const std::size_t keep = rids.size() / 10;
+  for (std::size_t n = keep; n + 1 < rids.size(); ++n) {
+    page.deleteRecord(rids[n]);
+  }
+  std::cout << "  scan, 10% slots used: " << std::setw(6)
+            << scanNanos(page, 100000) << " ns/page\n";
+  for (std::size_t n = 0; n < keep; ++n) {
+    page.deleteRecord(rids[n]);
+  }
+  std::cout << "  scan, last slot used: " << std::setw(6)
+            << scanNanos(page, 100000) << " ns/page\n";
+}
+
+}
+}
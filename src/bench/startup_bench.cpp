@@ -0,0 +1,48 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+#include "bench.h"
+#include "buffer.h"
+
+namespace badgerdb {
+namespace bench {
+
+void startup() {
+  // Largest pool for which the eagerly initialized comparison is run; beyond
+  // it the zero-filled pages would not fit in memory.
+  const std::uint32_t max_eager_frames = 131072;
+  const std::uint32_t sizes[] = {1024, 16384, 131072, 1048576, 4194304};
+  std::cout << "Constructing a buffer pool (frames of " << Page::SIZE
+            << " bytes)\n";
+  for (std::size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+    const std::uint32_t frames = sizes[i];
+    Timer timer;
+    std::unique_ptr<BufMgr> pool(new BufMgr(frames));
+    const double lazy = timer.seconds();
+    pool.reset();
+
+    std::cout << "  " << std::setw(8) << frames << " frames ("
+              << std::setw(6) << std::uint64_t(frames) * Page::SIZE / (1 << 20)
+              << " MB): BufMgr " << std::fixed << std::setprecision(2)
+              << std::setw(8) << lazy * 1e3 << " ms";
+    if (frames <= max_eager_frames) {
+      // What the constructor used to do: build every frame as an empty page.
+      timer.reset();
+      std::unique_ptr<Page[]> eager(new Page[frames]);
+      const double seconds = timer.seconds();
+      std::cout << ", new Page[] " << std::setw(8) << seconds * 1e3 << " ms";
+    }
+    std::cout << "\n";
+  }
+}
+
+}
+}
@@ -0,0 +1,78 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "page.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const int ROUNDS = 1000000;
+
+/**
+ * Updates random records on a full page of <length>-byte records, first
+ * with new values of the same length and then with values one byte longer
+ * and back, and prints the average cost of each kind of update.
+ */
+void updatePage(const std::size_t length) {
+  std::mt19937 random(11);
+  const std::vector<char> bytes(length + 1, 'u');
+  Page page;
+  std::vector<RecordId> rids;
+  while (page.hasSpaceForRecord(length)) {
+    rids.push_back(page.insertRecord(&bytes[0], length));
+  }
+  // Leave room for a record to grow.
+  page.deleteRecord(rids.back());
+  rids.pop_back();
+
+  Timer timer;
+  for (int i = 0; i < ROUNDS; ++i) {
+    page.updateRecord(rids[random() % rids.size()], &bytes[0], length);
+  }
+  const double same_seconds = timer.seconds();
+
+  double grow_seconds = 0;
+  double shrink_seconds = 0;
+  for (int i = 0; i < ROUNDS; ++i) {
+    const RecordId& rid = rids[random() % rids.size()];
+    timer.reset();
+    page.updateRecord(rid, &bytes[0], length + 1);
+    grow_seconds += timer.seconds();
+    timer.reset();
+    page.updateRecord(rid, &bytes[0], length);
+    shrink_seconds += timer.seconds();
+  }
+
+  std::cout << "  " << std::setw(4) << length << " bytes, " << std::setw(3)
+            << rids.size() << "/page:  same length " << std::fixed
+            << std::setprecision(0) << std::setw(5)
+            << same_seconds * 1e9 / ROUNDS << " ns, +1 byte " << std::setw(5)
+            << grow_seconds * 1e9 / ROUNDS << " ns, -1 byte " << std::setw(5)
+            << shrink_seconds * 1e9 / ROUNDS << " ns\n";
+}
+
+}
+
+void updates() {
+  std::cout << "Updates of random records on a full page (+1 and -1 byte "
+               "times include about 20 ns of timer overhead):\n";
+  updatePage(8);
+  updatePage(32);
+  updatePage(128);
+  updatePage(512);
+}
+
+}
+}
@@ -5,6 +5,7 @@
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
 
+#include <cstdint>
 #include <memory>
 #include <iostream>
 #include "buffer.h"
@@ -15,12 +16,13 @@
 
 namespace badgerdb {
 
-int BufHashTbl::hash(const File* file, const PageId pageNo)
+int BufHashTbl::hash(const FileId fileId, const PageId pageNo)
 {
-  int tmp, value;
-  tmp = (long)file;  // cast of pointer to the file object to an integer
-  value = (tmp + pageNo) % HTSIZE;
-  return value;
+  // Mix the id and page number so consecutive pages of different files do
+  // not pile into the same run of buckets.
+  std::uint64_t key = (static_cast<std::uint64_t>(fileId) << 32) | pageNo;
+  key *= 0x9E3779B97F4A7C15ULL;
+  return static_cast<int>((key >> 32) % HTSIZE);
 }
 
 BufHashTbl::BufHashTbl(int htSize)
@@ -47,12 +49,13 @@ BufHashTbl::~BufHashTbl()
 
 void BufHashTbl::insert(const File* file, const PageId pageNo, const FrameId frameNo)
 {
-  int index = hash(file, pageNo);
+  const FileId fileId = file->id();
+  int index = hash(fileId, pageNo);
 
   hashBucket* tmpBuc = ht[index];
   while (tmpBuc) {
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
-  		throw HashAlreadyPresentException(tmpBuc->file->filename(), tmpBuc->pageNo, tmpBuc->frameNo);
+    if (tmpBuc->fileId == fileId && tmpBuc->pageNo == pageNo)
+  		throw HashAlreadyPresentException(file->filename(), tmpBuc->pageNo, tmpBuc->frameNo);
     tmpBuc = tmpBuc->next;
   }
 
@@ -60,7 +63,7 @@ void BufHashTbl::insert(const File* file, const PageId pageNo, const FrameId fra
   if (!tmpBuc)
   	throw HashTableException();
 
-  tmpBuc->file = (File*) file;
+  tmpBuc->fileId = fileId;
   tmpBuc->pageNo = pageNo;
   tmpBuc->frameNo = frameNo;
   tmpBuc->next = ht[index];
@@ -69,10 +72,11 @@ void BufHashTbl::insert(const File* file, const PageId pageNo, const FrameId fra
 
 bool BufHashTbl::lookup(const File* file, const PageId pageNo, FrameId &frameNo) 
 {
-  int index = hash(file, pageNo);
+  const FileId fileId = file->id();
+  int index = hash(fileId, pageNo);
   hashBucket* tmpBuc = ht[index];
   while (tmpBuc) {
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
+    if (tmpBuc->fileId == fileId && tmpBuc->pageNo == pageNo)
     {
       frameNo = tmpBuc->frameNo; // 'return' frameNo by reference
       return true;
@@ -84,13 +88,14 @@ bool BufHashTbl::lookup(const File* file, const PageId pageNo, FrameId &frameNo)
 
 void BufHashTbl::remove(const File* file, const PageId pageNo) {
 
-  int index = hash(file, pageNo);
+  const FileId fileId = file->id();
+  int index = hash(fileId, pageNo);
   hashBucket* tmpBuc = ht[index];
   hashBucket* prevBuc = NULL;
 
   while (tmpBuc)
 	{
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
+    if (tmpBuc->fileId == fileId && tmpBuc->pageNo == pageNo)
 		{
       if(prevBuc) 
 				prevBuc->next = tmpBuc->next;
@@ -16,9 +16,9 @@ namespace badgerdb {
 */
 struct hashBucket {
 	/**
-	 * pointer a file object (more on this below)
+	 * id of the open file the page belongs to (see File::id())
 	 */
-	File *file;
+	FileId fileId;
 
 	/**
 	 * page number within a file
@@ -55,13 +55,13 @@ class BufHashTbl
   hashBucket**  ht;
 
 	/**
-	 * returns hash value between 0 and HTSIZE-1 computed using file and pageNo
+	 * returns hash value between 0 and HTSIZE-1 computed using the file's id and pageNo
 	 *
-	 * @param file   	File object
+	 * @param fileId 	Id of the open file
 	 * @param pageNo  Page number in the file
 	 * @return  			Hash value.
 	 */
-  int	 hash(const File* file, const PageId pageNo);
+  int	 hash(const FileId fileId, const PageId pageNo);
 
  public:
 	/**
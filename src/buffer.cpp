@@ -5,8 +5,18 @@
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
 #include <memory>
+#include <new>
+#include <sys/mman.h>
+#include <thread>
 #include <iostream>
+#include <vector>
 #include "buffer.h"
 #include "page_iterator.h"
 #include "file_iterator.h"
@@ -16,30 +26,75 @@
 #include "exceptions/bad_buffer_exception.h"
 #include "exceptions/hash_not_found_exception.h"
 #include "exceptions/invalid_page_exception.h"
+#include "exceptions/io_exception.h"
 
 namespace badgerdb { 
 
+namespace {
+
+/**
+ * First word of a file written by BufMgr::saveWorkingSet()
+ */
+const char* const WORKING_SET_MAGIC = "badgerdb-working-set";
+
+/**
+ * Version of the working set file format
+ */
+const int WORKING_SET_VERSION = 1;
+
+/**
+ * Maps <bytes> of zero-filled anonymous memory.  No physical memory is committed until a page of the
+ * mapping is first touched.
+ *
+ * @throws std::bad_alloc If the mapping fails
+ */
+void* mapAnonymous(const std::size_t bytes)
+{
+  void* memory = ::mmap(NULL, std::max<std::size_t>(bytes, 1), PROT_READ | PROT_WRITE,
+    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if(memory == MAP_FAILED){
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+}
+
 BufMgr::BufMgr(std::uint32_t bufs)
 	: numBufs(bufs) {
-	bufDescTable = new BufDesc[bufs];
-
+  // Frames and descriptors live in anonymous mappings, so building the pool costs the same for any size:
+  // frame memory is faulted in when a page is first read into it, and only the small descriptors are
+  // written here.
+	bufDescTable = static_cast<BufDesc*>(mapAnonymous(bufs * sizeof(BufDesc)));
   for (FrameId i = 0; i < bufs; i++) 
   {
+  	new (&bufDescTable[i]) BufDesc();
   	bufDescTable[i].frameNo = i;
-  	bufDescTable[i].valid = false;
   }
 
-  bufPool = new Page[bufs];
+  bufPool = static_cast<Page*>(mapAnonymous(bufs * sizeof(Page)));
+  for (FrameId i = 0; i < bufs; i++) 
+  {
+  	new (&bufPool[i]) Page(Page::Uninitialized());
+  }
 
   int htsize = ((((int) (bufs * 1.2))*2)/2)+1;
   hashTable = new BufHashTbl (htsize);  // allocate the buffer hash table
 
   clockHand = bufs - 1;
+  freeHand = 0;
+  checkpointPosition = 0;
+  prewarmRate = 0;
+  prewarmStop = false;
+  File::addCloseListener(this);
 }
 
 BufMgr::~BufMgr() {
-  delete [] bufPool;
-  delete [] bufDescTable;
+  stopPrewarm();
+  File::removeCloseListener(this);
+  // Pages and descriptors have trivial destructors
+  ::munmap(bufPool, std::max<std::size_t>(numBufs * sizeof(Page), 1));
+  ::munmap(bufDescTable, std::max<std::size_t>(numBufs * sizeof(BufDesc), 1));
   delete hashTable;
 }
 
@@ -60,16 +115,20 @@ void BufMgr::allocBuf(FrameId & frame)
     }else if(bufDescTable[clockHand].refbit==1){
       bufDescTable[clockHand].refbit=0;
       advanceClock();
-    }else if(bufDescTable[clockHand].pinCnt > 0){
+    }else if(bufDescTable[clockHand].pinCnt > 0 || bufDescTable[clockHand].writing){
       fullCount++;
       advanceClock();
     }else if(bufDescTable[clockHand].refbit==0 && bufDescTable[clockHand].pinCnt==0){
       frame = clockHand;
       if(bufDescTable[frame].valid){
+        File file = File::openById(bufDescTable[frame].fileId);
         if(bufDescTable[frame].dirty){
-          (bufDescTable[frame].file)->writePage(bufPool[frame]);
+          file.writePage(bufPool[frame]);
+        }
+        for (std::size_t t = 0; t < cacheTiers.size(); t++) {
+          cacheTiers[t]->store(bufDescTable[frame].fileId, bufDescTable[frame].pageNo, bufPool[frame]);
         }
-        hashTable->remove(bufDescTable[frame].file, bufDescTable[frame].pageNo);
+        hashTable->remove(&file, bufDescTable[frame].pageNo);
       }
       bufDescTable[frame].Clear();
       allocated = true;
@@ -81,14 +140,24 @@ void BufMgr::allocBuf(FrameId & frame)
 }
 	
 void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
+{
+  std::unique_lock<std::mutex> lock(poolMutex);
+  readPageLocked(lock, file, pageNo, page);
+}
+
+void BufMgr::readPageLocked(std::unique_lock<std::mutex>& lock, File* file, const PageId pageNo, Page*& page)
 {
     FrameId frameNo;
+    while(hashTable->lookup(file, pageNo, frameNo) && bufDescTable[frameNo].loading){
+      //the prewarmer is reading the page; wait for it rather than read it twice
+      ioDone.wait(lock);
+    }
     if(!hashTable->lookup(file, pageNo, frameNo)){
       //page is not in a buffer frame yet, adding it
       //allocate space
       allocBuf(frameNo);
       //add to the buffer frame
-      bufPool[frameNo] = file->readPage(pageNo);
+      fetchPage(file, pageNo, frameNo);
       //add info to desctable and hashtable
       bufDescTable[frameNo].Set(file, pageNo);
       hashTable->insert(file, pageNo, frameNo);
@@ -96,13 +165,62 @@ void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
       //page already in buffer, inc pincnt and set refbit
       bufDescTable[frameNo].pinCnt++;
       bufDescTable[frameNo].refbit=true;
+      bufDescTable[frameNo].accessCount++;
     }
     page = &bufPool[frameNo];
 }
 
+void BufMgr::fetchPage(File* file, const PageId pageNo, const FrameId frameNo)
+{
+  for (std::size_t t = 0; t < cacheTiers.size(); t++) {
+    if(cacheTiers[t]->fetch(file->id(), pageNo, bufPool[frameNo])){
+      // The pool now owns the page; copies in lower tiers may be older than
+      // the one just fetched, so drop them too
+      for (std::size_t lower = t + 1; lower < cacheTiers.size(); lower++) {
+        cacheTiers[lower]->invalidate(file->id(), pageNo);
+      }
+      // The page's successor is kept in memory, not in the cached image
+      if(file->completePageRead(pageNo, bufPool[frameNo])){
+        return;
+      }
+      break;
+    }
+  }
+  bufPool[frameNo] = file->readPage(pageNo);
+}
+
+void BufMgr::addCacheTier(PageCacheTier* tier)
+{
+  std::lock_guard<std::mutex> lock(poolMutex);
+  cacheTiers.push_back(tier);
+}
+
+void BufMgr::waitForIo(std::unique_lock<std::mutex>& lock, const File* file)
+{
+  for (FrameId frameNo = 0; frameNo < numBufs; frameNo++) {
+    while((bufDescTable[frameNo].loading || bufDescTable[frameNo].writing) &&
+          bufDescTable[frameNo].fileId == file->id()){
+      ioDone.wait(lock);
+    }
+  }
+}
+
+bool BufMgr::findFreeBuf(FrameId & frame)
+{
+  for (std::uint32_t scanned = 0; scanned < numBufs; scanned++) {
+    const FrameId candidate = freeHand;
+    freeHand = (freeHand + 1) % numBufs;
+    if(!bufDescTable[candidate].valid){
+      frame = candidate;
+      return true;
+    }
+  }
+  return false;
+}
 
 void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty) 
 {
+  std::lock_guard<std::mutex> lock(poolMutex);
   FrameId frameNo;
   if(hashTable->lookup(file, pageNo, frameNo)){
     if(bufDescTable[frameNo].pinCnt <= 0){
@@ -111,6 +229,8 @@ void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty)
       bufDescTable[frameNo].pinCnt--;
       if(dirty){
         bufDescTable[frameNo].dirty = true;
+        //a checkpoint writing the page has an older copy
+        bufDescTable[frameNo].redirtied = bufDescTable[frameNo].writing;
       }
     }
   }
@@ -119,59 +239,469 @@ void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty)
 
 void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page) 
 {
+  std::unique_lock<std::mutex> lock(poolMutex);
   // Allocate a new, empty page in the file and return the Page object.
   Page tempPage;
   tempPage = file->allocatePage();
   pageNo = tempPage.page_number();
   page = &tempPage;
   // Read the page into the buffer pool
-  readPage(file, pageNo, page);
+  readPageLocked(lock, file, pageNo, page);
 }
 
 void BufMgr::flushFile(const File* file) 
 {
-  File tempFile = *file;
-  // Ensure all frames assigned to file are unpinned
-  for (FileIterator iter = tempFile.begin(); iter != tempFile.end(); ++iter) {
-    FrameId frameNo;
-    if(hashTable->lookup(file, (*iter).page_number(), frameNo)){
-      if(bufDescTable[frameNo].pinCnt){
-        throw PagePinnedException(tempFile.filename(), (*iter).page_number(), frameNo);
+  std::unique_lock<std::mutex> lock(poolMutex);
+  waitForIo(lock, file);
+  // Ensure all frames assigned to file are unpinned, and collect the dirty ones
+  std::vector<FrameId> dirtyFrames;
+  for (FrameId frameNo = 0; frameNo < numBufs; frameNo++) {
+    const BufDesc& desc = bufDescTable[frameNo];
+    //cleared frames carry id 0 too
+    if((!desc.valid && desc.pinCnt == 0) || desc.fileId != file->id()){
+      continue;
+    }
+    if(desc.pinCnt){
+      throw PagePinnedException(file->filename(), desc.pageNo, frameNo);
+    }
+    if(!desc.valid){
+      throw BadBufferException(frameNo, desc.dirty, desc.valid, desc.refbit);
+    }
+    if(desc.dirty){
+      dirtyFrames.push_back(frameNo);
+    }
+  }
+  if(dirtyFrames.empty()){
+    return;
+  }
+
+  // Write the dirty pages in page order, adjacent pages with one call
+  std::vector<const Page*> pages;
+  pages.reserve(dirtyFrames.size());
+  for (std::size_t i = 0; i < dirtyFrames.size(); i++) {
+    pages.push_back(&bufPool[dirtyFrames[i]]);
+  }
+  //write through the caller's file; <file> is const, so through a copy of it
+  File writer(*file);
+  writer.writePages(pages);
+  for (std::size_t i = 0; i < dirtyFrames.size(); i++) {
+    bufDescTable[dirtyFrames[i]].dirty = false;
+  }
+}
+
+const CheckpointStats& BufMgr::flushAll()
+{
+  beginCheckpoint();
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  while (checkpointStep()) {
+    if (checkpointPolicy.max_pages_per_second > 0) {
+      // Leave the disk to foreground I/O for whatever is left of this step's share of time
+      const std::chrono::duration<double> due(
+        double(checkpointStats.pages_written) / checkpointPolicy.max_pages_per_second);
+      const std::chrono::steady_clock::time_point resume =
+        start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(due);
+      std::this_thread::sleep_until(resume);
+    }
+  }
+  return checkpointStats;
+}
+
+void BufMgr::beginCheckpoint()
+{
+  std::lock_guard<std::mutex> lock(poolMutex);
+  checkpointQueue.clear();
+  checkpointFiles.clear();
+  checkpointPosition = 0;
+  checkpointStats.clear();
+  for (FrameId frameNo = 0; frameNo < numBufs; frameNo++) {
+    const BufDesc& desc = bufDescTable[frameNo];
+    if(desc.valid && desc.dirty){
+      CheckpointEntry entry = {frameNo, desc.fileId, desc.pageNo};
+      checkpointQueue.push_back(entry);
+    }
+  }
+  std::sort(checkpointQueue.begin(), checkpointQueue.end(),
+    [](const CheckpointEntry& a, const CheckpointEntry& b) {
+      return a.fileId < b.fileId || (a.fileId == b.fileId && a.pageNo < b.pageNo);
+    });
+  checkpointStats.pages_dirty = checkpointQueue.size();
+}
+
+bool BufMgr::checkpointStep()
+{
+  // Declared before the lock so that the File objects go after it is released: dropping what may be the
+  // last reference to a file tells the pool, which takes the lock
+  std::vector<File> files;
+  std::unique_lock<std::mutex> lock(poolMutex);
+  const std::size_t batchEnd = std::min(checkpointQueue.size(),
+    checkpointPosition + std::max<std::uint32_t>(checkpointPolicy.batch_pages, 1));
+  // Copy the batch out under the lock, one group of entries per file.  The frames are marked as being
+  // written, so they stay put, but may be pinned and modified while the copies go to disk.
+  std::vector<Page> copies;
+  copies.reserve(batchEnd - checkpointPosition);
+  std::vector<FrameId> frames;
+  std::vector<std::size_t> fileEnds;
+  PageId lastPageNo = Page::INVALID_NUMBER;
+  for (std::size_t i = checkpointPosition; i < batchEnd; i++) {
+    const CheckpointEntry& entry = checkpointQueue[i];
+    BufDesc& desc = bufDescTable[entry.frameNo];
+    if(!desc.valid || !desc.dirty || desc.fileId != entry.fileId || desc.pageNo != entry.pageNo){
+      checkpointStats.pages_gone++;
+      continue;
+    }
+    if(desc.pinCnt > 0 || desc.writing){
+      checkpointStats.pages_skipped++;
+      continue;
+    }
+    if(files.empty() || files.back().id() != desc.fileId){
+      if(!files.empty()){
+        fileEnds.push_back(frames.size());
       }
-      if(!bufDescTable[frameNo].valid){
-        throw BadBufferException(frameNo, bufDescTable[frameNo].dirty, 
-          bufDescTable[frameNo].valid, bufDescTable[frameNo].refbit);
+      files.push_back(File::openById(desc.fileId));
+      if(std::find(checkpointFiles.begin(), checkpointFiles.end(), desc.fileId) == checkpointFiles.end()){
+        checkpointFiles.push_back(desc.fileId);
       }
+      lastPageNo = Page::INVALID_NUMBER;
     }
+    if(lastPageNo == Page::INVALID_NUMBER || entry.pageNo != lastPageNo + 1){
+      checkpointStats.runs++;
+    }
+    lastPageNo = entry.pageNo;
+    copies.push_back(bufPool[entry.frameNo]);
+    frames.push_back(entry.frameNo);
+    desc.writing = true;
+    desc.redirtied = false;
+    checkpointStats.pages_written++;
   }
+  fileEnds.push_back(frames.size());
+  checkpointPosition = batchEnd;
 
-  // Iterate through all pages in the file.
-  for (FileIterator iter = tempFile.begin(); iter != tempFile.end(); ++iter) {
-    FrameId frameNo;
-    if(hashTable->lookup(file, (*iter).page_number(), frameNo)){
-      //if page is dirty, write it to disk
-      if(bufDescTable[frameNo].dirty){
-        (bufDescTable[frameNo].file)->writePage(bufPool[frameNo]);
-        bufDescTable[frameNo].dirty = false;
+  // Write uncompressed files without the lock, so pins of every page proceed meanwhile.  Only the images
+  // go out then: the check that the pages are still in use reads the file's metadata, which the pool only
+  // touches under the lock, and the pages cannot be disposed of while marked as being written.  Placing
+  // compressed images updates the file's offset map, so those are written with the lock held.
+  std::size_t written = 0;
+  try {
+    std::vector<const Page*> pages;
+    for (std::size_t f = 0; f < files.size(); f++) {
+      pages.clear();
+      for (std::size_t c = written; c < fileEnds[f]; c++) {
+        pages.push_back(&copies[c]);
       }
+      if(files[f].compressed()){
+        files[f].writePages(pages);
+      } else {
+        files[f].checkPagesUsed(pages);
+        lock.unlock();
+        files[f].writePageImages(pages);
+        lock.lock();
+      }
+      written = fileEnds[f];
+    }
+  } catch (...) {
+    if(!lock.owns_lock()){
+      lock.lock();
+    }
+    finishWrites(frames, written);
+    lock.unlock();
+    ioDone.notify_all();
+    throw;
+  }
+  finishWrites(frames, written);
+  ioDone.notify_all();
+
+  if(checkpointPosition < checkpointQueue.size()){
+    return true;
+  }
+  for (std::size_t f = 0; f < checkpointFiles.size(); f++) {
+    File::openById(checkpointFiles[f]).sync();
+  }
+  checkpointFiles.clear();
+  checkpointQueue.clear();
+  checkpointPosition = 0;
+  return false;
+}
+
+void BufMgr::finishWrites(const std::vector<FrameId>& frames, const std::size_t written)
+{
+  for (std::size_t i = 0; i < frames.size(); i++) {
+    BufDesc& desc = bufDescTable[frames[i]];
+    if(i < written && !desc.redirtied){
+      desc.dirty = false;
     }
+    desc.writing = false;
+    desc.redirtied = false;
   }
 }
 
 void BufMgr::disposePage(File* file, const PageId PageNo)
 {
+    std::unique_lock<std::mutex> lock(poolMutex);
+    waitForIo(lock, file);
     FrameId frameNo;
     if(hashTable->lookup(file, PageNo, frameNo)){
       //Page present in buffer, so remove it
-      hashTable->remove(bufDescTable[frameNo].file, bufDescTable[frameNo].pageNo);
+      hashTable->remove(file, PageNo);
       bufDescTable[frameNo].Clear();
     }
+    for (std::size_t t = 0; t < cacheTiers.size(); t++) {
+      cacheTiers[t]->invalidate(file->id(), PageNo);
+    }
     //Delete page from file
     file->deletePage(PageNo);
 }
 
+void BufMgr::fileClosing(File& file)
+{
+  std::unique_lock<std::mutex> lock(poolMutex);
+  waitForIo(lock, &file);
+  std::vector<FrameId> frames;
+  std::vector<const Page*> dirtyPages;
+  const FrameId pinnedFrame = fileFrames(file, frames, dirtyPages);
+  const PageId pinnedPageNo = pinnedFrame != numBufs ? bufDescTable[pinnedFrame].pageNo : Page::INVALID_NUMBER;
+  // Frames are dropped even if the write fails, or a page is still pinned: the file is closing anyway, and
+  // its id is about to be handed to another file
+  try {
+    if(!dirtyPages.empty()){
+      file.writePages(dirtyPages);
+    }
+  } catch (...) {
+    dropFrames(file, frames);
+    throw;
+  }
+  dropFrames(file, frames);
+  checkpointFiles.erase(std::remove(checkpointFiles.begin(), checkpointFiles.end(), file.id()),
+    checkpointFiles.end());
+  if(pinnedFrame != numBufs){
+    throw PagePinnedException(file.filename(), pinnedPageNo, pinnedFrame);
+  }
+}
+
+void BufMgr::fileCompacting(File& file)
+{
+  std::unique_lock<std::mutex> lock(poolMutex);
+  waitForIo(lock, &file);
+  std::vector<FrameId> frames;
+  std::vector<const Page*> dirtyPages;
+  const FrameId pinnedFrame = fileFrames(file, frames, dirtyPages);
+  // Unlike a closing file, this one stays as it was if anything is in the way
+  if(pinnedFrame != numBufs){
+    throw PagePinnedException(file.filename(), bufDescTable[pinnedFrame].pageNo, pinnedFrame);
+  }
+  if(!dirtyPages.empty()){
+    file.writePages(dirtyPages);
+  }
+  dropFrames(file, frames);
+}
+
+FrameId BufMgr::fileFrames(const File& file, std::vector<FrameId>& frames, std::vector<const Page*>& dirtyPages)
+{
+  FrameId pinnedFrame = numBufs;
+  for (FrameId frameNo = 0; frameNo < numBufs; frameNo++) {
+    const BufDesc& desc = bufDescTable[frameNo];
+    if(!desc.valid || desc.fileId != file.id()){
+      continue;
+    }
+    if(desc.pinCnt > 0 && pinnedFrame == numBufs){
+      pinnedFrame = frameNo;
+    }
+    frames.push_back(frameNo);
+    if(desc.dirty){
+      dirtyPages.push_back(&bufPool[frameNo]);
+    }
+  }
+  return pinnedFrame;
+}
+
+void BufMgr::dropFrames(File& file, const std::vector<FrameId>& frames)
+{
+  for (std::size_t i = 0; i < frames.size(); i++) {
+    hashTable->remove(&file, bufDescTable[frames[i]].pageNo);
+    bufDescTable[frames[i]].Clear();
+  }
+  for (std::size_t t = 0; t < cacheTiers.size(); t++) {
+    cacheTiers[t]->invalidateFile(file.id());
+  }
+}
+
+void BufMgr::saveWorkingSet(const std::string& path) const
+{
+  const std::string tempPath = path + ".tmp";
+  {
+    std::ofstream out(tempPath.c_str(), std::ios::out | std::ios::trunc);
+    if(!out){
+      throw IoException(tempPath, "open", errno);
+    }
+    out << WORKING_SET_MAGIC << " " << WORKING_SET_VERSION << "\n";
+    std::lock_guard<std::mutex> lock(poolMutex);
+    for (FrameId frameNo = 0; frameNo < numBufs; frameNo++) {
+      const BufDesc& desc = bufDescTable[frameNo];
+      if(desc.valid && !desc.loading){
+        out << desc.accessCount << " " << desc.pageNo << " " << File::openById(desc.fileId).filename() << "\n";
+      }
+    }
+    out.flush();
+    if(!out){
+      throw IoException(tempPath, "write", errno);
+    }
+  }
+  if(std::rename(tempPath.c_str(), path.c_str()) != 0){
+    throw IoException(path, "rename", errno);
+  }
+}
+
+std::uint32_t BufMgr::startPrewarm(const std::string& path, const std::vector<File*>& files,
+                                   const std::uint32_t pagesPerSecond)
+{
+  stopPrewarm();
+
+  std::ifstream in(path.c_str());
+  std::string magic;
+  int version = 0;
+  if(!in || !(in >> magic >> version) || magic != WORKING_SET_MAGIC || version != WORKING_SET_VERSION){
+    return 0;
+  }
+  std::map<std::string, File*> filesByName;
+  for (std::size_t i = 0; i < files.size(); i++) {
+    filesByName[files[i]->filename()] = files[i];
+  }
+  std::vector<std::pair<std::uint32_t, PrewarmEntry> > saved;
+  std::uint32_t hotness;
+  PageId pageNo;
+  std::string filename;
+  while (in >> hotness >> pageNo && in.get() == ' ' && std::getline(in, filename)) {
+    const std::map<std::string, File*>::const_iterator file = filesByName.find(filename);
+    if(file != filesByName.end()){
+      PrewarmEntry entry = {file->second, pageNo};
+      saved.push_back(std::make_pair(hotness, entry));
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(poolMutex);
+  std::uint32_t freeFrames = 0;
+  for (FrameId frameNo = 0; frameNo < numBufs; frameNo++) {
+    if(!bufDescTable[frameNo].valid){
+      freeFrames++;
+    }
+  }
+  if(saved.size() > freeFrames){
+    // Keep the hottest pages that fit
+    std::partial_sort(saved.begin(), saved.begin() + freeFrames, saved.end(),
+      [](const std::pair<std::uint32_t, PrewarmEntry>& a, const std::pair<std::uint32_t, PrewarmEntry>& b) {
+        return a.first > b.first;
+      });
+    saved.resize(freeFrames);
+  }
+  prewarmQueue.clear();
+  for (std::size_t i = 0; i < saved.size(); i++) {
+    prewarmQueue.push_back(saved[i].second);
+  }
+  std::sort(prewarmQueue.begin(), prewarmQueue.end(),
+    [](const PrewarmEntry& a, const PrewarmEntry& b) {
+      return a.file->id() < b.file->id() || (a.file->id() == b.file->id() && a.pageNo < b.pageNo);
+    });
+  prewarmRate = pagesPerSecond;
+  prewarmStop = false;
+  prewarmStats.clear();
+  prewarmStats.pages_queued = prewarmQueue.size();
+  if(!prewarmQueue.empty()){
+    prewarmStats.running = true;
+    prewarmThread = std::thread(&BufMgr::prewarm, this);
+  }
+  return prewarmStats.pages_queued;
+}
+
+void BufMgr::waitForPrewarm()
+{
+  if(prewarmThread.joinable()){
+    prewarmThread.join();
+  }
+}
+
+void BufMgr::stopPrewarm()
+{
+  {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    prewarmStop = true;
+  }
+  waitForPrewarm();
+}
+
+PrewarmStats BufMgr::getPrewarmStats() const
+{
+  std::lock_guard<std::mutex> lock(poolMutex);
+  return prewarmStats;
+}
+
+void BufMgr::prewarm()
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < prewarmQueue.size(); i++) {
+    File* file = prewarmQueue[i].file;
+    const PageId pageNo = prewarmQueue[i].pageNo;
+    FrameId frameNo;
+    {
+      std::lock_guard<std::mutex> lock(poolMutex);
+      if(prewarmStop){
+        break;
+      }
+      if(hashTable->lookup(file, pageNo, frameNo)){
+        prewarmStats.pages_skipped++;
+        continue;
+      }
+      if(!findFreeBuf(frameNo)){
+        // Foreground work has taken the remaining frames
+        prewarmStats.pages_skipped += prewarmQueue.size() - i;
+        break;
+      }
+      // Claim the frame: pinned so it cannot be evicted, loading so readers wait for it
+      bufDescTable[frameNo].Set(file, pageNo);
+      bufDescTable[frameNo].loading = true;
+      hashTable->insert(file, pageNo, frameNo);
+    }
+
+    // Read without the lock so foreground calls proceed meanwhile
+    bool loaded = false;
+    try {
+      file->readPageImage(pageNo, bufPool[frameNo]);
+      loaded = true;
+    } catch (const BadgerDbException&) {
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(poolMutex);
+      BufDesc& desc = bufDescTable[frameNo];
+      if(loaded && file->completePageRead(pageNo, bufPool[frameNo])){
+        desc.loading = false;
+        desc.pinCnt = 0;
+        // Not yet used, so first in line for eviction
+        desc.refbit = false;
+        desc.accessCount = 0;
+        prewarmStats.pages_loaded++;
+      }else{
+        hashTable->remove(file, pageNo);
+        desc.Clear();
+        prewarmStats.pages_skipped++;
+      }
+    }
+    ioDone.notify_all();
+
+    if(prewarmRate > 0){
+      const std::chrono::duration<double> due(double(i + 1) / prewarmRate);
+      std::this_thread::sleep_until(
+        start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(due));
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    prewarmStats.running = false;
+  }
+  ioDone.notify_all();
+}
+
 void BufMgr::printSelf(void) 
 {
+  std::lock_guard<std::mutex> lock(poolMutex);
   BufDesc* tmpbuf;
 	int validFrames = 0;
   
@@ -7,8 +7,17 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "file.h"
 #include "bufHashTbl.h"
+#include "page_cache_tier.h"
 
 namespace badgerdb {
 
@@ -26,9 +35,13 @@ class BufDesc {
 
  private:
 	/**
-   * Pointer to file to which corresponding frame is assigned
+   * Id of the open file the frame is assigned to; frames are looked up by
+   * this id, so every File object for the same file shares them.  No File
+   * pointer is kept, since the object that read the page in may be gone
+   * while others for the same file are still open; File::openById()
+   * reaches the file instead
 	 */
-  File* file;
+  FileId fileId;
 
 	/**
    * Page within file to which corresponding frame is assigned
@@ -60,17 +73,44 @@ class BufDesc {
 	 */
   bool refbit;
 
+	/**
+   * True while the prewarmer is reading the page into the frame; the frame is pinned meanwhile
+	 */
+  bool loading;
+
+	/**
+   * True while a checkpoint writes out a copy of the page without the pool lock; the frame may be pinned and
+   * modified meanwhile but is not evicted or dropped
+	 */
+  bool writing;
+
+	/**
+   * True if the page was unpinned dirty while <writing>, so the copy being written is already stale and the
+   * page stays dirty
+	 */
+  bool redirtied;
+
+	/**
+   * Number of times the page has been read through the buffer pool since it was brought in; saved as its
+   * hotness by BufMgr::saveWorkingSet()
+	 */
+  std::uint32_t accessCount;
+
 	/**
    * Initialize buffer frame for a new user
 	 */
   void Clear()
   {
     pinCnt = 0;
-	file = NULL;
+	fileId = 0;
 	pageNo = Page::INVALID_NUMBER;
     dirty = false;
     refbit = false;
 	valid = false;
+	loading = false;
+	writing = false;
+	redirtied = false;
+	accessCount = 0;
   };
 
 	/**
@@ -82,19 +122,24 @@ class BufDesc {
 	 */
   void Set(File* filePtr, PageId pageNum)
   { 
-	file = filePtr;
+	fileId = filePtr->id();
     pageNo = pageNum;
     pinCnt = 1;
     dirty = false;
     valid = true;
     refbit = true;
+    loading = false;
+    writing = false;
+    redirtied = false;
+    accessCount = 1;
   }
 
   void Print()
 	{
-		if(file)
+		if(valid)
 		{
-			std::cout << "file:" << file->filename() << " ";
+			std::cout << "file:" << File::openById(fileId).filename() << " ";
+			std::cout << "fileId:" << fileId << " ";
 			std::cout << "pageNo:" << pageNo << " ";
 		}
 		else
@@ -103,7 +148,9 @@ class BufDesc {
 		std::cout << "valid:" << valid << " ";
 		std::cout << "pinCnt:" << pinCnt << " ";
 		std::cout << "dirty:" << dirty << " ";
-		std::cout << "refbit:" << refbit << "\n";
+		std::cout << "refbit:" << refbit << " ";
+		std::cout << "loading:" << loading << " ";
+		std::cout << "writing:" << writing << "\n";
   }
 
 	/**
@@ -154,10 +201,133 @@ struct BufStats
 };
 
 
+/**
+* @brief Settings for checkpoints taken with BufMgr::flushAll()
+*/
+struct CheckpointPolicy
+{
+	/**
+   * Largest number of pages written per step; foreground work may run between steps
+	 */
+  std::uint32_t batch_pages;
+
+	/**
+   * Upper bound on the write rate of flushAll(), in pages per second (0 for no bound)
+	 */
+  std::uint32_t max_pages_per_second;
+
+	/**
+   * Constructor of CheckpointPolicy class: 2 MB steps, no rate bound
+	 */
+  CheckpointPolicy()
+		: batch_pages(256), max_pages_per_second(0)
+  {
+  }
+};
+
+/**
+* @brief What the last checkpoint did
+*/
+struct CheckpointStats
+{
+	/**
+   * Dirty pages found when the checkpoint began
+	 */
+  std::uint32_t pages_dirty;
+
+	/**
+   * Pages written by the checkpoint
+	 */
+  std::uint32_t pages_written;
+
+	/**
+   * Runs of adjacent pages written, each with a single vectored write
+	 */
+  std::uint32_t runs;
+
+	/**
+   * Dirty pages left for a later checkpoint because they were pinned when their turn came
+	 */
+  std::uint32_t pages_skipped;
+
+	/**
+   * Pages that were evicted, re-dirtied elsewhere or disposed of before their turn came
+	 */
+  std::uint32_t pages_gone;
+
+	/**
+   * Clear all values
+	 */
+  void clear()
+  {
+		pages_dirty = pages_written = runs = pages_skipped = pages_gone = 0;
+  }
+
+	/**
+   * Constructor of CheckpointStats class
+	 */
+  CheckpointStats()
+  {
+		clear();
+  }
+};
+
+/**
+* @brief Progress of the background prewarmer started by BufMgr::startPrewarm()
+*/
+struct PrewarmStats
+{
+	/**
+   * Pages queued for loading from the saved working set
+	 */
+  std::uint32_t pages_queued;
+
+	/**
+   * Pages read into the buffer pool
+	 */
+  std::uint32_t pages_loaded;
+
+	/**
+   * Queued pages not loaded: already resident, no longer in use, or no free frame left
+	 */
+  std::uint32_t pages_skipped;
+
+	/**
+   * True while the prewarmer is running
+	 */
+  bool running;
+
+	/**
+   * Clear all values
+	 */
+  void clear()
+  {
+		pages_queued = pages_loaded = pages_skipped = 0;
+		running = false;
+  }
+
+	/**
+   * Constructor of PrewarmStats class
+	 */
+  PrewarmStats()
+  {
+		clear();
+  }
+};
+
 /**
 * @brief The central class which manages the buffer pool including frame allocation and deallocation to pages in the file 
+*
+* Every public call holds the pool's lock for its duration, except for the writes of checkpointStep() and
+* the prewarmer's reads, which release it around the I/O; so a BufMgr may be shared with the background
+* prewarmer thread (see startPrewarm()) and checkpoints may run alongside foreground calls.  The I/O done
+* without the lock only reads or writes page images, and the metadata of files (allocation and offset maps)
+* is only ever touched with the lock held.  The File objects used with it must not be used concurrently by
+* other threads.  When a file is closed the pool writes out and drops its pages (see fileClosing()), so a
+* file opened later under the same FileId never sees them, and likewise when a file is compacted (see
+* fileCompacting()), so pages never show up under their old page numbers.
 */
-class BufMgr 
+class BufMgr : public FileCloseListener
 {
  private:
 	/**
@@ -198,6 +368,149 @@ class BufMgr
 	 */
   void allocBuf(FrameId & frame);
 
+	/**
+	 * readPage() with the pool lock already held through <lock>.  Waits, releasing the lock, for the prewarmer
+	 * to finish loading the page if it is loading it.
+	 */
+  void readPageLocked(std::unique_lock<std::mutex>& lock, File* file, const PageId PageNo, Page*& page);
+
+	/**
+	 * Waits, releasing the lock held through <lock>, until no frame of <file> is being loaded by the
+	 * prewarmer or written by a checkpoint.
+	 */
+  void waitForIo(std::unique_lock<std::mutex>& lock, const File* file);
+
+	/**
+	 * Finds a frame that holds no page, without evicting anything.  Called with the pool lock held.
+	 *
+	 * @param frame   	Frame ID of the free frame returned via this variable
+	 * @return  True if a free frame was found
+	 */
+  bool findFreeBuf(FrameId & frame);
+
+	/**
+	 * Collects the frames holding pages of <file>, and the pages of those that are dirty.  Called with the
+	 * pool lock held.
+	 *
+	 * @param file   	File whose frames to collect
+	 * @param frames  Receives the frames holding its pages
+	 * @param dirtyPages  Receives the dirty pages among them
+	 * @return  The first of the frames that is pinned, or numBufs if none is
+	 */
+  FrameId fileFrames(const File& file, std::vector<FrameId>& frames, std::vector<const Page*>& dirtyPages);
+
+	/**
+	 * Drops frames <frames> of <file>, which is being closed or compacted, together with its pages in the
+	 * cache tiers.  Called with the pool lock held.
+	 */
+  void dropFrames(File& file, const std::vector<FrameId>& frames);
+
+	/**
+	 * Ends a checkpoint's write of frames <frames>, of which the first <written> reached the file: those are
+	 * clean unless dirtied again during the write.  Called with the pool lock held.
+	 */
+  void finishWrites(const std::vector<FrameId>& frames, const std::size_t written);
+
+	/**
+	 * Body of the prewarmer thread: loads the pages of prewarmQueue in order.
+	 */
+  void prewarm();
+
+	/**
+	 * A page queued for the prewarmer
+	 */
+  struct PrewarmEntry
+	{
+		File* file;
+		PageId pageNo;
+	};
+
+	/**
+   * Guards all state of the buffer pool
+	 */
+  mutable std::mutex poolMutex;
+
+	/**
+   * Signalled whenever the prewarmer finishes loading a frame or a checkpoint finishes writing a batch
+	 */
+  std::condition_variable ioDone;
+
+	/**
+   * Pages for the prewarmer to load, sorted by (file, page)
+	 */
+  std::vector<PrewarmEntry> prewarmQueue;
+
+	/**
+   * Upper bound on the prewarmer's read rate, in pages per second (0 for no bound)
+	 */
+  std::uint32_t prewarmRate;
+
+	/**
+   * Set to ask the prewarmer to stop early
+	 */
+  bool prewarmStop;
+
+	/**
+   * Progress of the prewarmer
+	 */
+  PrewarmStats prewarmStats;
+
+	/**
+   * The prewarmer thread, if one was started
+	 */
+  std::thread prewarmThread;
+
+	/**
+   * Position of the next frame findFreeBuf() looks at
+	 */
+  FrameId freeHand;
+
+	/**
+   * Caches that evicted pages are offered to and misses are served from, in the order they are consulted
+	 */
+  std::vector<PageCacheTier*> cacheTiers;
+
+	/**
+	 * Reads a page that is not in the pool into frame <frameNo>, from the first cache tier that has it or
+	 * else from the file.  Called with the pool lock held.
+	 */
+  void fetchPage(File* file, const PageId pageNo, const FrameId frameNo);
+
+	/**
+	 * A dirty frame queued by the current checkpoint, together with the page it held at the time
+	 */
+  struct CheckpointEntry
+	{
+		FrameId frameNo;
+		FileId fileId;
+		PageId pageNo;
+	};
+
+	/**
+   * Dirty frames of the current checkpoint, sorted by (file, page)
+	 */
+  std::vector<CheckpointEntry> checkpointQueue;
+
+	/**
+   * Index in checkpointQueue of the next frame to write
+	 */
+  std::size_t checkpointPosition;
+
+	/**
+   * Ids of the files written by the current checkpoint, to be synced when it completes
+	 */
+  std::vector<FileId> checkpointFiles;
+
+	/**
+   * Settings for checkpoints
+	 */
+  CheckpointPolicy checkpointPolicy;
+
+	/**
+   * Statistics of the current or last checkpoint
+	 */
+  CheckpointStats checkpointStats;
+
  public:
 	/**
    * Actual buffer pool from which frames are allocated
@@ -246,7 +559,8 @@ class BufMgr
   void allocPage(File* file, PageId &PageNo, Page*& page); 
 
 	/**
-	 * Writes out all dirty pages of the file to disk.
+	 * Writes out all dirty pages of the file to disk, in page order, merging pages with adjacent
+	 * page numbers into a single vectored write.
 	 * All the frames assigned to the file need to be unpinned from buffer pool before this function can be successfully called.
 	 * Otherwise Error returned.
 	 *
@@ -256,6 +570,105 @@ class BufMgr
 	 */
   void flushFile(const File* file);
 
+	/**
+	 * Takes a checkpoint: writes out every dirty page of every file in the buffer pool and syncs the files.
+	 * Dirty frames are sorted by (file, page) and written as runs of adjacent pages, one vectored write per
+	 * run, in steps of CheckpointPolicy::batch_pages, pausing between steps to stay under
+	 * CheckpointPolicy::max_pages_per_second.  Pages pinned when their turn comes are left dirty for the
+	 * next checkpoint rather than waited for.
+	 *
+	 * Equivalent to beginCheckpoint() followed by checkpointStep() until it returns false.
+	 *
+	 * @return  What the checkpoint did
+	 */
+  const CheckpointStats& flushAll();
+
+	/**
+	 * Starts an incremental checkpoint by queueing every dirty frame, sorted by (file, page).  Nothing is
+	 * written yet, and frames stay available: they may be pinned, modified or evicted before the
+	 * checkpoint reaches them.  Abandons any checkpoint in progress.
+	 */
+  void beginCheckpoint();
+
+	/**
+	 * Writes the next batch of at most CheckpointPolicy::batch_pages queued pages, skipping frames that are
+	 * pinned or no longer hold the queued page.  Once the queue is exhausted, syncs every file written by the
+	 * checkpoint.  The batch is copied out under the pool lock and, for uncompressed files, written without
+	 * it, so foreground work runs during the write, even on the pages being written; a page dirtied again
+	 * meanwhile stays dirty.  Compressed files are written with the lock held, since placing their images
+	 * updates the file's offset map.  Frames being written are not evicted or disposed of until the write
+	 * completes.
+	 *
+	 * @return  True if queued pages remain
+	 */
+  bool checkpointStep();
+
+	/**
+   * Get settings for checkpoints
+	 */
+  const CheckpointPolicy& getCheckpointPolicy() const
+  {
+		return checkpointPolicy;
+  }
+
+	/**
+   * Change settings for checkpoints
+	 */
+  void setCheckpointPolicy(const CheckpointPolicy& policy)
+  {
+		checkpointPolicy = policy;
+  }
+
+	/**
+   * Get statistics of the current or last checkpoint
+	 */
+  const CheckpointStats& getCheckpointStats() const
+  {
+		return checkpointStats;
+  }
+
+	/**
+	 * Saves the working set -- the (file, page) of every page in the buffer pool, with how often it was read --
+	 * to a small text file, so that a later startPrewarm() can bring the same pages back.  The file is replaced
+	 * atomically, so this may be called periodically as well as on shutdown.
+	 *
+	 * @param path   	Name of the file to write
+	 * @throws IoException If the file could not be written
+	 */
+  void saveWorkingSet(const std::string& path) const;
+
+	/**
+	 * Starts a background thread that reads the pages of a working set saved by saveWorkingSet() into free
+	 * frames.  Pages of files not in <files> are ignored.  If the set holds more pages than there are free
+	 * frames, the most frequently read ones are kept; the chosen pages are then read in (file, page) order, at
+	 * most <pagesPerSecond> per second.  The prewarmer never evicts a page.  A readPage() for a page that is
+	 * being loaded waits for that load instead of reading the page again.  Stops any prewarmer already running.
+	 *
+	 * The files must stay open until the prewarmer has finished (see waitForPrewarm()).
+	 *
+	 * @param path   	Name of the file written by saveWorkingSet()
+	 * @param files   	Open files whose pages may be loaded
+	 * @param pagesPerSecond Upper bound on the read rate (0 for no bound)
+	 * @return  Number of pages queued for loading; 0 if <path> does not exist
+	 */
+  std::uint32_t startPrewarm(const std::string& path, const std::vector<File*>& files,
+                             const std::uint32_t pagesPerSecond = 0);
+
+	/**
+	 * Waits for the prewarmer, if any, to finish.
+	 */
+  void waitForPrewarm();
+
+	/**
+	 * Stops the prewarmer, if any, once it has finished the page it is loading.
+	 */
+  void stopPrewarm();
+
+	/**
+   * Get progress of the prewarmer
+	 */
+  PrewarmStats getPrewarmStats() const;
+
 	/**
 	 * Delete page from file and also from buffer pool if present.
 	 * Since the page is entirely deleted from file, its unnecessary to see if the page is dirty.
@@ -266,6 +679,36 @@ class BufMgr
   void disposePage(File* file, const PageId PageNo);
 
 	/**
+	 * Called by File when the last File object for a file closes it.  Writes out the file's dirty pages, drops
+	 * its frames and drops its pages from the cache tiers, since the file's id is about to be given to another
+	 * file.  None of the file's pages may be pinned: pinned pages are dropped all the same, since the file is
+	 * going away, but the caller is told.
+	 *
+	 * @param file   	File being closed
+	 * @throws  PagePinnedException If any page of the file was pinned
+	 */
+  void fileClosing(File& file);
+
+	/**
+	 * Called by File::compact() before it moves pages of <file>.  Writes out the file's dirty pages, then drops
+	 * its frames and its pages in the cache tiers, which are kept by page numbers that compaction is about to
+	 * give to other pages.  Nothing changes if a page of the file is pinned.
+	 *
+	 * @param file   	File being compacted
+	 * @throws  PagePinnedException If any page of the file is pinned
+	 */
+  void fileCompacting(File& file);
+
+	/**
+	 * Adds a cache tier below the buffer pool.  Clean pages evicted from the pool (and dirty ones, once written
+	 * back) are offered to every tier, and a page missing from the pool is looked up in the tiers, in the order
+	 * they were added, before it is read from its file.  The tier is not owned and must outlive the BufMgr.
+	 *
+	 * @param tier   	Cache tier to add
+	 */
+  void addCacheTier(PageCacheTier* tier);
+
+	/**
    * Print member variable values. 
 	 */
   void  printSelf();
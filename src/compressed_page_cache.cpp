@@ -0,0 +1,129 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "compressed_page_cache.h"
+
+#include <chrono>
+#include <cstring>
+
+#include "page_codec.h"
+
+namespace badgerdb {
+
+namespace {
+
+std::uint64_t elapsedNs(const std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+CompressedPageCache::CompressedPageCache(const std::size_t budget_bytes)
+    : budget_(budget_bytes) {
+  std::memset(&stats_, 0, sizeof(stats_));
+}
+
+void CompressedPageCache::store(const FileId file_id, const PageId page_number,
+                                const Page& page) {
+  const Key key = keyOf(file_id, page_number);
+  std::unordered_map<Key, Entry>::iterator existing = entries_.find(key);
+  if (existing != entries_.end()) {
+    erase(existing);
+  }
+
+  const char* image = reinterpret_cast<const char*>(&page);
+  char buffer[Page::SIZE];
+  const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  // Only worth keeping compressed if it saves something.
+  const std::size_t length =
+      PageCodec::compress(image, Page::SIZE, buffer, Page::SIZE - 1);
+  stats_.compress_ns += elapsedNs(start);
+
+  Entry entry;
+  entry.compressed = length > 0;
+  entry.data.assign(entry.compressed ? buffer : image,
+                    entry.compressed ? length : Page::SIZE);
+  if (entry.data.size() > budget_) {
+    return;
+  }
+  while (stats_.bytes + entry.data.size() > budget_) {
+    erase(entries_.find(lru_.back()));
+    ++stats_.evictions;
+  }
+  lru_.push_front(key);
+  stats_.bytes += entry.data.size();
+  ++stats_.pages;
+  ++stats_.stores;
+  Entry& stored = entries_[key];
+  stored.data.swap(entry.data);
+  stored.compressed = entry.compressed;
+  stored.lru_position = lru_.begin();
+}
+
+bool CompressedPageCache::fetch(const FileId file_id, const PageId page_number,
+                                Page& page) {
+  std::unordered_map<Key, Entry>::iterator it =
+      entries_.find(keyOf(file_id, page_number));
+  if (it == entries_.end()) {
+    ++stats_.misses;
+    return false;
+  }
+  char* image = reinterpret_cast<char*>(&page);
+  bool ok = true;
+  if (it->second.compressed) {
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    ok = PageCodec::decompress(it->second.data.data(), it->second.data.size(),
+                               image, Page::SIZE);
+    stats_.decompress_ns += elapsedNs(start);
+  } else {
+    std::memcpy(image, it->second.data.data(), Page::SIZE);
+  }
+  erase(it);
+  if (!ok) {
+    ++stats_.misses;
+    return false;
+  }
+  ++stats_.hits;
+  return true;
+}
+
+void CompressedPageCache::invalidate(const FileId file_id,
+                                     const PageId page_number) {
+  std::unordered_map<Key, Entry>::iterator it =
+      entries_.find(keyOf(file_id, page_number));
+  if (it != entries_.end()) {
+    erase(it);
+  }
+}
+
+void CompressedPageCache::invalidateFile(const FileId file_id) {
+  std::unordered_map<Key, Entry>::iterator it = entries_.begin();
+  while (it != entries_.end()) {
+    if (it->first >> 32 == file_id) {
+      erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
+double CompressedPageCache::hitRatio() const {
+  const std::uint64_t lookups = stats_.hits + stats_.misses;
+  return lookups == 0 ? 0 : double(stats_.hits) / lookups;
+}
+
+void CompressedPageCache::erase(std::unordered_map<Key, Entry>::iterator it) {
+  stats_.bytes -= it->second.data.size();
+  --stats_.pages;
+  lru_.erase(it->second.lru_position);
+  entries_.erase(it);
+}
+
+}
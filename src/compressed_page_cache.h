@@ -0,0 +1,166 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "page_cache_tier.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Counters of a CompressedPageCache.
+ */
+struct CompressedPageCacheStats {
+  /**
+   * Lookups that found their page.
+   */
+  std::uint64_t hits;
+
+  /**
+   * Lookups that did not.
+   */
+  std::uint64_t misses;
+
+  /**
+   * Pages stored.
+   */
+  std::uint64_t stores;
+
+  /**
+   * Pages dropped to stay within the byte budget.
+   */
+  std::uint64_t evictions;
+
+  /**
+   * Pages held right now.
+   */
+  std::size_t pages;
+
+  /**
+   * Bytes of compressed data held right now.
+   */
+  std::size_t bytes;
+
+  /**
+   * Total time spent compressing, in nanoseconds.
+   */
+  std::uint64_t compress_ns;
+
+  /**
+   * Total time spent decompressing hits, in nanoseconds.
+   */
+  std::uint64_t decompress_ns;
+};
+
+/**
+ * @brief Second-tier cache that keeps evicted pages compressed in memory.
+ *
+ * Pages are compressed with PageCodec and kept, least recently stored first
+ * out, within a fixed budget of bytes.  Pages that do not compress are kept
+ * as they are.  With typical pages compressing several times over, the tier
+ * holds many more pages than the same memory spent on buffer frames, at the
+ * cost of a decompression on every hit.
+ *
+ * @warning This class is not threadsafe; BufMgr calls it with its pool lock
+ * held.
+ */
+class CompressedPageCache : public PageCacheTier {
+ public:
+  /**
+   * Constructs an empty cache that holds at most <budget_bytes> of page data.
+   *
+   * @param budget_bytes  Memory budget, in bytes of stored data.
+   */
+  explicit CompressedPageCache(const std::size_t budget_bytes);
+
+  void store(const FileId file_id, const PageId page_number,
+             const Page& page);
+
+  bool fetch(const FileId file_id, const PageId page_number, Page& page);
+
+  void invalidate(const FileId file_id, const PageId page_number);
+
+  void invalidateFile(const FileId file_id);
+
+  /**
+   * Returns the memory budget, in bytes.
+   */
+  std::size_t budget() const { return budget_; }
+
+  /**
+   * Returns a snapshot of the cache's counters.
+   */
+  const CompressedPageCacheStats& stats() const { return stats_; }
+
+  /**
+   * Returns hits / (hits + misses), or 0 before the first lookup.
+   */
+  double hitRatio() const;
+
+ private:
+  /**
+   * Key of a page: its file id in the high half and page number in the low.
+   */
+  typedef std::uint64_t Key;
+
+  /**
+   * A stored page.
+   */
+  struct Entry {
+    /**
+     * Compressed page, or the raw page if <compressed> is false.
+     */
+    std::string data;
+
+    /**
+     * Whether <data> is compressed.
+     */
+    bool compressed;
+
+    /**
+     * Position in <lru_>.
+     */
+    std::list<Key>::iterator lru_position;
+  };
+
+  static Key keyOf(const FileId file_id, const PageId page_number) {
+    return (static_cast<Key>(file_id) << 32) | page_number;
+  }
+
+  /**
+   * Drops the entry at <it>.
+   */
+  void erase(std::unordered_map<Key, Entry>::iterator it);
+
+  /**
+   * Memory budget, in bytes.
+   */
+  std::size_t budget_;
+
+  /**
+   * Stored pages.
+   */
+  std::unordered_map<Key, Entry> entries_;
+
+  /**
+   * Keys of stored pages, most recently stored first.
+   */
+  std::list<Key> lru_;
+
+  /**
+   * Counters.
+   */
+  CompressedPageCacheStats stats_;
+};
+
+}
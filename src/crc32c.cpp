@@ -0,0 +1,217 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * The Castagnoli polynomial, bit-reversed.
+ */
+const std::uint32_t POLYNOMIAL = 0x82f63b78;
+
+/**
+ * Lookup tables for slicing-by-8: table[k][b] is the checksum contribution
+ * of byte b followed by k zero bytes.
+ */
+struct Tables {
+  std::uint32_t table[8][256];
+
+  Tables() {
+    for (std::uint32_t b = 0; b < 256; ++b) {
+      std::uint32_t crc = b;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc >> 1) ^ (POLYNOMIAL & (0 - (crc & 1)));
+      }
+      table[0][b] = crc;
+    }
+    for (std::uint32_t b = 0; b < 256; ++b) {
+      for (int k = 1; k < 8; ++k) {
+        table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xff];
+      }
+    }
+  }
+};
+
+const Tables& tables() {
+  static const Tables instance;
+  return instance;
+}
+
+std::uint32_t extendTables(std::uint32_t crc, const unsigned char* bytes,
+                           std::size_t length) {
+  const std::uint32_t (&t)[8][256] = tables().table;
+  while (length >= 8) {
+    std::uint32_t low;
+    std::uint32_t high;
+    std::memcpy(&low, bytes, 4);
+    std::memcpy(&high, bytes + 4, 4);
+    low ^= crc;
+    crc = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^
+        t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+        t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^
+        t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+    bytes += 8;
+    length -= 8;
+  }
+  while (length > 0) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *bytes) & 0xff];
+    ++bytes;
+    --length;
+  }
+  return crc;
+}
+
+/**
+ * Returns a * b modulo the polynomial, both in the bit-reversed
+ * representation.
+ */
+std::uint32_t multiplyModP(std::uint32_t a, std::uint32_t b) {
+  std::uint32_t product = 0;
+  for (std::uint32_t bit = 1u << 31; bit != 0; bit >>= 1) {
+    if (a & bit) {
+      product ^= b;
+    }
+    b = (b >> 1) ^ (POLYNOMIAL & (0 - (b & 1)));
+  }
+  return product;
+}
+
+/**
+ * Returns x^(8 * <length>) modulo the polynomial: the factor that appends
+ * <length> zero bytes to a checksum.
+ */
+std::uint32_t zerosOperator(std::size_t length) {
+  // x^1, squared once per bit of the exponent.
+  std::uint32_t square = 1u << 30;
+  std::uint32_t result = 1u << 31;
+  for (std::size_t exponent = length * 8; exponent != 0; exponent >>= 1) {
+    if (exponent & 1) {
+      result = multiplyModP(square, result);
+    }
+    square = multiplyModP(square, square);
+  }
+  return result;
+}
+
+#if defined(__x86_64__)
+
+/**
+ * Bytes per stream in the interleaved loops of extendSse42().  Three long
+ * blocks just fit in a page's data area, so a page is one round plus a few
+ * bytes.
+ */
+const std::size_t LONG_BLOCK = 2720;
+const std::size_t SHORT_BLOCK = 256;
+
+/**
+ * Runs three independent crc32 streams over consecutive <block>-byte runs
+ * and merges them; <shift> is zerosOperator(block).  The crc32 instruction
+ * has a latency of three cycles but can start one per cycle, so three
+ * streams keep it busy.
+ */
+__attribute__((target("sse4.2")))
+std::uint32_t extendThreeWay(std::uint32_t crc, const unsigned char* bytes,
+                             const std::size_t block,
+                             const std::uint32_t shift) {
+  std::uint64_t crc0 = crc;
+  std::uint64_t crc1 = 0;
+  std::uint64_t crc2 = 0;
+  for (std::size_t i = 0; i < block; i += 8) {
+    std::uint64_t word0;
+    std::uint64_t word1;
+    std::uint64_t word2;
+    std::memcpy(&word0, bytes + i, 8);
+    std::memcpy(&word1, bytes + block + i, 8);
+    std::memcpy(&word2, bytes + 2 * block + i, 8);
+    crc0 = _mm_crc32_u64(crc0, word0);
+    crc1 = _mm_crc32_u64(crc1, word1);
+    crc2 = _mm_crc32_u64(crc2, word2);
+  }
+  // crc(a . b) is crc(a) shifted past b's length, plus crc(b) from zero.
+  crc = multiplyModP(shift, static_cast<std::uint32_t>(crc0)) ^
+      static_cast<std::uint32_t>(crc1);
+  return multiplyModP(shift, crc) ^ static_cast<std::uint32_t>(crc2);
+}
+
+__attribute__((target("sse4.2")))
+std::uint32_t extendSse42(std::uint32_t crc, const unsigned char* bytes,
+                          std::size_t length) {
+  static const std::uint32_t long_shift = zerosOperator(LONG_BLOCK);
+  static const std::uint32_t short_shift = zerosOperator(SHORT_BLOCK);
+  while (length >= 3 * LONG_BLOCK) {
+    crc = extendThreeWay(crc, bytes, LONG_BLOCK, long_shift);
+    bytes += 3 * LONG_BLOCK;
+    length -= 3 * LONG_BLOCK;
+  }
+  while (length >= 3 * SHORT_BLOCK) {
+    crc = extendThreeWay(crc, bytes, SHORT_BLOCK, short_shift);
+    bytes += 3 * SHORT_BLOCK;
+    length -= 3 * SHORT_BLOCK;
+  }
+  std::uint64_t crc64 = crc;
+  while (length >= 8) {
+    std::uint64_t word;
+    std::memcpy(&word, bytes, 8);
+    crc64 = _mm_crc32_u64(crc64, word);
+    bytes += 8;
+    length -= 8;
+  }
+  crc = static_cast<std::uint32_t>(crc64);
+  while (length > 0) {
+    crc = _mm_crc32_u8(crc, *bytes);
+    ++bytes;
+    --length;
+  }
+  return crc;
+}
+
+#endif
+
+typedef std::uint32_t (*Kernel)(std::uint32_t, const unsigned char*,
+                                std::size_t);
+
+Kernel chooseKernel() {
+#if defined(__x86_64__)
+  if (__builtin_cpu_supports("sse4.2")) {
+    return extendSse42;
+  }
+#endif
+  return extendTables;
+}
+
+Kernel kernel() {
+  static const Kernel chosen = chooseKernel();
+  return chosen;
+}
+
+}
+
+std::uint32_t Crc32c::extend(const std::uint32_t crc, const void* data,
+                             const std::size_t length) {
+  return ~kernel()(~crc, static_cast<const unsigned char*>(data), length);
+}
+
+std::uint32_t Crc32c::extendPortable(const std::uint32_t crc,
+                                     const void* data,
+                                     const std::size_t length) {
+  return ~extendTables(~crc, static_cast<const unsigned char*>(data), length);
+}
+
+bool Crc32c::accelerated() {
+  return kernel() != extendTables;
+}
+
+}
@@ -0,0 +1,52 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace badgerdb {
+
+/**
+ * @brief CRC-32C (Castagnoli) checksums, as used for page checksums.
+ *
+ * On x86 processors with SSE4.2 the checksum is computed with the crc32
+ * instruction, eight bytes at a time; elsewhere a table-driven
+ * slicing-by-8 implementation is used.  The choice is made once, at run
+ * time, so binaries built for generic x86-64 still use the instruction
+ * where it exists.
+ */
+class Crc32c {
+ public:
+  /**
+   * Extends the checksum <crc> of some bytes to also cover the <length>
+   * bytes at <data>.  Pass 0 as <crc> to start a new checksum; the checksum
+   * of a concatenation can be computed piece by piece.
+   *
+   * @param crc     Checksum of the bytes before <data>.
+   * @param data    Bytes to add.
+   * @param length  Number of bytes at <data>.
+   * @return  Checksum of the bytes before <data> followed by <data>.
+   */
+  static std::uint32_t extend(const std::uint32_t crc, const void* data,
+                              const std::size_t length);
+
+  /**
+   * Same as extend(), but always uses the portable implementation.
+   */
+  static std::uint32_t extendPortable(const std::uint32_t crc,
+                                      const void* data,
+                                      const std::size_t length);
+
+  /**
+   * Returns whether extend() uses the crc32 instruction.
+   */
+  static bool accelerated();
+};
+
+}
@@ -0,0 +1,165 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "descriptor_cache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "exceptions/io_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Default limit for the shared cache: half of the process's soft descriptor
+ * limit, leaving the rest for sockets, logs and the like.
+ */
+std::size_t defaultCapacity() {
+  struct rlimit limit;
+  if (::getrlimit(RLIMIT_NOFILE, &limit) != 0 ||
+      limit.rlim_cur == RLIM_INFINITY) {
+    return 0;
+  }
+  return std::max<std::size_t>(limit.rlim_cur / 2, 16);
+}
+
+}
+
+DescriptorCache::Slot::Slot(const std::string& filename)
+    : filename_(filename),
+      fd_(-1),
+      pins_(0),
+      evicted_(false) {
+}
+
+DescriptorCache::Lease::Lease(Slot& slot)
+    : slot_(slot),
+      fd_(DescriptorCache::shared().pin(slot)) {
+}
+
+DescriptorCache::Lease::~Lease() {
+  DescriptorCache::shared().unpin(slot_);
+}
+
+DescriptorCache& DescriptorCache::shared() {
+  static DescriptorCache cache(defaultCapacity());
+  return cache;
+}
+
+DescriptorCache::DescriptorCache(const std::size_t capacity)
+    : capacity_(capacity) {
+  stats_.hits = 0;
+  stats_.misses = 0;
+  stats_.reopens = 0;
+  stats_.evictions = 0;
+  stats_.open_descriptors = 0;
+}
+
+void DescriptorCache::open(Slot& slot, const int flags) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  openLocked(slot, flags);
+}
+
+void DescriptorCache::close(Slot& slot) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (slot.fd_ < 0) {
+    return;
+  }
+  ::close(slot.fd_);
+  slot.fd_ = -1;
+  lru_.erase(slot.lru_position_);
+  --stats_.open_descriptors;
+}
+
+std::size_t DescriptorCache::capacity() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return capacity_;
+}
+
+void DescriptorCache::setCapacity(const std::size_t capacity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  capacity_ = capacity;
+  while (capacity_ > 0 && lru_.size() > capacity_ && evictOne()) {
+  }
+}
+
+DescriptorCacheStats DescriptorCache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void DescriptorCache::resetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.hits = 0;
+  stats_.misses = 0;
+  stats_.reopens = 0;
+  stats_.evictions = 0;
+}
+
+int DescriptorCache::pin(Slot& slot) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (slot.fd_ >= 0) {
+    ++stats_.hits;
+    lru_.splice(lru_.begin(), lru_, slot.lru_position_);
+  } else {
+    if (slot.evicted_) {
+      ++stats_.reopens;
+    }
+    openLocked(slot, O_RDWR | O_CLOEXEC);
+  }
+  ++slot.pins_;
+  return slot.fd_;
+}
+
+void DescriptorCache::unpin(Slot& slot) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  --slot.pins_;
+}
+
+void DescriptorCache::openLocked(Slot& slot, const int flags) {
+  ++stats_.misses;
+  while (capacity_ > 0 && lru_.size() >= capacity_ && evictOne()) {
+  }
+  int fd = ::open(slot.filename_.c_str(), flags, 0644);
+  if (fd < 0 && (errno == EMFILE || errno == ENFILE) && evictOne()) {
+    // Other descriptors in the process used up the limit; make room once.
+    fd = ::open(slot.filename_.c_str(), flags, 0644);
+  }
+  if (fd < 0) {
+    throw IoException(slot.filename_, "open", errno);
+  }
+  slot.fd_ = fd;
+  slot.evicted_ = false;
+  lru_.push_front(&slot);
+  slot.lru_position_ = lru_.begin();
+  ++stats_.open_descriptors;
+}
+
+bool DescriptorCache::evictOne() {
+  for (std::list<Slot*>::reverse_iterator it = lru_.rbegin();
+       it != lru_.rend(); ++it) {
+    Slot* victim = *it;
+    if (victim->pins_ > 0) {
+      continue;
+    }
+    ::close(victim->fd_);
+    victim->fd_ = -1;
+    victim->evicted_ = true;
+    lru_.erase(std::next(it).base());
+    ++stats_.evictions;
+    --stats_.open_descriptors;
+    return true;
+  }
+  return false;
+}
+
+}
@@ -0,0 +1,256 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+
+namespace badgerdb {
+
+/**
+ * @brief Counters describing how well the descriptor cache fits the workload.
+ */
+struct DescriptorCacheStats {
+  /**
+   * I/O calls that found their file's descriptor already open.
+   */
+  std::uint64_t hits;
+
+  /**
+   * I/O calls (and file opens) that had to open a descriptor.
+   */
+  std::uint64_t misses;
+
+  /**
+   * Misses that re-opened a descriptor the cache had earlier closed to stay
+   * under its limit.  A high count means the limit is too small for the set
+   * of files in active use.
+   */
+  std::uint64_t reopens;
+
+  /**
+   * Descriptors closed to stay under the limit.
+   */
+  std::uint64_t evictions;
+
+  /**
+   * Descriptors open right now.
+   */
+  std::size_t open_descriptors;
+};
+
+/**
+ * @brief Bounds the number of file descriptors held open by open files.
+ *
+ * Every FileHandle owns a Slot describing its descriptor.  A descriptor is
+ * only needed while a system call runs on it, so the cache keeps at most
+ * <capacity> of them open and closes the least recently used idle one when
+ * another must be opened.  The next I/O through the evicted slot re-opens
+ * the file transparently.  Closing a descriptor loses nothing: data written
+ * through it stays in the page cache, and a later fdatasync on a new
+ * descriptor for the same file covers it.  (One caveat: a writeback error
+ * the kernel hit before the re-open is not reported to the new descriptor,
+ * so callers that must see such errors should sync before going idle.)
+ *
+ * A descriptor is pinned (through a Lease) while in use, so it is never
+ * closed under a running system call; if every open descriptor is pinned the
+ * cache temporarily goes over its limit rather than block.
+ *
+ * This class is threadsafe.
+ */
+class DescriptorCache {
+ public:
+  /**
+   * @brief A file's entry in the cache.  Owned by the file's FileHandle.
+   */
+  class Slot {
+   public:
+    /**
+     * Constructs a slot for the named file with no descriptor open.
+     *
+     * @param filename  Name of the file; re-opens use this name.
+     */
+    explicit Slot(const std::string& filename);
+
+    /**
+     * Returns the name of the file.
+     */
+    const std::string& filename() const { return filename_; }
+
+   private:
+    friend class DescriptorCache;
+
+    /**
+     * Name of the file.
+     */
+    std::string filename_;
+
+    /**
+     * Open descriptor, or -1 if the file has none right now.
+     */
+    int fd_;
+
+    /**
+     * Number of leases currently using <fd_>.
+     */
+    int pins_;
+
+    /**
+     * Whether the cache closed <fd_> to stay under its limit.
+     */
+    bool evicted_;
+
+    /**
+     * Position in the cache's recency list; valid while <fd_> is open.
+     */
+    std::list<Slot*>::iterator lru_position_;
+  };
+
+  /**
+   * @brief Keeps a slot's descriptor open for the lifetime of the lease.
+   */
+  class Lease {
+   public:
+    /**
+     * Pins <slot>'s descriptor in the shared cache, opening it if needed.
+     *
+     * @throws  IoException   If the file could not be re-opened.
+     */
+    explicit Lease(Slot& slot);
+
+    /**
+     * Unpins the descriptor.
+     */
+    ~Lease();
+
+    /**
+     * Returns the pinned descriptor.
+     */
+    int fd() const { return fd_; }
+
+   private:
+    Slot& slot_;
+    int fd_;
+
+    Lease(const Lease&);
+    Lease& operator=(const Lease&);
+  };
+
+  /**
+   * Returns the cache shared by every open file.
+   */
+  static DescriptorCache& shared();
+
+  /**
+   * Constructs a cache holding at most <capacity> descriptors.
+   *
+   * @param capacity  Maximum number of open descriptors (0 for no limit).
+   */
+  explicit DescriptorCache(const std::size_t capacity);
+
+  /**
+   * Opens <slot>'s file with the given open(2) flags and adds its descriptor
+   * to the cache, evicting an idle descriptor if the cache is full.  Later
+   * re-opens drop O_CREAT, O_EXCL and O_TRUNC.
+   *
+   * @param slot    Slot with no descriptor open.
+   * @param flags   Flags for open(2).
+   * @throws  IoException   If the file could not be opened.
+   */
+  void open(Slot& slot, const int flags);
+
+  /**
+   * Closes <slot>'s descriptor, if it has one, and forgets the slot.  The
+   * slot must not be pinned.
+   *
+   * @param slot  Slot to close.
+   */
+  void close(Slot& slot);
+
+  /**
+   * Returns the maximum number of open descriptors (0 for no limit).
+   */
+  std::size_t capacity() const;
+
+  /**
+   * Changes the maximum number of open descriptors, closing idle ones at
+   * once if there are now too many.
+   *
+   * @param capacity  Maximum number of open descriptors (0 for no limit).
+   */
+  void setCapacity(const std::size_t capacity);
+
+  /**
+   * Returns a snapshot of the cache's counters.
+   */
+  DescriptorCacheStats stats() const;
+
+  /**
+   * Zeroes the hit, miss, reopen and eviction counters.
+   */
+  void resetStats();
+
+ private:
+  /**
+   * Pins <slot>'s descriptor, re-opening it if it was evicted.
+   *
+   * @return  The descriptor.
+   * @throws  IoException   If the file could not be re-opened.
+   */
+  int pin(Slot& slot);
+
+  /**
+   * Releases one pin on <slot>'s descriptor.
+   */
+  void unpin(Slot& slot);
+
+  /**
+   * Opens <slot>'s file with <flags>, evicting idle descriptors first if the
+   * cache is full, and once more if the process has run out of descriptors.
+   * Called with <mutex_> held.
+   *
+   * @throws  IoException   If the file could not be opened.
+   */
+  void openLocked(Slot& slot, const int flags);
+
+  /**
+   * Closes the least recently used idle descriptor.  Called with <mutex_>
+   * held.
+   *
+   * @return  False if every open descriptor is pinned.
+   */
+  bool evictOne();
+
+  /**
+   * Guards everything below.
+   */
+  mutable std::mutex mutex_;
+
+  /**
+   * Maximum number of open descriptors (0 for no limit).
+   */
+  std::size_t capacity_;
+
+  /**
+   * Slots with an open descriptor, most recently used first.
+   */
+  std::list<Slot*> lru_;
+
+  /**
+   * Counters reported by stats().
+   */
+  DescriptorCacheStats stats_;
+
+  DescriptorCache(const DescriptorCache&);
+  DescriptorCache& operator=(const DescriptorCache&);
+};
+
+}
@@ -0,0 +1,31 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a RecordPredicate is built with
+ *        arguments no record could be tested against, such as an empty
+ *        pattern or a range whose low end is above its high end.
+ */
+class InvalidPredicateException : public BadgerDbException {
+ public:
+  /**
+   * Constructs an invalid predicate exception.
+   *
+   * @param reason  What is wrong with the predicate's arguments.
+   */
+  explicit InvalidPredicateException(const std::string& reason);
+};
+
+}
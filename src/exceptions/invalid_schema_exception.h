@@ -0,0 +1,31 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a PaxSchema is built from columns
+ *        no page could be laid out for, such as no columns at all or a
+ *        column of width 0.
+ */
+class InvalidSchemaException : public BadgerDbException {
+ public:
+  /**
+   * Constructs an invalid schema exception.
+   *
+   * @param reason  What is wrong with the schema's columns.
+   */
+  explicit InvalidSchemaException(const std::string& reason);
+};
+
+}
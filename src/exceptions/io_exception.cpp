@@ -0,0 +1,25 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "io_exception.h"
+
+#include <cstring>
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+IoException::IoException(const std::string& name, const std::string& operation,
+                         const int error_code)
+    : BadgerDbException(""), filename_(name), error_code_(error_code) {
+  std::stringstream ss;
+  ss << "I/O error during " << operation << " on file " << filename_ << ": "
+     << std::strerror(error_code_);
+  message_.assign(ss.str());
+}
+
+}
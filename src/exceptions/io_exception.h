@@ -0,0 +1,54 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a system call on an open file
+ *        (read, write, sync, ...) fails.
+ */
+class IoException : public BadgerDbException {
+ public:
+  /**
+   * Constructs an I/O exception for the given file.
+   *
+   * @param name        Name of file the operation was performed on.
+   * @param operation   Name of the operation that failed.
+   * @param error_code  Value of errno reported by the failed call.
+   */
+  explicit IoException(const std::string& name, const std::string& operation,
+                       const int error_code);
+
+  /**
+   * Returns the name of the file that caused this exception.
+   */
+  virtual const std::string& filename() const { return filename_; }
+
+  /**
+   * Returns the errno value reported by the failed call.
+   */
+  int error_code() const { return error_code_; }
+
+ protected:
+  /**
+   * Name of file that caused this exception.
+   */
+  const std::string filename_;
+
+  /**
+   * Value of errno reported by the failed call.
+   */
+  const int error_code_;
+};
+
+}
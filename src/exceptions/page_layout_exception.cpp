@@ -0,0 +1,24 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "page_layout_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+PageLayoutException::PageLayoutException(const PageId page_num)
+    : BadgerDbException(""),
+      page_number_(page_num) {
+  std::stringstream ss;
+  ss << "Page " << page_number_
+     << " is not laid out the way the view accessing it expects.";
+  message_.assign(ss.str());
+}
+
+}
@@ -0,0 +1,43 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a page is accessed through a view
+ *        of a different layout than the page has, such as a PaxPage over a
+ *        page of other columns or a FixedPage over a PaxPage.
+ */
+class PageLayoutException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a page layout exception for the given page.
+   *
+   * @param page_num    Number of page accessed.
+   */
+  explicit PageLayoutException(const PageId page_num);
+
+  /**
+   * Returns the page number of the page that caused this exception.
+   */
+  PageId page_number() const { return page_number_; }
+
+ protected:
+  /**
+   * Page number of the page that caused this exception.
+   */
+  const PageId page_number_;
+};
+
+}
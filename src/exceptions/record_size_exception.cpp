@@ -0,0 +1,33 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "record_size_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+RecordSizeException::RecordSizeException(const PageId page_num,
+                                         const std::size_t expected,
+                                         const std::size_t actual)
+    : BadgerDbException(""),
+      page_number_(page_num),
+      expected_size_(expected),
+      actual_size_(actual) {
+  std::stringstream ss;
+  ss << "Page " << page_number_ << " accessed as holding " << expected_size_
+     << "-byte records, but it holds ";
+  if (actual_size_ == 0) {
+    ss << "variable-length records.";
+  } else {
+    ss << actual_size_ << "-byte records.";
+  }
+  message_.assign(ss.str());
+}
+
+}
@@ -0,0 +1,67 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a page is accessed as holding
+ *        fixed-length records of a size other than the one it holds.
+ */
+class RecordSizeException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a record size exception for the given page.
+   *
+   * @param page_num    Number of page accessed.
+   * @param expected    Record size the page was accessed with.
+   * @param actual      Record size of the page's records, or 0 if the page
+   *                    holds variable-length records.
+   */
+  RecordSizeException(const PageId page_num, const std::size_t expected,
+                      const std::size_t actual);
+
+  /**
+   * Returns the page number of the page that caused this exception.
+   */
+  PageId page_number() const { return page_number_; }
+
+  /**
+   * Returns the record size the page was accessed with.
+   */
+  std::size_t expected_size() const { return expected_size_; }
+
+  /**
+   * Returns the record size of the page's records, or 0 if the page holds
+   * variable-length records.
+   */
+  std::size_t actual_size() const { return actual_size_; }
+
+ protected:
+  /**
+   * Page number of the page that caused this exception.
+   */
+  const PageId page_number_;
+
+  /**
+   * Record size the page was accessed with.
+   */
+  const std::size_t expected_size_;
+
+  /**
+   * Record size of the page's records.
+   */
+  const std::size_t actual_size_;
+};
+
+}
@@ -11,27 +11,74 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
 #include <cstdio>
 #include <cassert>
+#include <cstddef>
+#include <cstring>
 
+#include "crc32c.h"
+#include "exceptions/badgerdb_exception.h"
+#include "exceptions/corrupt_page_exception.h"
 #include "exceptions/file_exists_exception.h"
 #include "exceptions/file_not_found_exception.h"
 #include "exceptions/file_open_exception.h"
 #include "exceptions/invalid_page_exception.h"
+#include "exceptions/io_exception.h"
 #include "file_iterator.h"
 #include "page.h"
+#include "page_codec.h"
 
 namespace badgerdb {
 
-File::StreamMap File::open_streams_;
-File::CountMap File::open_counts_;
+namespace {
 
-File File::create(const std::string& filename) {
-  return File(filename, true /* create_new */);
+/**
+ * Header of files written before the on-disk format was versioned.  In that
+ * layout page n starts at sizeof(LegacyFileHeader) + (n - 1) * Page::SIZE.
+ */
+struct LegacyFileHeader {
+  PageId num_pages;
+  PageId first_used_page;
+  PageId num_free_pages;
+  PageId first_free_page;
+};
+
+}
+
+const std::uint32_t File::MAGIC;
+const std::uint32_t File::FORMAT_VERSION;
+const std::uint32_t File::FLAG_CHECKSUMS;
+const std::uint32_t File::FLAG_COMPRESSED;
+const std::uint32_t File::FLAG_COLUMNAR;
+const std::uint64_t File::COMPRESSED_GROUP_BYTES;
+const std::size_t File::MOVE_BATCH_BYTES;
+
+RecordId forwardRecordId(const PageForwardingMap& forwarding,
+                         const RecordId& record_id) {
+  const PageForwardingMap::const_iterator moved =
+      forwarding.find(record_id.page_number);
+  if (moved == forwarding.end()) {
+    return record_id;
+  }
+  const RecordId forwarded = {moved->second, record_id.slot_number};
+  return forwarded;
+}
+
+FileRegistry File::registry_;
+std::vector<FileCloseListener*> File::close_listeners_;
+
+File File::create(const std::string& filename, const bool compressed,
+                  const std::size_t record_size, const bool columnar) {
+  return File(filename, true /* create_new */, compressed, record_size,
+              columnar);
 }
 
 File File::open(const std::string& filename) {
-  return File(filename, false /* create_new */);
+  return File(filename, false /* create_new */, false /* compressed */,
+              0 /* record_size */, false /* columnar */);
 }
 
 void File::remove(const std::string& filename) {
@@ -48,7 +95,8 @@ bool File::isOpen(const std::string& filename) {
   if (!exists(filename)) {
     return false;
   }
-  return open_counts_.find(filename) != open_counts_.end();
+  FileId file_id;
+  return registry_.find(filename, file_id);
 }
 
 bool File::exists(const std::string& filename) {
@@ -62,244 +110,954 @@ bool File::exists(const std::string& filename) {
 	return false;
 }
 
+void File::setDescriptorLimit(const std::size_t max_descriptors) {
+  DescriptorCache::shared().setCapacity(max_descriptors);
+}
+
+std::size_t File::descriptorLimit() {
+  return DescriptorCache::shared().capacity();
+}
+
+DescriptorCacheStats File::descriptorStats() {
+  return DescriptorCache::shared().stats();
+}
+
+void File::addCloseListener(FileCloseListener* listener) {
+  close_listeners_.push_back(listener);
+}
+
+void File::removeCloseListener(FileCloseListener* listener) {
+  close_listeners_.erase(std::remove(close_listeners_.begin(),
+                                     close_listeners_.end(), listener),
+                         close_listeners_.end());
+}
+
+File File::openById(const FileId file_id) {
+  if (file_id >= registry_.idLimit() || !registry_.handle(file_id)) {
+    throw FileNotFoundException("file id " + std::to_string(file_id));
+  }
+  return File(file_id);
+}
+
+File::File(const FileId file_id)
+  : file_id_(file_id),
+    handle_(registry_.handle(file_id)) {
+  registry_.acquire(file_id_);
+}
+
 File::File(const File& other)
-  : filename_(other.filename_),
-    stream_(open_streams_[filename_]) {
-  ++open_counts_[filename_];
+  : file_id_(other.file_id_),
+    handle_(other.handle_) {
+  registry_.acquire(file_id_);
 }
 
 File& File::operator=(const File& rhs) {
-  // This accounts for self-assignment and assignment of a File object for the
-  // same file.
-  close();	//close my file and associate me with the new one
-  filename_ = rhs.filename_;
-  openIfNeeded(false /* create_new */);
+  // Take the new reference before dropping the old one; this accounts for
+  // self-assignment and assignment of a File object for the same file.
+  registry_.acquire(rhs.file_id_);
+  const std::shared_ptr<FileHandle> handle = rhs.handle_;
+  const FileId file_id = rhs.file_id_;
+  try {
+    close();	//close my file and associate me with the new one
+  } catch (...) {
+    // The old file is closed regardless; keep the reference just taken.
+    file_id_ = file_id;
+    handle_ = handle;
+    throw;
+  }
+  file_id_ = file_id;
+  handle_ = handle;
   return *this;
 }
 
 File::~File() {
-  close();
+  try {
+    close();
+  } catch (const BadgerDbException&) {
+    // The file is closed regardless; see the declaration.
+  }
 }
 
 Page File::allocatePage() {
   FileHeader header = readHeader();
-  Page new_page;
-  Page existing_page;
+  AllocationMap& allocation_map = handle_->allocationMap();
+  PageId page_number;
   if (header.num_free_pages > 0) {
-    new_page = readPage(header.first_free_page, true /* allow_free */);
-    new_page.set_page_number(header.first_free_page);
-    header.first_free_page = new_page.next_page_number();
+    // first_free_page is always the lowest free page, so the next one can
+    // only be after it.
+    page_number = header.first_free_page;
     --header.num_free_pages;
-
-    if (header.first_used_page == Page::INVALID_NUMBER ||
-        header.first_used_page > new_page.page_number()) {
-      // Either have no pages used or the head of the used list is a page later
-      // than the one we just allocated, so add the new page to the head.
-      if (header.first_used_page > new_page.page_number()) {
-        new_page.set_next_page_number(header.first_used_page);
-      }
-      header.first_used_page = new_page.page_number();
-    } else {
-      // New page is reused from somewhere after the beginning, so we need to
-      // find where in the used list to insert it.
-      PageId next_page_number = Page::INVALID_NUMBER;
-      for (FileIterator iter = begin(); iter != end(); ++iter) {
-        next_page_number = (*iter).next_page_number();
-        if (next_page_number > new_page.page_number() ||
-            next_page_number == Page::INVALID_NUMBER) {
-          existing_page = *iter;
-          break;
-        }
-      }
-      existing_page.set_next_page_number(new_page.page_number());
-      new_page.set_next_page_number(next_page_number);
-    }
-
+    allocation_map.markUsed(page_number);
+    header.first_free_page = header.num_free_pages > 0
+        ? allocation_map.nextFree(page_number + 1)
+        : Page::INVALID_NUMBER;
     assert((header.num_free_pages == 0) ==
            (header.first_free_page == Page::INVALID_NUMBER));
   } else {
-    new_page.set_page_number(header.num_pages);
-    if (header.first_used_page == Page::INVALID_NUMBER) {
-      header.first_used_page = new_page.page_number();
+    page_number = header.num_pages;
+    ++header.num_pages;
+    if (compressed()) {
+      handle_->offsetMap().resize(header.num_pages);
     } else {
-      // If we have pages allocated, we need to add the new page to the tail
-      // of the linked list.
-      for (FileIterator iter = begin(); iter != end(); ++iter) {
-        if ((*iter).next_page_number() == Page::INVALID_NUMBER) {
-          existing_page = *iter;
-          break;
-        }
-      }
-      assert(existing_page.isUsed());
-      existing_page.set_next_page_number(new_page.page_number());
+      // Appending usually lands inside the extent reserved by an earlier
+      // growth step, in which case this makes no system call.
+      handle_->reserve(pagePosition(page_number) + Page::SIZE);
     }
-    ++header.num_pages;
+    allocation_map.resize(header.num_pages);
+    allocation_map.markUsed(page_number);
   }
-  writePage(new_page.page_number(), new_page);
-  if (existing_page.page_number() != Page::INVALID_NUMBER) {
-    // If we updated an existing page by inserting the new page into the
-    // used list, we need to write it out.
-    writePage(existing_page.page_number(), existing_page);
+  if (header.first_used_page == Page::INVALID_NUMBER ||
+      header.first_used_page > page_number) {
+    header.first_used_page = page_number;
   }
+
+  Page new_page;
+  new_page.set_page_number(page_number);
+  writePage(page_number, new_page);
+  writeAllocationWord(page_number);
   writeHeader(header);
+  handle_->commit();
 
+  new_page.set_next_page_number(nextUsedPage(page_number));
   return new_page;
 }
 
 Page File::readPage(const PageId page_number) const {
-  FileHeader header = readHeader();
-  if (page_number >= header.num_pages) {
-    throw InvalidPageException(page_number, filename_);
+  if (!handle_->allocationMap().isUsed(page_number)) {
+    throw InvalidPageException(page_number, filename());
   }
   return readPage(page_number, false /* allow_free */);
 }
 
 Page File::readPage(const PageId page_number, const bool allow_free) const {
-  Page page;
-  stream_->seekg(pagePosition(page_number), std::ios::beg);
-  stream_->read(reinterpret_cast<char*>(&page.header_), sizeof(page.header_));
-  stream_->read(reinterpret_cast<char*>(&page.data_[0]), Page::DATA_SIZE);
+  Page page(Page::Uninitialized{});
+  readImage(page_number, page);
+  verifyPage(page_number, page, readHeader().flags);
   if (!allow_free && !page.isUsed()) {
-    throw InvalidPageException(page_number, filename_);
+    throw InvalidPageException(page_number, filename());
   }
+  // The used list is kept in the allocation bitmap rather than on the pages,
+  // so fill in the page's successor from there.
+  page.set_next_page_number(nextUsedPage(page_number));
 
   return page;
 }
 
 void File::writePage(const Page& new_page) {
-  PageHeader header = readPageHeader(new_page.page_number());
-  if (header.current_page_number == Page::INVALID_NUMBER) {
+  if (!handle_->allocationMap().isUsed(new_page.page_number())) {
     // Page has been deleted since it was read.
-    throw InvalidPageException(new_page.page_number(), filename_);
+    throw InvalidPageException(new_page.page_number(), filename());
+  }
+  writePage(new_page.page_number(), new_page);
+  handle_->commit();
+}
+
+void File::readPages(const PageId first_page, const PageId count,
+                     Page* pages) const {
+  const AllocationMap& allocation_map = handle_->allocationMap();
+  for (PageId i = 0; i < count; ++i) {
+    if (!allocation_map.isUsed(first_page + i)) {
+      throw InvalidPageException(first_page + i, filename());
+    }
+  }
+  if (compressed()) {
+    readCompressedRun(first_page, count, pages);
+  }
+  std::vector<struct iovec> buffers;
+  PageId done = compressed() ? count : 0;
+  while (done < count) {
+    // A bitmap page sits between groups, so runs end at group boundaries.
+    const PageId run_start = first_page + done;
+    const PageId group_end = static_cast<PageId>(
+        (AllocationMap::groupOf(run_start) + 1) * AllocationMap::PAGES_PER_GROUP);
+    const PageId run_length = std::min<PageId>(count - done,
+                                               group_end - run_start + 1);
+    buffers.resize(2 * run_length);
+    for (PageId i = 0; i < run_length; ++i) {
+      Page& page = pages[done + i];
+      buffers[2 * i].iov_base = &page.header_;
+      buffers[2 * i].iov_len = sizeof(page.header_);
+      buffers[2 * i + 1].iov_base = page.data_;
+      buffers[2 * i + 1].iov_len = Page::DATA_SIZE;
+    }
+    handle_->readVector(pagePosition(run_start), &buffers[0], buffers.size());
+    done += run_length;
+  }
+  const std::uint32_t flags = readHeader().flags;
+  for (PageId i = 0; i < count; ++i) {
+    verifyPage(first_page + i, pages[i], flags);
+    if (!pages[i].isUsed()) {
+      throw InvalidPageException(first_page + i, filename());
+    }
+    pages[i].set_next_page_number(nextUsedPage(first_page + i));
+  }
+}
+
+void File::readPageImage(const PageId page_number, Page& page) const {
+  // Go by one copy of the flags, since the header may be replaced meanwhile.
+  const std::uint32_t flags = readHeader().flags;
+  if ((flags & FLAG_COMPRESSED) != 0) {
+    // Take the extent from disk, since the in-memory map may be changing.
+    PageExtent extent;
+    handle_->read(extentPosition(page_number), &extent, sizeof(extent));
+    readCompressed(page_number, extent, page);
+  } else {
+    readImage(page_number, page);
+  }
+  verifyPage(page_number, page, flags);
+}
+
+bool File::completePageRead(const PageId page_number, Page& page) const {
+  if (!handle_->allocationMap().isUsed(page_number) || !page.isUsed()) {
+    return false;
   }
-  // Page on disk may have had its next page pointer updated since it was read;
-  // we don't modify that, but we do keep all the other modifications to the
-  // page header.
-  const PageId next_page_number = header.next_page_number;
-  header = new_page.header_;
-  header.next_page_number = next_page_number;
-  writePage(new_page.page_number(), header, new_page);
+  page.set_next_page_number(nextUsedPage(page_number));
+  return true;
+}
+
+void File::writePages(const std::vector<const Page*>& pages) {
+  checkPagesUsed(pages);
+  writeRuns(pages);
+  handle_->commit();
+}
+
+void File::checkPagesUsed(const std::vector<const Page*>& pages) const {
+  const AllocationMap& allocation_map = handle_->allocationMap();
+  for (std::size_t i = 0; i < pages.size(); ++i) {
+    if (!allocation_map.isUsed(pages[i]->page_number())) {
+      // Page has been deleted since it was read.
+      throw InvalidPageException(pages[i]->page_number(), filename());
+    }
+  }
+}
+
+void File::writePageImages(const std::vector<const Page*>& pages) {
+  // Uncompressed images go to fixed positions, so nothing in memory changes.
+  writeRuns(pages);
+  handle_->commit();
 }
 
 void File::deletePage(const PageId page_number) {
   FileHeader header = readHeader();
-  Page existing_page = readPage(page_number);
-  Page previous_page;
-  // If this page is the head of the used list, update the header to point to
-  // the next page in line.
+  AllocationMap& allocation_map = handle_->allocationMap();
+  if (!allocation_map.isUsed(page_number)) {
+    throw InvalidPageException(page_number, filename());
+  }
+  allocation_map.markFree(page_number);
+  writeAllocationWord(page_number);
+
   if (page_number == header.first_used_page) {
-    header.first_used_page = existing_page.next_page_number();
+    header.first_used_page = nextUsedPage(page_number);
+  }
+  if (header.first_free_page == Page::INVALID_NUMBER ||
+      header.first_free_page > page_number) {
+    header.first_free_page = page_number;
+  }
+  ++header.num_free_pages;
+
+  if (compressed()) {
+    // Drop the image; a page without one reads back as a free page.
+    const PageExtent empty = {0 /* offset */, 0 /* length */,
+                              0 /* reserved */};
+    handle_->offsetMap().setExtent(page_number, empty);
+    writeExtents(page_number, 1);
+  } else if (!handle_->punchHoles() ||
+             !handle_->punchHole(pagePosition(page_number), Page::SIZE)) {
+    // Clear the page so that stale contents are never mistaken for a used
+    // page.  A punched hole reads back as zeros, which is a free page header
+    // too.
+    Page free_page;
+    writePage(page_number, free_page);
+  }
+  writeHeader(header);
+  handle_->commit();
+}
+
+ReclaimStats File::reclaimSpace() {
+  ReclaimStats stats = {0 /* pages_truncated */, 0 /* pages_punched */,
+                        0 /* bytes_reclaimed */};
+  const std::uint64_t disk_usage_before = handle_->diskUsage();
+  FileHeader header = readHeader();
+  AllocationMap& allocation_map = handle_->allocationMap();
+
+  // Drop the free pages after the last used one.
+  const PageId last_used = allocation_map.lastUsed();
+  const PageId num_pages = last_used + 1;
+  if (num_pages < header.num_pages) {
+    stats.pages_truncated = header.num_pages - num_pages;
+    header.num_free_pages -= stats.pages_truncated;
+    header.num_pages = num_pages;
+    if (header.num_free_pages == 0) {
+      header.first_free_page = Page::INVALID_NUMBER;
+    }
+    allocation_map.resize(num_pages);
+    writeHeader(header);
+    if (compressed()) {
+      // Free pages hold no images, so there is nothing to cut off.
+      handle_->offsetMap().resize(num_pages);
+    } else {
+      handle_->truncate(last_used == Page::INVALID_NUMBER
+                        ? Page::SIZE
+                        : pagePosition(last_used) + Page::SIZE);
+    }
+  }
+
+  if (compressed()) {
+    // Free pages take no space either; what can be reclaimed is the space
+    // of images left behind by rewrites and deletes.  Copying a group's
+    // live images to its other half leaves that garbage behind in the half
+    // that is released, so it pays once there is more garbage than live
+    // data to copy.
+    PageOffsetMap& offset_map = handle_->offsetMap();
+    for (std::uint32_t group = 0; group < offset_map.numGroups(); ++group) {
+      const std::uint64_t live = offset_map.liveBytes(group);
+      if (offset_map.usedBytes(group) - live > live) {
+        moveImages(group, PageOffsetMap::HALF_BYTES -
+                          PageOffsetMap::halfStart(offset_map.cursor(group)));
+      }
+    }
   } else {
-    // Walk the used list so we can update the page that points to this one.
-    for (FileIterator iter = begin(); iter != end(); ++iter) {
-      previous_page = *iter;
-      if (previous_page.next_page_number() == existing_page.page_number()) {
-        previous_page.set_next_page_number(existing_page.next_page_number());
-        break;
+    // Punch holes over the remaining runs of free pages.  A run is only
+    // physically contiguous up to the end of its group, since the next group
+    // starts with its bitmap page.  Parts of a run that are holes already
+    // (from an earlier call, or deletePage() punching) are skipped, so only
+    // pages that still hold blocks are punched and counted.
+    PageId run_start = allocation_map.nextFree(1);
+    bool punched = true;
+    while (punched && run_start != Page::INVALID_NUMBER) {
+      PageId run_end = allocation_map.nextUsed(run_start);
+      const PageId group_end =
+          (AllocationMap::groupOf(run_start) + 1) *
+          AllocationMap::PAGES_PER_GROUP + 1;
+      if (run_end == Page::INVALID_NUMBER || run_end > group_end) {
+        run_end = std::min(group_end, header.num_pages);
+      }
+      const std::uint64_t run_position = pagePosition(run_start);
+      const std::uint64_t run_limit =
+          run_position + std::uint64_t(run_end - run_start) * Page::SIZE;
+      std::uint64_t data = handle_->nextData(run_position, run_limit);
+      while (data < run_limit) {
+        // Widen the backed bytes to the whole pages they fall in.
+        const PageId first = (data - run_position) / Page::SIZE;
+        const PageId last =
+            (handle_->nextHole(data, run_limit) - run_position +
+             Page::SIZE - 1) / Page::SIZE;
+        if (!handle_->punchHole(run_position + std::uint64_t(first) *
+                                Page::SIZE,
+                                std::uint64_t(last - first) * Page::SIZE)) {
+          punched = false;
+          break;
+        }
+        stats.pages_punched += last - first;
+        data = handle_->nextData(run_position + std::uint64_t(last) *
+                                 Page::SIZE, run_limit);
       }
+      run_start = allocation_map.nextFree(run_end);
     }
   }
-  // Clear the page and add it to the head of the free list.
-  existing_page.initialize();
-  existing_page.set_next_page_number(header.first_free_page);
-  header.first_free_page = page_number;
-  ++header.num_free_pages;
-  if (previous_page.isUsed()) {
-    writePage(previous_page.page_number(), previous_page);
+  handle_->commit();
+
+  const std::uint64_t disk_usage_after = handle_->diskUsage();
+  if (disk_usage_after < disk_usage_before) {
+    stats.bytes_reclaimed = disk_usage_before - disk_usage_after;
+  }
+  return stats;
+}
+
+PageForwardingMap File::compact() {
+  // Page numbers are about to change under whatever is cached by them.
+  for (std::size_t i = 0; i < close_listeners_.size(); ++i) {
+    close_listeners_[i]->fileCompacting(*this);
+  }
+  PageForwardingMap forwarding;
+  FileHeader header = readHeader();
+  AllocationMap& allocation_map = handle_->allocationMap();
+
+  // Slide every used page down into the lowest free page number.  Pages are
+  // visited in order, so every page number below <target> is already used
+  // and everything from <target> up to the current page is free.
+  PageId target = 1;
+  for (PageId page_number = allocation_map.nextUsed(Page::INVALID_NUMBER);
+       page_number != Page::INVALID_NUMBER;
+       page_number = allocation_map.nextUsed(page_number), ++target) {
+    if (page_number == target) {
+      continue;
+    }
+    Page page = readPage(page_number, false /* allow_free */);
+    page.set_page_number(target);
+    // Write the copy before freeing the original, so a crash in between
+    // leaves a duplicate rather than a lost page.
+    allocation_map.markUsed(target);
+    writePage(target, page);
+    writeAllocationWord(target);
+    allocation_map.markFree(page_number);
+    writeAllocationWord(page_number);
+    forwarding[page_number] = target;
+  }
+
+  if (!forwarding.empty()) {
+    header.first_used_page = 1;
+    header.first_free_page = header.num_free_pages > 0
+        ? allocation_map.nextFree(1)
+        : Page::INVALID_NUMBER;
+    writeHeader(header);
+  }
+  handle_->commit();
+  reclaimSpace();
+  return forwarding;
+}
+
+void File::setChecksums(const bool enabled) {
+  FileHeader header = readHeader();
+  if (enabled == ((header.flags & FLAG_CHECKSUMS) != 0)) {
+    return;
+  }
+  if (enabled) {
+    // Pages last written by older versions carry no checksum.  Stamp them,
+    // and make sure they are on disk before the flag is.
+    const AllocationMap& allocation_map = handle_->allocationMap();
+    Page page(Page::Uninitialized{});
+    for (PageId page_number = allocation_map.nextUsed(Page::INVALID_NUMBER);
+         page_number != Page::INVALID_NUMBER;
+         page_number = allocation_map.nextUsed(page_number)) {
+      readImage(page_number, page);
+      if (page.header_.next_page_number != pageChecksum(page)) {
+        writePage(page_number, page);
+      }
+    }
+    handle_->sync();
+    header.flags |= FLAG_CHECKSUMS;
+  } else {
+    header.flags &= ~FLAG_CHECKSUMS;
   }
-  writePage(page_number, existing_page);
   writeHeader(header);
+  handle_->sync();
+}
+
+bool File::compressed() const {
+  return (readHeader().flags & FLAG_COMPRESSED) != 0;
+}
+
+std::size_t File::recordSize() const {
+  return readHeader().record_size;
+}
+
+bool File::columnar() const {
+  return (readHeader().flags & FLAG_COLUMNAR) != 0;
+}
+
+CompressionStats File::compressionStats() const {
+  CompressionStats stats = {0 /* pages */, 0 /* stored_bytes */,
+                            0 /* garbage_bytes */};
+  const PageOffsetMap& offset_map = handle_->offsetMap();
+  for (std::uint32_t group = 0; group < offset_map.numGroups(); ++group) {
+    stats.stored_bytes += offset_map.liveBytes(group);
+    stats.garbage_bytes +=
+        offset_map.usedBytes(group) - offset_map.liveBytes(group);
+    const PageId first_page = group * AllocationMap::PAGES_PER_GROUP + 1;
+    for (PageId i = 0; i < offset_map.pagesInGroup(group); ++i) {
+      if (offset_map.extent(first_page + i).length != 0) {
+        ++stats.pages;
+      }
+    }
+  }
+  return stats;
+}
+
+bool File::checksums() const {
+  return (readHeader().flags & FLAG_CHECKSUMS) != 0;
+}
+
+void File::setPunchHoles(const bool punch_holes) {
+  handle_->setPunchHoles(punch_holes);
+}
+
+void File::setReadLatency(const std::uint32_t micros) {
+  handle_->setReadLatency(micros);
+}
+
+void File::setWriteLatency(const std::uint32_t micros) {
+  handle_->setWriteLatency(micros);
+}
+
+void File::sync() {
+  handle_->sync();
+}
+
+bool File::isDurable() const {
+  return handle_->isDurable();
+}
+
+void File::setDurability(const DurabilityPolicy& policy) {
+  handle_->setDurability(policy);
+}
+
+const DurabilityPolicy& File::durability() const {
+  return handle_->durability();
+}
+
+void File::setGrowth(const GrowthPolicy& policy) {
+  handle_->setGrowth(policy);
+}
+
+const GrowthPolicy& File::growth() const {
+  return handle_->growth();
 }
 
 FileIterator File::begin() {
-  const FileHeader& header = readHeader();
-  return FileIterator(this, header.first_used_page);
+  return FileIterator(this, nextUsedPage(Page::INVALID_NUMBER));
 }
 
 FileIterator File::end() {
   return FileIterator(this, Page::INVALID_NUMBER);
 }
 
-File::File(const std::string& name, const bool create_new) : filename_(name) {
-  openIfNeeded(create_new);
+File::File(const std::string& name, const bool create_new,
+           const bool compressed, const std::size_t record_size,
+           const bool columnar) {
+  openIfNeeded(name, create_new);
 
   if (create_new) {
     // File starts with 1 page (the header).
-    FileHeader header = {1 /* num_pages */, 0 /* first_used_page */,
-                         0 /* num_free_pages */, 0 /* first_free_page */};
+    FileHeader header = {MAGIC, FORMAT_VERSION, 1 /* num_pages */,
+                         Page::INVALID_NUMBER /* first_used_page */,
+                         0 /* num_free_pages */,
+                         Page::INVALID_NUMBER /* first_free_page */,
+                         (compressed ? FLAG_COMPRESSED : 0) |
+                             (columnar ? FLAG_COLUMNAR : 0) /* flags */,
+                         static_cast<std::uint32_t>(record_size)};
     writeHeader(header);
+    handle_->commit();
+  } else if (this->compressed()) {
+    // Finish moving any group whose move to its other half was cut short.
+    PageOffsetMap& offset_map = handle_->offsetMap();
+    for (std::uint32_t group = 0; group < offset_map.numGroups(); ++group) {
+      if (offset_map.hasStrays(group)) {
+        moveImages(group, offset_map.cursor(group));
+      }
+    }
+  }
+  if (!create_new && readHeader().version < FORMAT_VERSION) {
+    upgradePages();
   }
 }
 
-void File::openIfNeeded(const bool create_new) {
-  if (open_counts_.find(filename_) != open_counts_.end()) {	//exists an entry already
-    ++open_counts_[filename_];
-    stream_ = open_streams_[filename_];
+void File::openIfNeeded(const std::string& name, const bool create_new) {
+  if (registry_.find(name, file_id_)) {	//exists an entry already
+    registry_.acquire(file_id_);
+    handle_ = registry_.handle(file_id_);
   } else {
-    std::ios_base::openmode mode =
-        std::fstream::in | std::fstream::out | std::fstream::binary;
-    const bool already_exists = exists(filename_);
+    const bool already_exists = exists(name);
     if (create_new) {
       // Error if we try to overwrite an existing file.
       if (already_exists) {
-        throw FileExistsException(filename_);
+        throw FileExistsException(name);
       }
-      // New files have to be truncated on open.
-      mode = mode | std::fstream::trunc;
     } else {
       // Error if we try to open a file that doesn't exist.
       if (!already_exists) {
-        throw FileNotFoundException(filename_);
+        throw FileNotFoundException(name);
       }
     }
-    stream_.reset(new std::fstream(filename_, mode));
-    open_streams_[filename_] = stream_;
-    open_counts_[filename_] = 1;
+    std::shared_ptr<FileHandle> handle(new FileHandle(name, create_new));
+    if (!create_new) {
+      loadMetadata(name, handle);
+    }
+    file_id_ = registry_.add(name, handle);
+    handle_ = handle;
   }
 }
 
 void File::close() {
-  --open_counts_[filename_];
-  stream_.reset();
-  if (open_counts_[filename_] == 0) {
-    open_streams_.erase(filename_);
-    open_counts_.erase(filename_);
+  if (!handle_) {
+    // Already closed.
+    return;
   }
+  if (registry_.references(file_id_) == 1) {
+    try {
+      for (std::size_t i = 0; i < close_listeners_.size(); ++i) {
+        close_listeners_[i]->fileClosing(*this);
+      }
+    } catch (...) {
+      handle_.reset();
+      registry_.release(file_id_);
+      throw;
+    }
+  }
+  handle_.reset();
+  registry_.release(file_id_);
 }
 
 void File::writePage(const PageId page_number, const Page& new_page) {
-  writePage(page_number, new_page.header_, new_page);
+  if (compressed()) {
+    const Page* pages[1] = {&new_page};
+    writeCompressed(page_number, pages, 1);
+    return;
+  }
+  PageHeader header = new_page.header_;
+  header.next_page_number = pageChecksum(new_page);
+  struct iovec buffers[2];
+  buffers[0].iov_base = &header;
+  buffers[0].iov_len = sizeof(header);
+  buffers[1].iov_base = const_cast<char*>(new_page.data_);
+  buffers[1].iov_len = Page::DATA_SIZE;
+  handle_->writeVector(pagePosition(page_number), buffers, 2);
+}
+
+void File::writeRuns(const std::vector<const Page*>& pages) {
+  std::vector<const Page*> sorted(pages);
+  std::sort(sorted.begin(), sorted.end(),
+            [](const Page* a, const Page* b) {
+              return a->page_number() < b->page_number();
+            });
+  std::size_t run_start = 0;
+  for (std::size_t i = 1; i <= sorted.size(); ++i) {
+    if (i < sorted.size() &&
+        sorted[i]->page_number() == sorted[i - 1]->page_number() + 1 &&
+        AllocationMap::groupOf(sorted[i]->page_number()) ==
+            AllocationMap::groupOf(sorted[run_start]->page_number())) {
+      continue;
+    }
+    if (i > run_start) {
+      writeRun(sorted[run_start]->page_number(), &sorted[run_start],
+               i - run_start);
+    }
+    run_start = i;
+  }
+}
+
+void File::writeRun(const PageId first_page, const Page* const* pages,
+                    const std::size_t count) {
+  if (compressed()) {
+    writeCompressed(first_page, pages, count);
+    return;
+  }
+  std::vector<PageHeader> headers(count);
+  std::vector<struct iovec> buffers(2 * count);
+  for (std::size_t i = 0; i < count; ++i) {
+    headers[i] = pages[i]->header_;
+    headers[i].next_page_number = pageChecksum(*pages[i]);
+    buffers[2 * i].iov_base = &headers[i];
+    buffers[2 * i].iov_len = sizeof(headers[i]);
+    buffers[2 * i + 1].iov_base = const_cast<char*>(pages[i]->data_);
+    buffers[2 * i + 1].iov_len = Page::DATA_SIZE;
+  }
+  handle_->writeVector(pagePosition(first_page), &buffers[0], buffers.size());
+}
+
+void File::readImage(const PageId page_number, Page& page) const {
+  if (compressed()) {
+    readCompressed(page_number, handle_->offsetMap().extent(page_number), page);
+    return;
+  }
+  struct iovec buffers[2];
+  buffers[0].iov_base = &page.header_;
+  buffers[0].iov_len = sizeof(page.header_);
+  buffers[1].iov_base = page.data_;
+  buffers[1].iov_len = Page::DATA_SIZE;
+  handle_->readVector(pagePosition(page_number), buffers, 2);
+}
+
+void File::verifyPage(const PageId page_number, const Page& page,
+                      const std::uint32_t flags) const {
+  // Free pages may never have been written (or had their blocks released),
+  // so only used pages are checked.
+  if ((flags & FLAG_CHECKSUMS) != 0 && page.isUsed() &&
+      page.header_.next_page_number != pageChecksum(page)) {
+    throw CorruptPageException(page_number, filename());
+  }
+}
+
+void File::readCompressed(const PageId page_number, const PageExtent& extent,
+                          Page& page) const {
+  if (extent.length == 0) {
+    std::memset(&page.header_, 0, sizeof(page.header_));
+    std::memset(page.data_, 0, Page::DATA_SIZE);
+    return;
+  }
+  char image[Page::SIZE];
+  handle_->read(dataAreaPosition(AllocationMap::groupOf(page_number)) +
+                    extent.offset,
+                image, extent.length);
+  decodePage(page_number, image, extent.length, page);
+}
+
+void File::readCompressedRun(const PageId first_page, const PageId count,
+                             Page* pages) const {
+  const PageOffsetMap& offset_map = handle_->offsetMap();
+  std::vector<char> images;
+  PageId done = 0;
+  while (done < count) {
+    const PageId run_start = first_page + done;
+    const PageExtent& first = offset_map.extent(run_start);
+    if (first.length == 0) {
+      readCompressed(run_start, first, pages[done]);
+      ++done;
+      continue;
+    }
+    // Pages written together were appended back to back; read each such
+    // run of images in one call.
+    const std::uint32_t group = AllocationMap::groupOf(run_start);
+    std::uint64_t end = std::uint64_t(first.offset) + first.length;
+    PageId run_length = 1;
+    while (done + run_length < count) {
+      const PageId next = run_start + run_length;
+      const PageExtent& extent = offset_map.extent(next);
+      if (AllocationMap::groupOf(next) != group || extent.length == 0 ||
+          extent.offset != end) {
+        break;
+      }
+      end += extent.length;
+      ++run_length;
+    }
+    images.resize(end - first.offset);
+    handle_->read(dataAreaPosition(group) + first.offset, &images[0],
+                  images.size());
+    std::size_t position = 0;
+    for (PageId i = 0; i < run_length; ++i) {
+      const std::size_t length = offset_map.extent(run_start + i).length;
+      decodePage(run_start + i, &images[position], length, pages[done + i]);
+      position += length;
+    }
+    done += run_length;
+  }
+}
+
+void File::decodePage(const PageId page_number, const char* image,
+                      const std::size_t length, Page& page) const {
+  if (length == Page::SIZE) {
+    std::memcpy(&page.header_, image, sizeof(page.header_));
+    std::memcpy(page.data_, image + sizeof(page.header_), Page::DATA_SIZE);
+  } else if (!PageCodec::decompress(image, length,
+                                    reinterpret_cast<char*>(&page),
+                                    Page::SIZE)) {
+    throw CorruptPageException(page_number, filename());
+  }
+}
+
+std::size_t File::encodePage(const Page& page, char* image) {
+  char raw[Page::SIZE];
+  PageHeader header = page.header_;
+  header.next_page_number = pageChecksum(page);
+  std::memcpy(raw, &header, sizeof(header));
+  std::memcpy(raw + sizeof(header), page.data_, Page::DATA_SIZE);
+  // Limiting the output to less than a page keeps Page::SIZE free to mark
+  // images stored as they are.
+  const std::size_t length =
+      PageCodec::compress(raw, Page::SIZE, image, Page::SIZE - 1);
+  if (length == 0) {
+    std::memcpy(image, raw, Page::SIZE);
+    return Page::SIZE;
+  }
+  return length;
+}
+
+void File::writeCompressed(const PageId first_page, const Page* const* pages,
+                           const std::size_t count) {
+  PageOffsetMap& offset_map = handle_->offsetMap();
+  const std::uint32_t group = AllocationMap::groupOf(first_page);
+  std::vector<char> images(count * Page::SIZE);
+  std::vector<struct iovec> buffers(count);
+  std::uint64_t total = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    buffers[i].iov_base = &images[i * Page::SIZE];
+    buffers[i].iov_len = encodePage(*pages[i], &images[i * Page::SIZE]);
+    total += buffers[i].iov_len;
+  }
+  if (offset_map.usedBytes(group) + total > PageOffsetMap::HALF_BYTES) {
+    // Live images take at most half of a half, and so do the new ones, so
+    // after the move they are sure to fit.
+    moveImages(group, PageOffsetMap::HALF_BYTES -
+                      PageOffsetMap::halfStart(offset_map.cursor(group)));
+  }
+  std::uint64_t cursor = offset_map.cursor(group);
+  handle_->writeVector(dataAreaPosition(group) + cursor, &buffers[0], count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const PageExtent extent = {static_cast<std::uint32_t>(cursor),
+                               static_cast<std::uint16_t>(buffers[i].iov_len),
+                               0 /* reserved */};
+    offset_map.setExtent(first_page + i, extent);
+    cursor += buffers[i].iov_len;
+  }
+  offset_map.setCursor(group, cursor);
+  writeExtents(first_page, count);
+}
+
+void File::writeExtents(const PageId first_page, const std::size_t count) {
+  handle_->write(extentPosition(first_page),
+                 &handle_->offsetMap().extent(first_page),
+                 count * sizeof(PageExtent));
+}
+
+void File::moveImages(const std::uint32_t group,
+                      const std::uint64_t destination) {
+  PageOffsetMap& offset_map = handle_->offsetMap();
+  const std::uint64_t target_half = PageOffsetMap::halfStart(destination);
+  const std::uint64_t area = dataAreaPosition(group);
+  const PageId first_page = group * AllocationMap::PAGES_PER_GROUP + 1;
+  const PageId num_pages = offset_map.pagesInGroup(group);
+
+  std::vector<char> batch;
+  std::uint64_t batch_start = destination;
+  std::uint64_t cursor = destination;
+  for (PageId i = 0; i < num_pages; ++i) {
+    PageExtent extent = offset_map.extent(first_page + i);
+    if (extent.length == 0 ||
+        PageOffsetMap::halfStart(extent.offset) == target_half) {
+      continue;
+    }
+    const std::size_t batch_size = batch.size();
+    batch.resize(batch_size + extent.length);
+    handle_->read(area + extent.offset, &batch[batch_size], extent.length);
+    extent.offset = static_cast<std::uint32_t>(cursor);
+    offset_map.setExtent(first_page + i, extent);
+    cursor += extent.length;
+    if (batch.size() >= MOVE_BATCH_BYTES) {
+      handle_->write(area + batch_start, &batch[0], batch.size());
+      batch_start = cursor;
+      batch.clear();
+    }
+  }
+  if (!batch.empty()) {
+    handle_->write(area + batch_start, &batch[0], batch.size());
+  }
+  offset_map.setCursor(group, cursor);
+
+  handle_->sync();
+  if (num_pages > 0) {
+    handle_->write(extentPosition(first_page), offset_map.groupExtents(group),
+                   num_pages * sizeof(PageExtent));
+  }
+  handle_->sync();
+  handle_->punchHole(area + (PageOffsetMap::HALF_BYTES - target_half),
+                     PageOffsetMap::HALF_BYTES);
 }
 
-void File::writePage(const PageId page_number, const PageHeader& header,
-                     const Page& new_page) {
-  stream_->seekp(pagePosition(page_number), std::ios::beg);
-  stream_->write(reinterpret_cast<const char*>(&header), sizeof(header));
-  stream_->write(reinterpret_cast<const char*>(&new_page.data_[0]),
-                 Page::DATA_SIZE);
-  stream_->flush();
+std::uint32_t File::pageChecksum(const Page& page) {
+  static_assert(offsetof(PageHeader, next_page_number) +
+                    sizeof(PageId) == sizeof(PageHeader),
+                "The checksum must be stored in the last field of the header.");
+  const std::uint32_t crc = Crc32c::extend(
+      0, &page.header_, offsetof(PageHeader, next_page_number));
+  return Crc32c::extend(crc, page.data_, Page::DATA_SIZE);
 }
 
-FileHeader File::readHeader() const {
-  FileHeader header;
-  stream_->seekg(0 /* pos */, std::ios::beg);
-  stream_->read(reinterpret_cast<char*>(&header), sizeof(header));
+void File::loadMetadata(const std::string& name,
+                        std::shared_ptr<FileHandle>& handle) {
+  handle->loadHeader();
+  if (handle->header().magic != MAGIC) {
+    handle.reset();
+    upgradeLegacyFile(name);
+    handle.reset(new FileHandle(name, false /* create_new */));
+    handle->loadHeader();
+  }
+  const FileHeader header = handle->header();
+
+  AllocationMap& allocation_map = handle->allocationMap();
+  allocation_map.resize(header.num_pages);
+  const bool compressed = (header.flags & FLAG_COMPRESSED) != 0;
+  for (std::uint32_t group = 0; group < allocation_map.numGroups(); ++group) {
+    handle->read(bitmapPosition(group, compressed),
+                 allocation_map.groupWords(group), Page::SIZE);
+  }
+  allocation_map.recount();
+
+  if (compressed) {
+    PageOffsetMap& offset_map = handle->offsetMap();
+    offset_map.resize(header.num_pages);
+    for (std::uint32_t group = 0; group < offset_map.numGroups(); ++group) {
+      const PageId num_pages = offset_map.pagesInGroup(group);
+      if (num_pages > 0) {
+        handle->read(extentPosition(group * AllocationMap::PAGES_PER_GROUP + 1),
+                     offset_map.groupExtents(group),
+                     num_pages * sizeof(PageExtent));
+      }
+    }
+    offset_map.recount();
+  }
+}
 
-  return header;
+void File::writeAllocationWord(const PageId page_number) {
+  const std::uint64_t word =
+      handle_->allocationMap().wordContaining(page_number);
+  const std::uint64_t position =
+      bitmapPosition(AllocationMap::groupOf(page_number), compressed()) +
+      AllocationMap::wordInGroup(page_number) * sizeof(word);
+  handle_->write(position, &word, sizeof(word));
 }
 
-void File::writeHeader(const FileHeader& header) {
-  stream_->seekp(0 /* pos */, std::ios::beg);
-  stream_->write(reinterpret_cast<const char*>(&header), sizeof(header));
-  stream_->flush();
+void File::upgradePages() {
+  FileHeader header = readHeader();
+  for (PageId page_number = nextUsedPage(Page::INVALID_NUMBER);
+       page_number != Page::INVALID_NUMBER;
+       page_number = nextUsedPage(page_number)) {
+    Page page = readPage(page_number, false /* allow_free */);
+    if (header.version < 2) {
+      page.header_.fragmented_space = 0;
+    }
+    if (header.version < 3) {
+      page.rebuildFreeSlotChain();
+    }
+    writePage(page_number, page);
+  }
+  // The pages must be durable in the new format before the header says so.
+  handle_->sync();
+  header.version = FORMAT_VERSION;
+  writeHeader(header);
+  handle_->sync();
 }
 
-PageHeader File::readPageHeader(PageId page_number) const {
-  PageHeader header;
-  stream_->seekg(pagePosition(page_number), std::ios::beg);
-  stream_->read(reinterpret_cast<char*>(&header), sizeof(header));
+void File::upgradeLegacyFile(const std::string& filename) {
+  const std::string upgraded_name = filename + ".upgrade";
+  FileHandle legacy(filename, false /* create_new */);
+  LegacyFileHeader legacy_header;
+  legacy.read(0 /* offset */, &legacy_header, sizeof(legacy_header));
+
+  {
+    FileHandle upgraded(upgraded_name, true /* create_new */);
+    AllocationMap allocation_map;
+    allocation_map.resize(legacy_header.num_pages);
+    FileHeader header = {MAGIC, 1 /* version */, legacy_header.num_pages,
+                         Page::INVALID_NUMBER /* first_used_page */,
+                         0 /* num_free_pages */,
+                         Page::INVALID_NUMBER /* first_free_page */,
+                         0 /* flags */, 0 /* record_size */};
+
+    // Copy the pages across in physical order, rebuilding the used and free
+    // lists as a bitmap from the page headers as we go.
+    std::vector<char> buffer(Page::SIZE);
+    for (PageId page_number = 1; page_number < legacy_header.num_pages;
+         ++page_number) {
+      legacy.read(sizeof(LegacyFileHeader) +
+                      std::uint64_t(page_number - 1) * Page::SIZE,
+                  &buffer[0], Page::SIZE);
+      const PageHeader* page_header =
+          reinterpret_cast<const PageHeader*>(&buffer[0]);
+      if (page_header->current_page_number != Page::INVALID_NUMBER) {
+        allocation_map.markUsed(page_number);
+        if (header.first_used_page == Page::INVALID_NUMBER) {
+          header.first_used_page = page_number;
+        }
+      } else {
+        ++header.num_free_pages;
+        if (header.first_free_page == Page::INVALID_NUMBER) {
+          header.first_free_page = page_number;
+        }
+      }
+      upgraded.write(pagePosition(page_number), &buffer[0], Page::SIZE);
+    }
+    for (std::uint32_t group = 0; group < allocation_map.numGroups();
+         ++group) {
+      upgraded.write(bitmapPosition(group), allocation_map.groupWords(group),
+                     Page::SIZE);
+    }
+    upgraded.write(0 /* offset */, &header, sizeof(header));
+    upgraded.sync();
+  }
 
-  return header;
+  if (std::rename(upgraded_name.c_str(), filename.c_str()) != 0) {
+    throw IoException(filename, "rename", errno);
+  }
 }
 
 }
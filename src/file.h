@@ -7,66 +7,135 @@
 
 #pragma once
 
-#include <fstream>
+#include <cstddef>
 #include <string>
 #include <map>
 #include <memory>
+#include <vector>
 
+#include "descriptor_cache.h"
+#include "file_handle.h"
+#include "file_header.h"
+#include "file_registry.h"
 #include "page.h"
+#include "page_offset_map.h"
 
 namespace badgerdb {
 
+class File;
 class FileIterator;
 
 /**
- * @brief Header metadata for files on disk which contain pages.
+ * @brief Keeps state about open files -- a buffer pool, say -- that must be
+ *        dropped when a file closes or is compacted.
+ *
+ * A FileId is given to the next file opened as soon as its file closes, so
+ * anything keyed by FileId would otherwise mistake the pages of the new file
+ * for those of the old one.  Likewise compaction gives page numbers to other
+ * pages.  Listeners are registered with File::addCloseListener().
  */
-struct FileHeader {
+class FileCloseListener {
+ public:
+  virtual ~FileCloseListener() {}
+
   /**
-   * Number of pages allocated in the file.
+   * Called when the last File object for a file is about to close it.  The
+   * file can still be read and written through <file> until this returns.
+   *
+   * @param file  File being closed.
    */
-  PageId num_pages;
+  virtual void fileClosing(File& file) = 0;
 
   /**
-   * Page number of the first used page in the file.
+   * Called when File::compact() is about to move pages of a file, before it
+   * changes anything.  If this throws, the file is left as it was.
+   *
+   * @param file  File being compacted.
    */
-  PageId first_used_page;
+  virtual void fileCompacting(File& file) = 0;
+};
+
+/**
+ * @brief Maps the old page numbers of pages moved by File::compact() to their
+ *        new page numbers.
+ */
+typedef std::map<PageId, PageId> PageForwardingMap;
 
+/**
+ * Returns the ID a record has after compaction moved its page.  IDs of
+ * records on pages that were not moved are returned unchanged.
+ *
+ * @param forwarding  Forwarding map returned by File::compact().
+ * @param record_id   ID of the record before compaction.
+ * @return  ID of the record after compaction.
+ */
+RecordId forwardRecordId(const PageForwardingMap& forwarding,
+                         const RecordId& record_id);
+
+/**
+ * @brief Result of reclaiming the disk space held by a file's free pages.
+ */
+struct ReclaimStats {
   /**
-   * Number of free pages (allocated but unused) in the file.
+   * Number of free pages at the end of the file that were truncated away.
    */
-  PageId num_free_pages;
+  PageId pages_truncated;
 
   /**
-   * Page number of the first free (allocated but unused) page in the file.
+   * Number of free pages inside the file whose blocks were released by
+   * punching holes.
    */
-  PageId first_free_page;
+  PageId pages_punched;
 
   /**
-   * Returns true if this file header is equal to the other.
-   *
-   * @param rhs   Other file header to compare against.
-   * @return  True if the other header is equal to this one.
+   * Number of bytes of disk space the file gave back.
    */
-  bool operator==(const FileHeader& rhs) const {
-    return num_pages == rhs.num_pages &&
-        num_free_pages == rhs.num_free_pages &&
-        first_used_page == rhs.first_used_page &&
-        first_free_page == rhs.first_free_page;
-  }
+  std::uint64_t bytes_reclaimed;
+};
+
+/**
+ * @brief Space taken by the pages of a compressed file.
+ */
+struct CompressionStats {
+  /**
+   * Number of pages with a stored image.
+   */
+  PageId pages;
+
+  /**
+   * Bytes taken by the stored images of those pages.
+   */
+  std::uint64_t stored_bytes;
+
+  /**
+   * Bytes taken by images of pages that have since been rewritten or
+   * deleted, which reclaimSpace() gives back.
+   */
+  std::uint64_t garbage_bytes;
 };
 
 /**
  * @brief Class which represents a file in the filesystem containing database
  *        pages.
  *
- * The File class wraps a stream to an underlying file on disk.  Files contain
- * fixed-sized pages, and they never deallocate space (though they do reuse
- * deleted pages if possible).  If multiple File objects refer to the same
- * underlying file, they will share the stream in memory.
+ * The File class wraps a descriptor to an underlying file on disk.  Files
+ * contain fixed-sized pages.  Deleted pages are reused before the file grows,
+ * but their disk space is only given back on request: deletePage() can punch
+ * a hole over each page it frees (see setPunchHoles()), reclaimSpace()
+ * truncates trailing free pages and punches the rest, and compact() moves
+ * used pages down so that reclaimSpace() can cut off everything after them.
+ * Which pages are in use is recorded in
+ * allocation bitmap pages, one per AllocationMap::PAGES_PER_GROUP pages, so
+ * allocating, deleting and iterating never walk the pages themselves.
+ * If multiple File objects refer to the same
+ * underlying file, they will share the FileHandle in memory.
  * If a file that has already been opened (possibly by another query), then the File class
- * detects this (by looking in the open_streams_ map) and just returns a file object with
- * the already created stream for the file without actually opening the UNIX file again. 
+ * detects this (by looking in the FileRegistry) and just returns a file object with
+ * the already created handle for the file without actually opening the UNIX file again. 
+ * Every File object for the same open file carries the same FileId.
+ *
+ * How soon writes become durable is governed by the file's DurabilityPolicy;
+ * see DurabilityMode for the guarantees each mode gives.
  *
  * @warning This class is not threadsafe.
  */
@@ -75,23 +144,61 @@ class File {
   /**
    * Creates a new file.
    *
-   * @param filename  Name of the file.
+   * Compressed files store every page compressed with PageCodec, packed back
+   * to back, and find them through a page-offset map; see PageOffsetMap.
+   * They take less disk space and less I/O per page for tables of
+   * repetitive records, at the cost of compressing on every write and
+   * decompressing on every read.  Whether a file is compressed is fixed when
+   * it is created.
+   *
+   * A file created with a nonzero record size holds records of exactly that
+   * many bytes, and its pages are accessed through a FixedPage of that size
+   * instead of through the Page interface.  They hold more records per page
+   * than a Page of the same records, and cost less to access.  If the file
+   * is also created columnar, its pages are accessed through a PaxPage
+   * instead, which stores each column of the records separately for scans
+   * that filter on a few columns.
+   *
+   * @param filename    Name of the file.
+   * @param compressed  Whether to store pages compressed.
+   * @param record_size Length of every record in bytes, or 0 for a file of
+   *                    variable-length records.
+   * @param columnar    Whether pages of fixed-length records are stored
+   *                    column by column.
    * @throws  FileExistsException     If the requested file already exists.
    */
-  static File create(const std::string& filename);
+  static File create(const std::string& filename,
+                     const bool compressed = false,
+                     const std::size_t record_size = 0,
+                     const bool columnar = false);
 
   /**
    * Opens the file named fileName and returns the corresponding File object.
-	 * It first checks if the file is already open. If so, then the new File object created uses the same input-output stream to read to or write fom
-	 * that already open file. Reference count (open_counts_ static variable inside the File object) is incremented whenever an already open file is
-	 * opened again. Otherwise the UNIX file is actually opened. The fileName and the stream associated with this File object are inserted into the
-	 * open_streams_ map.
+	 * It first checks if the file is already open. If so, then the new File object created uses the same file handle to read to or write fom
+	 * that already open file. Reference count (kept in the static registry_ of open files) is incremented whenever an already open file is
+	 * opened again. Otherwise the UNIX file is actually opened, and the fileName and the handle associated with this File object are registered
+	 * under a new FileId.
+	 *
+	 * Files written before the on-disk format was versioned are upgraded in place the first time they are opened: every page
+	 * is copied into the current layout and the allocation bitmap is built from the pages' headers.  Files written by an
+	 * older version of the format have their pages rewritten in the current one.
    *
    * @param filename  Name of the file.
    * @throws  FileNotFoundException   If the requested file doesn't exist.
    */
   static File open(const std::string& filename);
 
+  /**
+   * Returns another File object for the file open under <file_id>, just as
+   * copying any File object for it would.  Lets code that keeps FileIds,
+   * such as a buffer pool, reach a file without holding a pointer to a File
+   * object that may be destroyed first.
+   *
+   * @param file_id   Id of an open file.
+   * @throws  FileNotFoundException   If no file is open under <file_id>.
+   */
+  static File openById(const FileId file_id);
+
   /**
    * Deletes an existing file.
    *
@@ -116,6 +223,44 @@ class File {
    */
   static bool exists(const std::string& filename);
 
+  /**
+   * Limits how many open files keep an operating system descriptor open at
+   * once.  Files beyond the limit stay open as far as File is concerned;
+   * their descriptors are closed while idle and re-opened on the next I/O,
+   * least recently used first.  Defaults to half the process's descriptor
+   * limit.
+   *
+   * @param max_descriptors   Maximum number of descriptors (0 for no limit).
+   */
+  static void setDescriptorLimit(const std::size_t max_descriptors);
+
+  /**
+   * Returns the limit set by setDescriptorLimit() (0 for no limit).
+   */
+  static std::size_t descriptorLimit();
+
+  /**
+   * Returns hit, miss, reopen and eviction counts of the descriptor cache,
+   * for sizing the descriptor limit.
+   */
+  static DescriptorCacheStats descriptorStats();
+
+  /**
+   * Registers a listener to be told whenever a file is closed or compacted.
+   * The listener
+   * is not owned and must be removed before it is destroyed.
+   *
+   * @param listener  Listener to add.
+   */
+  static void addCloseListener(FileCloseListener* listener);
+
+  /**
+   * Removes a listener registered with addCloseListener().
+   *
+   * @param listener  Listener to remove.
+   */
+  static void removeCloseListener(FileCloseListener* listener);
+
   /**
    * Copy constructor.
    * 
@@ -125,7 +270,9 @@ class File {
   File(const File& other);
 
   /**
-   * Assignment operator.
+   * Assignment operator.  If this was the last File object for its old
+   * file, that file is closed, and anything a close listener throws is
+   * passed on once this object refers to <rhs>'s file.
    *
    * @param rhs File object to assign.
    * @return    Newly assigned file object.
@@ -134,7 +281,9 @@ class File {
 
   /**
    * Destructor that automatically closes the underlying file if no other
-   * File objects are using it.
+   * File objects are using it.  An I/O error raised by a close listener is
+   * lost here; call a listener's own flush first to see it (for example
+   * BufMgr::flushFile()).
    */
   ~File();
 
@@ -152,6 +301,8 @@ class File {
    * @return  The page.
    * @throws  InvalidPageException  If the page doesn't exist in the file or is
    *                                not currently used.
+   * @throws  CorruptPageException  If checksums are enabled and the page
+   *                                does not match its checksum.
    */
   Page readPage(const PageId page_number) const;
 
@@ -165,18 +316,256 @@ class File {
   void writePage(const Page& new_page);
 
   /**
-   * Deletes a page from the file.
+   * Reads <count> consecutive pages starting at <first_page> into the array
+   * <pages>, transferring each run of pages that is contiguous on disk with
+   * a single vectored read.
+   *
+   * @param first_page  Number of the first page to read.
+   * @param count       Number of pages to read.
+   * @param pages       Array of at least <count> pages to read into.
+   * @throws  InvalidPageException  If any of the pages doesn't exist in the
+   *                                file or is not currently used.
+   * @throws  CorruptPageException  If checksums are enabled and any page
+   *                                does not match its checksum.
+   */
+  void readPages(const PageId first_page, const PageId count,
+                 Page* pages) const;
+
+  /**
+   * Reads the stored image of a page into <page> without consulting the
+   * file's in-memory metadata, so unlike every other method it may run
+   * concurrently with calls on other File objects for the same file.  The
+   * result is only usable once completePageRead() has accepted it.
+   *
+   * @param page_number   Number of page to read.
+   * @param page          Page to read into.
+   * @throws  IoException   If the read fails.
+   * @throws  CorruptPageException  If checksums are enabled and the page is
+   *                                in use but does not match its checksum.
+   */
+  void readPageImage(const PageId page_number, Page& page) const;
+
+  /**
+   * Finishes a readPageImage() of <page_number>: checks that the page is in
+   * use and fills in the parts of <page> kept in memory rather than on disk.
+   *
+   * @param page_number   Number of page that was read.
+   * @param page          Page filled by readPageImage().
+   * @return  False if the page is not currently used; <page> is then garbage.
+   */
+  bool completePageRead(const PageId page_number, Page& page) const;
+
+  /**
+   * Writes several pages into the file, replacing their existing contents.
+   * The pages may be given in any order; pages with adjacent numbers are
+   * written together with a single vectored write per run.  Counts as one
+   * write for the durability policy.
+   *
+   * @see writePage()
+   * @param pages   Pages to write; each must be allocated in this file.
+   * @throws  InvalidPageException  If any page is not currently used; no
+   *                                page is written in that case.
+   */
+  void writePages(const std::vector<const Page*>& pages);
+
+  /**
+   * Checks that every page of <pages> is in use, as writePages() does before
+   * writing them.
+   *
+   * @param pages   Pages about to be written.
+   * @throws  InvalidPageException  If any page is not currently used.
+   */
+  void checkPagesUsed(const std::vector<const Page*>& pages) const;
+
+  /**
+   * Writes several pages like writePages(), but without checking or
+   * changing the file's in-memory metadata, so like readPageImage() it may
+   * run concurrently with calls on other File objects for the same file.
+   * The caller must have run checkPagesUsed() on <pages> in a way that no
+   * page can be deleted before the write ends.  Not for compressed files,
+   * whose writes place images through the in-memory offset map.
+   *
+   * @param pages   Pages to write; each must be in use in this file.
+   * @throws  IoException   If a write fails.
+   */
+  void writePageImages(const std::vector<const Page*>& pages);
+
+  /**
+   * Deletes a page from the file.  If hole punching is enabled (see
+   * setPunchHoles()) the page's disk blocks are released immediately.
    *
    * @param page_number   Number of page to delete.
    */
   void deletePage(const PageId page_number);
 
+  /**
+   * Gives the disk space held by free pages back to the filesystem.  Free
+   * pages at the end of the file are truncated away, so the file shrinks;
+   * the remaining free pages have holes punched over them, so they read as
+   * zeros and occupy no blocks until they are allocated again.  Page numbers
+   * of used pages are unaffected.
+   *
+   * @return  How many pages were reclaimed and how much space was freed.
+   */
+  ReclaimStats reclaimSpace();
+
+  /**
+   * Compacts the file so that its used pages occupy page numbers 1 to N with
+   * no free pages between them, then truncates the free space at the end
+   * (see reclaimSpace()).  Used pages keep their relative order, so a full
+   * scan afterwards reads the file front to back as one contiguous stream.
+   *
+   * Moving a page changes its page number, and with it the RecordIds of its
+   * records; slot numbers are unchanged.  The returned map lets callers
+   * translate old IDs with forwardRecordId().  Until every stored RecordId
+   * has been translated (or if that is not possible, for the whole time the
+   * file is being compacted) nothing may use the old IDs, so either rewrite
+   * references straight away or run compaction in a maintenance window.
+   *
+   * Close listeners are told first (see FileCloseListener::fileCompacting()),
+   * so a buffer pool writes out and drops the file's pages, and its cache
+   * tiers the images kept under their old numbers.  A pool refuses if any
+   * page of the file is pinned, and no page of the file may be read through
+   * it (or prewarmed) until compaction returns.
+   *
+   * @return  Old and new page numbers of every page that was moved.
+   * @throws  PagePinnedException  If a buffer pool has a page of the file
+   *                               pinned; nothing is moved in that case.
+   */
+  PageForwardingMap compact();
+
+  /**
+   * Sets whether deletePage() punches a hole over each deleted page.  The
+   * setting is shared by every File object for the same underlying file.
+   * Filesystems which cannot punch holes silently fall back to overwriting
+   * the page.
+   *
+   * @param punch_holes   True to punch holes for deleted pages.
+   */
+  void setPunchHoles(const bool punch_holes);
+
+  /**
+   * Returns true if the file stores its pages compressed.
+   */
+  bool compressed() const;
+
+  /**
+   * Returns the length of every record in a file of fixed-length records,
+   * or 0 for a file of variable-length records.
+   *
+   * @see File::create()
+   */
+  std::size_t recordSize() const;
+
+  /**
+   * Returns true if the file's pages of fixed-length records are stored
+   * column by column, as PaxPages.
+   *
+   * @see File::create()
+   */
+  bool columnar() const;
+
+  /**
+   * Returns the space taken by the pages of a compressed file.  All counts
+   * are zero for other files.
+   */
+  CompressionStats compressionStats() const;
+
+  /**
+   * Sets whether pages read from this file are verified against their
+   * checksums.  Every page written carries a CRC-32C of its contents, stored
+   * in place of the header's next_page_number; with verification on, a used
+   * page whose contents do not match its checksum makes the read throw
+   * CorruptPageException.  The setting is stored in the file header, so it
+   * persists and is shared by every File object for the same file.
+   *
+   * Turning verification on first reads every used page and rewrites those
+   * written before checksums were kept, so it takes a full pass over the
+   * file; it must not run while pages of the file are being read through
+   * readPageImage().
+   *
+   * @param enabled   True to verify checksums on read.
+   */
+  void setChecksums(const bool enabled);
+
+  /**
+   * Returns whether pages read from this file are verified against their
+   * checksums.
+   */
+  bool checksums() const;
+
+  /**
+   * Adds a fixed delay to every read of this file, so that tests and
+   * benchmarks can stand in slow storage with a local file.  The setting is
+   * shared by every File object for the same underlying file.
+   *
+   * @param micros  Delay per read, in microseconds; 0 for none.
+   */
+  void setReadLatency(const std::uint32_t micros);
+
+  /**
+   * Adds a fixed delay to every write of this file, the counterpart of
+   * setReadLatency().  The setting is shared by every File object for the
+   * same underlying file.
+   *
+   * @param micros  Delay per write, in microseconds; 0 for none.
+   */
+  void setWriteLatency(const std::uint32_t micros);
+
+  /**
+   * Makes every write issued to this file so far durable, regardless of the
+   * durability mode.
+   *
+   * @throws  IoException   If the sync fails.
+   */
+  void sync();
+
+  /**
+   * Returns true if every write issued to this file so far is durable.
+   */
+  bool isDurable() const;
+
+  /**
+   * Sets the durability policy of this file.  The policy is shared by every
+   * File object for the same underlying file.
+   *
+   * @param policy  New policy.
+   */
+  void setDurability(const DurabilityPolicy& policy);
+
+  /**
+   * Returns the durability policy of this file.
+   */
+  const DurabilityPolicy& durability() const;
+
+  /**
+   * Sets the growth policy of this file, which decides how much disk space is
+   * reserved each time the file has to grow.  The policy is shared by every
+   * File object for the same underlying file.
+   *
+   * @param policy  New policy.
+   */
+  void setGrowth(const GrowthPolicy& policy);
+
+  /**
+   * Returns the growth policy of this file.
+   */
+  const GrowthPolicy& growth() const;
+
   /**
    * Returns the name of the file this object represents.
    *
    * @return Name of file.
    */
-  const std::string& filename() const { return filename_; }
+  const std::string& filename() const { return registry_.filename(file_id_); }
+
+  /**
+   * Returns the id of the open file this object represents.  All File
+   * objects for the same open file share one id.
+   *
+   * @return Id of file.
+   */
+  FileId id() const { return file_id_; }
 
   /**
    * Returns an iterator at the first page in the file.
@@ -194,15 +583,111 @@ class File {
   FileIterator end();
 
  private:
+  /**
+   * Magic number stored at the start of every file in the current format.
+   */
+  static const std::uint32_t MAGIC = 0x46424442;
+
+  /**
+   * Version of the current on-disk format.
+   */
+  static const std::uint32_t FORMAT_VERSION = 3;
+
+  /**
+   * Flag in FileHeader::flags set when page checksums are verified on read.
+   */
+  static const std::uint32_t FLAG_CHECKSUMS = 1;
+
+  /**
+   * Flag in FileHeader::flags set for files created compressed.
+   */
+  static const std::uint32_t FLAG_COMPRESSED = 2;
+
+  /**
+   * Flag in FileHeader::flags set for files created columnar.
+   */
+  static const std::uint32_t FLAG_COLUMNAR = 4;
+
+  /**
+   * Distance between the bitmap pages of consecutive groups in a compressed
+   * file.  Each bitmap page is followed by the group's part of the offset
+   * map and by its data area.  Space in the data area is only allocated as
+   * it is written, so the file stays sparse.
+   */
+  static const std::uint64_t COMPRESSED_GROUP_BYTES =
+      (1 + PageOffsetMap::MAP_PAGES_PER_GROUP) * Page::SIZE +
+      2 * PageOffsetMap::HALF_BYTES;
+
+  /**
+   * Bytes of page images copied per write when moving a group's images.
+   */
+  static const std::size_t MOVE_BATCH_BYTES = 1 << 20;
+
   /**
    * Returns the position of the page with the given number in the file (as an
    * offset from the beginning of the file).
    *
+   * The header occupies the first Page::SIZE bytes of the file.  After it,
+   * each group of AllocationMap::PAGES_PER_GROUP pages is preceded by the
+   * bitmap page describing it.
+   *
    * @param page_number   Number of page.
    * @return  Position of page in file.
    */
-  static std::streampos pagePosition(const PageId page_number) {
-    return sizeof(FileHeader) + ((page_number - 1) * Page::SIZE);
+  static std::uint64_t pagePosition(const PageId page_number) {
+    const std::uint64_t group = AllocationMap::groupOf(page_number);
+    return bitmapPosition(group) + Page::SIZE +
+        ((page_number - 1) % AllocationMap::PAGES_PER_GROUP) * Page::SIZE;
+  }
+
+  /**
+   * Returns the position of the bitmap page for the given group in the file.
+   *
+   * @param group   Group number.
+   * @return  Position of bitmap page in file.
+   */
+  static std::uint64_t bitmapPosition(const std::uint64_t group) {
+    return (1 + group * (AllocationMap::PAGES_PER_GROUP + 1)) * Page::SIZE;
+  }
+
+  /**
+   * Returns the position of the bitmap page for the given group in a file
+   * that may be compressed.
+   *
+   * @param group       Group number.
+   * @param compressed  Whether the file is compressed.
+   * @return  Position of bitmap page in file.
+   */
+  static std::uint64_t bitmapPosition(const std::uint64_t group,
+                                      const bool compressed) {
+    return compressed ? Page::SIZE + group * COMPRESSED_GROUP_BYTES
+                      : bitmapPosition(group);
+  }
+
+  /**
+   * Returns the position of the given page's entry in the offset map of a
+   * compressed file.
+   *
+   * @param page_number   Number of page.
+   * @return  Position of the page's PageExtent in file.
+   */
+  static std::uint64_t extentPosition(const PageId page_number) {
+    const std::uint64_t group = AllocationMap::groupOf(page_number);
+    return bitmapPosition(group, true /* compressed */) + Page::SIZE +
+        ((page_number - 1) % AllocationMap::PAGES_PER_GROUP) *
+        sizeof(PageExtent);
+  }
+
+  /**
+   * Returns the position of the data area of the given group in a
+   * compressed file.  PageExtent offsets are relative to it.
+   *
+   * @param group   Group number.
+   * @return  Position of the group's data area in file.
+   */
+  static std::uint64_t dataAreaPosition(const std::uint64_t group) {
+    return bitmapPosition(group, true /* compressed */) +
+        (1 + PageOffsetMap::MAP_PAGES_PER_GROUP) * Page::SIZE;
   }
 
   /**
@@ -214,30 +699,46 @@ class File {
    * @see File::open()
    * @param name        Name of file.
    * @param create_new  Whether to create a new file.
+   * @param compressed  Whether a new file stores its pages compressed.
+   * @param record_size Length of every record in a new file of fixed-length
+   *                    records, or 0.
+   * @param columnar    Whether a new file stores its pages column by column.
    * @throws  FileExistsException     If the underlying file exists and
    *                                  create_new is true.
    * @throws  FileNotFoundException   If the underlying file doesn't exist and
    *                                  create_new is false.
    */
-  File(const std::string& name, const bool create_new);
+  File(const std::string& name, const bool create_new,
+       const bool compressed, const std::size_t record_size,
+       const bool columnar);
+
+  /**
+   * Constructs another File object for the file open under <file_id>.
+   *
+   * @see File::openById()
+   * @param file_id   Id of an open file.
+   */
+  explicit File(const FileId file_id);
 
   /**
-   * Opens the underlying file named in filename_.
-   * This method only opens the file if no other File objects exist that access
-   * the same filesystem file; otherwise, it reuses the existing stream.
+   * Opens the underlying file with the given name and sets file_id_ and
+   * handle_.  This method only opens the file if no other File objects exist
+   * that access the same filesystem file; otherwise, it reuses the existing
+   * handle.
    *
+   * @param name        Name of file.
    * @param create_new  Whether to create a new file.
    * @throws  FileExistsException     If the underlying file exists and
    *                                  create_new is true.
    * @throws  FileNotFoundException   If the underlying file doesn't exist and
    *                                  create_new is false.
    */
-  void openIfNeeded(const bool create_new);
+  void openIfNeeded(const std::string& name, const bool create_new);
 
   /**
-   * Closes the underlying file stream in <stream_>.
+   * Closes the underlying file handle in <handle_>.
    * This method only closes the file if no other File objects exist that access
-   * the same file.
+   * the same file, after telling the close listeners.
    */
   void close();
 
@@ -245,8 +746,8 @@ class File {
    * Reads a page from the file.  If <allow_free> is not set, an exception
    * will be thrown if the page read from disk is not currently in use.
    *
-   * No bounds checking is performed; the underlying file stream will throw
-   * an exception if the page is past the end of the file.
+   * No bounds checking is performed; a page past the end of the file reads
+   * as a free page.
    *
    * @param page_number   Number of page to read.
    * @param allow_free    Whether to allow reading a free (unused) page.
@@ -267,63 +768,221 @@ class File {
   void writePage(const PageId page_number, const Page& new_page);
 
   /**
-   * Writes a page into the file at the given page number with the given header.
-   * This does not ensure that the number in the header equals the position on
-   * disk.  No bounds checking is performed.
+   * Writes <pages> in any order, one writeRun() per run of adjacent pages
+   * within an allocation group.  No checking is performed.
    *
-   * @param page_number Number of page whose contents to replace.
-   * @param header      Header of page to write.
-   * @param new_page    Page to write.
+   * @param pages   Pages to write.
+   */
+  void writeRuns(const std::vector<const Page*>& pages);
+
+  /**
+   * Writes <count> pages, numbered consecutively from <first_page> and all in
+   * the same allocation group, with one vectored write.  No checking is
+   * performed.
+   *
+   * @param first_page  Number of the first page.
+   * @param pages       Pages to write, in page number order.
+   * @param count       Number of pages.
+   */
+  void writeRun(const PageId first_page, const Page* const* pages,
+                const std::size_t count);
+
+  /**
+   * Reads the stored image of a page into <page>, with no checking.
+   *
+   * @param page_number   Number of page to read.
+   * @param page          Page to read into.
+   */
+  void readImage(const PageId page_number, Page& page) const;
+
+  /**
+   * Checks a page just read from disk against its stored checksum, if the
+   * file has checksums enabled and the page is in use.
+   *
+   * @param page_number   Number of page that was read.
+   * @param page          Page as read from disk.
+   * @param flags         Header flags the page was read under.
+   * @throws  CorruptPageException  If the checksum does not match.
+   */
+  void verifyPage(const PageId page_number, const Page& page,
+                  const std::uint32_t flags) const;
+
+  /**
+   * Reads the stored image of a page of a compressed file, given its extent,
+   * and decompresses it into <page>.  A page with no image reads as zeros.
+   *
+   * @param page_number   Number of page to read.
+   * @param extent        Where the page's image is stored.
+   * @param page          Page to read into.
+   * @throws  CorruptPageException  If the image does not decompress.
+   */
+  void readCompressed(const PageId page_number, const PageExtent& extent,
+                      Page& page) const;
+
+  /**
+   * Reads <count> consecutive pages of a compressed file, starting at
+   * <first_page>, into <pages>.  Images stored back to back, as they are
+   * when the pages were written together, are read with a single call.
+   * No checking is performed.
+   *
+   * @param first_page  Number of the first page.
+   * @param count       Number of pages.
+   * @param pages       Array of at least <count> pages to read into.
+   * @throws  CorruptPageException  If an image does not decompress.
+   */
+  void readCompressedRun(const PageId first_page, const PageId count,
+                         Page* pages) const;
+
+  /**
+   * Decompresses the <length>-byte stored image of a page into <page>.
+   *
+   * @throws  CorruptPageException  If the image does not decompress.
+   */
+  void decodePage(const PageId page_number, const char* image,
+                  const std::size_t length, Page& page) const;
+
+  /**
+   * Compresses a page, with its checksum filled in, into <image>, which
+   * must hold Page::SIZE bytes.  Pages that do not compress are copied as
+   * they are.
+   *
+   * @param page    Page to compress.
+   * @param image   Buffer for the stored image.
+   * @return  Length of the stored image; Page::SIZE if not compressed.
    */
-  void writePage(const PageId page_number, const PageHeader& header,
-                 const Page& new_page);
+  static std::size_t encodePage(const Page& page, char* image);
 
   /**
-   * Reads the header for this file from disk.
+   * Appends the images of <count> pages of a compressed file, numbered
+   * consecutively from <first_page> and all in the same group, at the
+   * group's write cursor with one vectored write, then points their map
+   * entries at them.  Moves the group's images to its other half first if
+   * the current one is out of room.
+   *
+   * @param first_page  Number of the first page.
+   * @param pages       Pages to write, in page number order.
+   * @param count       Number of pages.
+   */
+  void writeCompressed(const PageId first_page, const Page* const* pages,
+                       const std::size_t count);
+
+  /**
+   * Writes the offset map entries of <count> consecutive pages of a
+   * compressed file back to disk.
+   *
+   * @param first_page  Number of the first page.
+   * @param count       Number of pages.
+   */
+  void writeExtents(const PageId first_page, const std::size_t count);
+
+  /**
+   * Copies every live image of a group that lies outside the half holding
+   * <destination> to <destination> onwards, points the map at the copies
+   * and releases the disk space of the other half.  Copies are synced
+   * before the map is written, and the map before the space is released,
+   * so a crash leaves every page readable from one copy or the other.
+   *
+   * @param group         Group number.
+   * @param destination   Offset in the group's data area to copy to.
+   */
+  void moveImages(const std::uint32_t group, const std::uint64_t destination);
+
+  /**
+   * Returns the checksum of a page: a CRC-32C of the page's header, less the
+   * field the checksum is stored in, followed by its data.
+   *
+   * @param page  Page to checksum.
+   */
+  static std::uint32_t pageChecksum(const Page& page);
+
+  /**
+   * Returns the header for this file.  The header is cached in the file's
+   * handle, so this does not touch the disk.
    *
    * @return  The file header.
    */
-  FileHeader readHeader() const;
+  FileHeader readHeader() const { return handle_->header(); }
 
   /**
-   * Writes the given header to the disk as the header for this file.
+   * Replaces the header for this file.  The cached header is shared by every
+   * File object for the file and is written back to disk when the file is
+   * synced or closed.
    *
    * @param header  File header to write.
    */
-  void writeHeader(const FileHeader& header);
+  void writeHeader(const FileHeader& header) { handle_->setHeader(header); }
 
   /**
-   * Reads only the header of the given page from disk (not the record data
-   * or slot table).  No bounds checking is performed.
+   * Loads the header and allocation bitmap of a newly opened file into
+   * <handle>.  Files in the unversioned legacy format are upgraded first, in
+   * which case <handle> is replaced by one for the upgraded file.
    *
-   * @param page_number   Number of page whose header is to be read.
-   * @return  Header of page.
+   * @param name    Name of file.
+   * @param handle  Handle of the newly opened file.
    */
-  PageHeader readPageHeader(const PageId page_number) const;
+  static void loadMetadata(const std::string& name,
+                           std::shared_ptr<FileHandle>& handle);
 
-  typedef std::map<std::string,
-                   std::shared_ptr<std::fstream> > StreamMap;
-  typedef std::map<std::string, int> CountMap;
+  /**
+   * Writes the bitmap word holding the given page's bit back to disk.
+   *
+   * @param page_number   Number of page whose allocation state changed.
+   */
+  void writeAllocationWord(const PageId page_number);
+
+  /**
+   * Returns the next used page after the given one, or Page::INVALID_NUMBER.
+   *
+   * @param page_number   Page to start after.
+   */
+  PageId nextUsedPage(const PageId page_number) const {
+    return handle_->allocationMap().nextUsed(page_number);
+  }
+
+  /**
+   * Rewrites a file in the unversioned legacy layout (a 16-byte header
+   * followed directly by the pages, with used and free pages chained through
+   * their headers) into the version 1 layout.  The upgraded copy replaces
+   * the original only once it is complete and synced; the constructor then
+   * brings it up to date with upgradePages().
+   *
+   * @param filename  Name of the file to upgrade.
+   */
+  static void upgradeLegacyFile(const std::string& filename);
+
+  /**
+   * Rewrites the used pages of a file written by an older format version,
+   * then records the current version in the file header.  Rewriting a page
+   * twice does no harm, so an upgrade cut short by a crash is simply redone
+   * on the next open.
+   *
+   * Version 1 pages keep the free space lower bound where PageHeader now
+   * keeps PageHeader::fragmented_space; their records are contiguous, so the
+   * field is cleared.  Pages before version 3 keep a count of free slots
+   * where PageHeader now keeps the head of the free slot chain, so the chain
+   * is built.
+   */
+  void upgradePages();
 
   /**
-   * Streams for opened files.
+   * Handles and reference counts of opened files.
    */
-  static StreamMap open_streams_;
+  static FileRegistry registry_;
 
   /**
-   * Counts for opened files.
+   * Listeners told when a file is closed or compacted.
    */
-  static CountMap open_counts_;
+  static std::vector<FileCloseListener*> close_listeners_;
 
   /**
-   * Name of the file this object represents.
+   * Id of the open file this object represents.
    */
-  std::string filename_;
+  FileId file_id_;
 
   /**
-   * Stream for underlying filesystem object.
+   * Handle for underlying filesystem object.
    */
-  std::shared_ptr<std::fstream> stream_;
+  std::shared_ptr<FileHandle> handle_;
 
   friend class FileIterator;
   friend class FileTest;
@@ -0,0 +1,395 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "file_handle.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <climits>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#include "exceptions/io_exception.h"
+#include "page.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Largest number of buffers passed to one preadv/pwritev call.
+ */
+#ifdef IOV_MAX
+const std::size_t MAX_IOVECS = IOV_MAX;
+#else
+const std::size_t MAX_IOVECS = 1024;
+#endif
+
+/**
+ * Returns the total length of the <count> buffers of <buffers>.
+ */
+std::uint64_t totalLength(const struct iovec* buffers, const std::size_t count) {
+  std::uint64_t total = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    total += buffers[i].iov_len;
+  }
+  return total;
+}
+
+}
+
+FileHandle::FileHandle(const std::string& filename, const bool create_new)
+    : filename_(filename),
+      descriptor_(filename),
+      reserved_bytes_(0),
+      punch_holes_(false),
+      read_latency_us_(0),
+      write_latency_us_(0),
+      header_dirty_(false) {
+  durability_.mode = DURABILITY_NONE;
+  durability_.group_commit_bytes = 0;
+  durability_.group_commit_interval_ms = 0;
+  // Grow in 1 MB extents by default.
+  growth_.extent_pages = (1 << 20) / Page::SIZE;
+  growth_.doubling = false;
+  growth_.max_extent_pages = 0;
+
+  int flags = O_RDWR | O_CLOEXEC;
+  if (create_new) {
+    flags |= O_CREAT | O_TRUNC;
+  }
+  DescriptorCache::shared().open(descriptor_, flags);
+  struct stat file_stat;
+  int result;
+  {
+    DescriptorCache::Lease lease(descriptor_);
+    result = ::fstat(lease.fd(), &file_stat);
+  }
+  if (result != 0) {
+    const int error = errno;
+    DescriptorCache::shared().close(descriptor_);
+    throw IoException(filename_, "fstat", error);
+  }
+  reserved_bytes_ = file_stat.st_size;
+}
+
+FileHandle::~FileHandle() {
+  // Nowhere to report a failure from a destructor; callers who need to know
+  // must call sync() themselves before letting go of the file.
+  try {
+    flushHeader();
+  } catch (const IoException&) {
+  }
+  if (durability_.mode != DURABILITY_NONE) {
+    try {
+      DescriptorCache::Lease lease(descriptor_);
+      sync_.syncAll(lease.fd());
+    } catch (const IoException&) {
+    }
+  }
+  DescriptorCache::shared().close(descriptor_);
+}
+
+void FileHandle::read(const std::uint64_t offset, void* buffer,
+                      const std::size_t length) const {
+  char* dest = static_cast<char*>(buffer);
+  if (read_latency_us_ > 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(read_latency_us_));
+  }
+  DescriptorCache::Lease lease(descriptor_);
+  std::size_t done = 0;
+  while (done < length) {
+    const ssize_t result = ::pread(lease.fd(), dest + done, length - done,
+                                   static_cast<off_t>(offset + done));
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw IoException(filename_, "read", errno);
+    }
+    if (result == 0) {
+      // Past the end of the file.
+      std::memset(dest + done, 0, length - done);
+      break;
+    }
+    done += result;
+  }
+}
+
+void FileHandle::write(const std::uint64_t offset, const void* buffer,
+                       const std::size_t length) {
+  const char* src = static_cast<const char*>(buffer);
+  if (write_latency_us_ > 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(write_latency_us_));
+  }
+  DescriptorCache::Lease lease(descriptor_);
+  std::size_t done = 0;
+  while (done < length) {
+    const ssize_t result = ::pwrite(lease.fd(), src + done, length - done,
+                                    static_cast<off_t>(offset + done));
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw IoException(filename_, "write", errno);
+    }
+    done += result;
+  }
+  extendTo(offset + length);
+  sync_.noteWrite(length);
+}
+
+void FileHandle::readVector(const std::uint64_t offset,
+                            const struct iovec* buffers,
+                            const std::size_t count) const {
+  // Work on a copy so that short reads can advance into a buffer.
+  std::vector<struct iovec> pending(buffers, buffers + count);
+  if (read_latency_us_ > 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(read_latency_us_));
+  }
+  DescriptorCache::Lease lease(descriptor_);
+  std::uint64_t position = offset;
+  std::size_t first = 0;
+  while (first < pending.size()) {
+    const std::size_t batch = std::min(pending.size() - first, MAX_IOVECS);
+    const ssize_t result = ::preadv(lease.fd(), &pending[first],
+                                    static_cast<int>(batch),
+                                    static_cast<off_t>(position));
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw IoException(filename_, "read", errno);
+    }
+    if (result == 0) {
+      // Past the end of the file.
+      for (; first < pending.size(); ++first) {
+        std::memset(pending[first].iov_base, 0, pending[first].iov_len);
+      }
+      break;
+    }
+    position += result;
+    std::size_t done = result;
+    while (first < pending.size() && done >= pending[first].iov_len) {
+      done -= pending[first].iov_len;
+      ++first;
+    }
+    if (done > 0) {
+      pending[first].iov_base = static_cast<char*>(pending[first].iov_base) + done;
+      pending[first].iov_len -= done;
+    }
+  }
+}
+
+void FileHandle::writeVector(const std::uint64_t offset,
+                             const struct iovec* buffers,
+                             const std::size_t count) {
+  std::vector<struct iovec> pending(buffers, buffers + count);
+  if (write_latency_us_ > 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(write_latency_us_));
+  }
+  DescriptorCache::Lease lease(descriptor_);
+  std::uint64_t position = offset;
+  std::size_t first = 0;
+  while (first < pending.size()) {
+    const std::size_t batch = std::min(pending.size() - first, MAX_IOVECS);
+    const ssize_t result = ::pwritev(lease.fd(), &pending[first],
+                                     static_cast<int>(batch),
+                                     static_cast<off_t>(position));
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw IoException(filename_, "write", errno);
+    }
+    position += result;
+    std::size_t done = result;
+    while (first < pending.size() && done >= pending[first].iov_len) {
+      done -= pending[first].iov_len;
+      ++first;
+    }
+    if (done > 0) {
+      pending[first].iov_base = static_cast<char*>(pending[first].iov_base) + done;
+      pending[first].iov_len -= done;
+    }
+  }
+  const std::uint64_t length = totalLength(buffers, count);
+  extendTo(offset + length);
+  sync_.noteWrite(length);
+}
+
+void FileHandle::reserve(const std::uint64_t end) {
+  const std::uint64_t reserved = reserved_bytes_;
+  if (end <= reserved) {
+    return;
+  }
+  std::uint64_t extent = std::uint64_t(growth_.extent_pages) * Page::SIZE;
+  if (growth_.doubling && reserved > extent) {
+    extent = reserved;
+    if (growth_.max_extent_pages > 0) {
+      extent = std::min(extent,
+                        std::uint64_t(growth_.max_extent_pages) * Page::SIZE);
+    }
+  }
+  // Extents always cover at least the requested range.
+  const std::uint64_t new_end = std::max(end, reserved + extent);
+  const off_t offset = static_cast<off_t>(reserved);
+  const off_t length = static_cast<off_t>(new_end - reserved);
+  DescriptorCache::Lease lease(descriptor_);
+  if (::fallocate(lease.fd(), 0 /* mode */, offset, length) != 0) {
+    if (errno != EOPNOTSUPP && errno != ENOSYS) {
+      throw IoException(filename_, "fallocate", errno);
+    }
+    // The filesystem can't preallocate; settle for extending the size in one
+    // step, which still saves a size update per appended page.
+    if (::ftruncate(lease.fd(), offset + length) != 0) {
+      throw IoException(filename_, "ftruncate", errno);
+    }
+  }
+  extendTo(new_end);
+}
+
+void FileHandle::extendTo(const std::uint64_t end) {
+  std::uint64_t reserved = reserved_bytes_;
+  while (reserved < end &&
+         !reserved_bytes_.compare_exchange_weak(reserved, end)) {
+  }
+}
+
+bool FileHandle::punchHole(const std::uint64_t offset,
+                           const std::uint64_t length) {
+  DescriptorCache::Lease lease(descriptor_);
+  if (::fallocate(lease.fd(), FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                  static_cast<off_t>(offset), static_cast<off_t>(length)) != 0) {
+    if (errno == EOPNOTSUPP || errno == ENOSYS) {
+      return false;
+    }
+    throw IoException(filename_, "fallocate", errno);
+  }
+  sync_.noteWrite(0);
+  return true;
+}
+
+std::uint64_t FileHandle::nextData(const std::uint64_t offset,
+                                   const std::uint64_t end) const {
+  DescriptorCache::Lease lease(descriptor_);
+  const off_t data = ::lseek(lease.fd(), static_cast<off_t>(offset), SEEK_DATA);
+  if (data < 0) {
+    if (errno == ENXIO) {
+      // Nothing but holes from <offset> to the end of the file.
+      return end;
+    }
+    if (errno == EINVAL) {
+      return offset;
+    }
+    throw IoException(filename_, "lseek", errno);
+  }
+  return std::min(static_cast<std::uint64_t>(data), end);
+}
+
+std::uint64_t FileHandle::nextHole(const std::uint64_t offset,
+                                   const std::uint64_t end) const {
+  DescriptorCache::Lease lease(descriptor_);
+  const off_t hole = ::lseek(lease.fd(), static_cast<off_t>(offset), SEEK_HOLE);
+  if (hole < 0) {
+    if (errno == ENXIO || errno == EINVAL) {
+      return end;
+    }
+    throw IoException(filename_, "lseek", errno);
+  }
+  return std::min(static_cast<std::uint64_t>(hole), end);
+}
+
+void FileHandle::truncate(const std::uint64_t size) {
+  DescriptorCache::Lease lease(descriptor_);
+  if (::ftruncate(lease.fd(), static_cast<off_t>(size)) != 0) {
+    throw IoException(filename_, "ftruncate", errno);
+  }
+  reserved_bytes_ = size;
+  sync_.noteWrite(0);
+}
+
+std::uint64_t FileHandle::diskUsage() const {
+  struct stat file_stat;
+  DescriptorCache::Lease lease(descriptor_);
+  if (::fstat(lease.fd(), &file_stat) != 0) {
+    throw IoException(filename_, "fstat", errno);
+  }
+  // st_blocks is always in 512-byte units.
+  return std::uint64_t(file_stat.st_blocks) * 512;
+}
+
+void FileHandle::commit() {
+  bool needs_sync = false;
+  switch (durability_.mode) {
+    case DURABILITY_NONE:
+      break;
+    case DURABILITY_PER_WRITE:
+      needs_sync = true;
+      break;
+    case DURABILITY_GROUP_COMMIT:
+      if (durability_.group_commit_bytes > 0 &&
+          sync_.unsyncedBytes() >= durability_.group_commit_bytes) {
+        needs_sync = true;
+      } else if (durability_.group_commit_interval_ms > 0 &&
+                 sync_.timeSinceSync() >= std::chrono::milliseconds(
+                     durability_.group_commit_interval_ms)) {
+        needs_sync = true;
+      }
+      break;
+  }
+  if (needs_sync) {
+    sync();
+  }
+}
+
+void FileHandle::sync() {
+  flushHeader();
+  DescriptorCache::Lease lease(descriptor_);
+  const int result = sync_.syncAll(lease.fd());
+  if (result != 0) {
+    throw IoException(filename_, "fdatasync", result);
+  }
+}
+
+bool FileHandle::isDurable() const {
+  std::lock_guard<std::mutex> lock(header_mutex_);
+  return !header_dirty_ &&
+      sync_.durableSequence() == sync_.writtenSequence();
+}
+
+void FileHandle::loadHeader() {
+  std::lock_guard<std::mutex> lock(header_mutex_);
+  read(0 /* offset */, &header_, sizeof(header_));
+  header_dirty_ = false;
+}
+
+FileHeader FileHandle::header() const {
+  std::lock_guard<std::mutex> lock(header_mutex_);
+  return header_;
+}
+
+void FileHandle::setHeader(const FileHeader& header) {
+  std::lock_guard<std::mutex> lock(header_mutex_);
+  header_ = header;
+  header_dirty_ = true;
+}
+
+void FileHandle::flushHeader() {
+  std::lock_guard<std::mutex> lock(header_mutex_);
+  if (header_dirty_) {
+    write(0 /* offset */, &header_, sizeof(header_));
+    header_dirty_ = false;
+  }
+}
+
+}
@@ -0,0 +1,475 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <sys/uio.h>
+
+#include "allocation_map.h"
+#include "descriptor_cache.h"
+#include "file_header.h"
+#include "page_offset_map.h"
+#include "sync_coordinator.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief How eagerly writes to a file are made durable.
+ *
+ * A write is <i>written</i> once File returns from the call that issued it:
+ * the bytes are in the operating system and visible to every reader, but
+ * may be lost if the machine crashes.  It is <i>durable</i> once an
+ * fdatasync covering it has completed.
+ */
+enum DurabilityMode {
+  /**
+   * Writes are never synced by BadgerDB except through an explicit
+   * File::sync().  A crash may lose any write not covered by such a call.
+   * This matches the historical behaviour of flushing each write to the
+   * operating system.
+   */
+  DURABILITY_NONE,
+
+  /**
+   * Every mutating File call (writePage, allocatePage, deletePage) is durable
+   * before it returns.  Nothing acknowledged is lost on a crash.
+   */
+  DURABILITY_PER_WRITE,
+
+  /**
+   * Writes are synced in groups.  After each mutating File call the file is
+   * synced if more than <group_commit_bytes> bytes have been written or more
+   * than <group_commit_interval_ms> milliseconds have passed since the last
+   * sync.  A crash loses at most the writes inside the current window; the
+   * window is only checked when a write happens, so an idle file keeps its
+   * tail unsynced until the next write, an explicit File::sync(), or the last
+   * File object for it is destroyed.
+   */
+  DURABILITY_GROUP_COMMIT
+};
+
+/**
+ * @brief Durability settings for an open file.
+ */
+struct DurabilityPolicy {
+  /**
+   * When writes are synced.
+   */
+  DurabilityMode mode;
+
+  /**
+   * Group commit: sync once this many bytes are unsynced (0 disables the
+   * byte window).
+   */
+  std::uint64_t group_commit_bytes;
+
+  /**
+   * Group commit: sync once the last sync is this many milliseconds old
+   * (0 disables the time window).
+   */
+  std::uint32_t group_commit_interval_ms;
+};
+
+/**
+ * @brief How a file reserves disk space as it grows.
+ *
+ * Rather than extending the file by one page per appended page, the file is
+ * grown in extents with fallocate.  Pages inside the reserved extent but past
+ * the last allocated page are handed out by File::allocatePage without
+ * changing the file's size or allocating filesystem blocks.
+ */
+struct GrowthPolicy {
+  /**
+   * Minimum number of pages reserved by each growth step.  A value of 0 or 1
+   * disables preallocation, so the file grows one page at a time.
+   */
+  PageId extent_pages;
+
+  /**
+   * Whether each growth step reserves as much space again as the file
+   * already holds (bounded below by <extent_pages> and above by
+   * <max_extent_pages>), rather than a fixed <extent_pages>.
+   */
+  bool doubling;
+
+  /**
+   * Upper bound on the pages reserved by one doubling step (0 for no bound).
+   */
+  PageId max_extent_pages;
+};
+
+/**
+ * @brief An open file on disk, shared by all File objects for that file.
+ *
+ * Performs positioned reads and writes on the file and applies the
+ * file's DurabilityPolicy, routing every fdatasync through a SyncCoordinator
+ * so that concurrent sync requests are merged.  Also holds the in-memory
+ * metadata File keeps for the open file: its AllocationMap and a cached copy
+ * of its FileHeader.
+ *
+ * The cached header is written back to disk lazily: whenever the file is
+ * synced (explicitly or by the durability policy) and when the handle is
+ * closed.  Until then the header on disk may lag behind the cached one, so a
+ * crash between syncs can also lose header updates (such as newly appended
+ * pages) made in that window.
+ *
+ * The descriptor itself lives in the shared DescriptorCache, which may close
+ * it while the file is idle; every system call pins it through a lease,
+ * re-opening the file if needed.
+ *
+ * @warning Apart from sync(), this class is not threadsafe.
+ */
+class FileHandle {
+ public:
+  /**
+   * Opens (or creates and truncates) the named file.
+   *
+   * @param filename    Name of the file.
+   * @param create_new  Whether to create the file, truncating any contents.
+   * @throws  IoException   If the file could not be opened.
+   */
+  FileHandle(const std::string& filename, const bool create_new);
+
+  /**
+   * Writes back the cached header and closes the descriptor, if open.  Unless the
+   * durability mode is DURABILITY_NONE, outstanding writes are synced first.
+   */
+  ~FileHandle();
+
+  /**
+   * Reads <length> bytes at <offset> into <buffer>.  Bytes past the end of
+   * the file read as zeros.
+   *
+   * @throws  IoException   If the read fails.
+   */
+  void read(const std::uint64_t offset, void* buffer,
+            const std::size_t length) const;
+
+  /**
+   * Writes <length> bytes from <buffer> at <offset>.  The write is not
+   * durable until commit() or sync() says so.
+   *
+   * @throws  IoException   If the write fails.
+   */
+  void write(const std::uint64_t offset, const void* buffer,
+             const std::size_t length);
+
+  /**
+   * Reads <length> bytes at <offset> scattered into the <count> buffers of
+   * <buffers>, in order, using as few preadv calls as possible.  Bytes past
+   * the end of the file read as zeros.
+   *
+   * @throws  IoException   If the read fails.
+   */
+  void readVector(const std::uint64_t offset, const struct iovec* buffers,
+                  const std::size_t count) const;
+
+  /**
+   * Writes the <count> buffers of <buffers>, in order, as one contiguous
+   * range starting at <offset>, using as few pwritev calls as possible.  The
+   * write is not durable until commit() or sync() says so.
+   *
+   * @throws  IoException   If the write fails.
+   */
+  void writeVector(const std::uint64_t offset, const struct iovec* buffers,
+                   const std::size_t count);
+
+  /**
+   * Marks the end of one logical write (a File call which may have issued
+   * several writes) and syncs if the durability policy asks for it.
+   *
+   * @throws  IoException   If a required sync fails.
+   */
+  void commit();
+
+  /**
+   * Writes back the cached header and makes every write issued so far
+   * durable, regardless of policy.  Concurrent callers share fdatasync calls.
+   *
+   * @throws  IoException   If the sync fails.
+   */
+  void sync();
+
+  /**
+   * Returns true if every write issued so far is durable.
+   */
+  bool isDurable() const;
+
+  /**
+   * Returns the durability policy in effect.
+   */
+  const DurabilityPolicy& durability() const { return durability_; }
+
+  /**
+   * Replaces the durability policy.  Switching to a stricter mode does not
+   * sync writes already issued; call sync() for that.
+   *
+   * @param policy  New policy.
+   */
+  void setDurability(const DurabilityPolicy& policy) { durability_ = policy; }
+
+  /**
+   * Returns the growth policy in effect.
+   */
+  const GrowthPolicy& growth() const { return growth_; }
+
+  /**
+   * Replaces the growth policy.  Space already reserved is kept.
+   *
+   * @param policy  New policy.
+   */
+  void setGrowth(const GrowthPolicy& policy) { growth_ = policy; }
+
+  /**
+   * Makes sure the first <end> bytes of the file are backed by allocated
+   * space, growing the file by whole extents as the growth policy dictates.
+   * Does nothing (and makes no system call) if they already are.
+   *
+   * @param end   Offset up to which space must be reserved.
+   * @throws  IoException   If the file could not be grown.
+   */
+  void reserve(const std::uint64_t end);
+
+  /**
+   * Returns the number of bytes of the file backed by reserved space.
+   */
+  std::uint64_t reservedBytes() const { return reserved_bytes_; }
+
+  /**
+   * Returns whether deleted pages are reclaimed by punching holes.
+   */
+  bool punchHoles() const { return punch_holes_; }
+
+  /**
+   * Sets whether deleted pages are reclaimed by punching holes.
+   *
+   * @param punch_holes   True to punch holes for deleted pages.
+   */
+  void setPunchHoles(const bool punch_holes) { punch_holes_ = punch_holes; }
+
+  /**
+   * Returns the delay added to every read, in microseconds.
+   */
+  std::uint32_t readLatency() const { return read_latency_us_; }
+
+  /**
+   * Adds a fixed delay to every read, to stand in for slow storage when
+   * testing.  0 turns the delay off.
+   *
+   * @param micros  Delay per read call, in microseconds.
+   */
+  void setReadLatency(const std::uint32_t micros) { read_latency_us_ = micros; }
+
+  /**
+   * Returns the delay added to every write, in microseconds.
+   */
+  std::uint32_t writeLatency() const { return write_latency_us_; }
+
+  /**
+   * Adds a fixed delay to every write, to stand in for slow storage when
+   * testing.  0 turns the delay off.
+   *
+   * @param micros  Delay per write call, in microseconds.
+   */
+  void setWriteLatency(const std::uint32_t micros) {
+    write_latency_us_ = micros;
+  }
+
+  /**
+   * Deallocates the disk blocks backing <length> bytes at <offset>, leaving a
+   * hole that reads as zeros.  The file size does not change.
+   *
+   * @return  True if the hole was punched; false if the filesystem does not
+   *          support punching holes.
+   * @throws  IoException   If punching fails for any other reason.
+   */
+  bool punchHole(const std::uint64_t offset, const std::uint64_t length);
+
+  /**
+   * Returns the offset of the first byte from <offset> on that is backed by
+   * disk blocks, or <end> if every byte up to <end> lies in a hole.  Where
+   * the filesystem cannot tell holes apart, every byte counts as backed.
+   *
+   * @throws  IoException   If the file could not be examined.
+   */
+  std::uint64_t nextData(const std::uint64_t offset,
+                         const std::uint64_t end) const;
+
+  /**
+   * Returns the offset of the first byte from <offset> on that lies in a
+   * hole, or <end> if every byte up to <end> is backed by disk blocks.
+   *
+   * @throws  IoException   If the file could not be examined.
+   */
+  std::uint64_t nextHole(const std::uint64_t offset,
+                         const std::uint64_t end) const;
+
+  /**
+   * Truncates the file to <size> bytes, giving up any space reserved beyond
+   * it.
+   *
+   * @throws  IoException   If the file could not be truncated.
+   */
+  void truncate(const std::uint64_t size);
+
+  /**
+   * Returns the number of bytes of disk space actually allocated to the file.
+   *
+   * @throws  IoException   If the file could not be examined.
+   */
+  std::uint64_t diskUsage() const;
+
+  /**
+   * Returns the sync coordinator for this descriptor.
+   */
+  const SyncCoordinator& syncCoordinator() const { return sync_; }
+
+  /**
+   * Reads the file header from disk into the cache, discarding any cached
+   * changes.
+   *
+   * @throws  IoException   If the read fails.
+   */
+  void loadHeader();
+
+  /**
+   * Returns a copy of the cached file header.  The copy is taken under the
+   * header's lock, so it may be called while another thread replaces the
+   * header.
+   */
+  FileHeader header() const;
+
+  /**
+   * Replaces the cached file header.  The new header reaches disk the next
+   * time the file is synced or closed.
+   *
+   * @param header  New header.
+   */
+  void setHeader(const FileHeader& header);
+
+  /**
+   * Writes the cached header to disk if it has changed since it was last
+   * written.  Does not sync.
+   *
+   * @throws  IoException   If the write fails.
+   */
+  void flushHeader();
+
+  /**
+   * Returns the in-memory allocation bitmap of the file.
+   */
+  AllocationMap& allocationMap() { return allocation_map_; }
+
+  /**
+   * Returns the in-memory allocation bitmap of the file.
+   */
+  const AllocationMap& allocationMap() const { return allocation_map_; }
+
+  /**
+   * Returns the in-memory page-offset map of a compressed file.
+   */
+  PageOffsetMap& offsetMap() { return offset_map_; }
+
+  /**
+   * Returns the in-memory page-offset map of a compressed file.
+   */
+  const PageOffsetMap& offsetMap() const { return offset_map_; }
+
+ private:
+  /**
+   * Name of the underlying file, for error reporting.
+   */
+  std::string filename_;
+
+  /**
+   * The file's entry in the shared descriptor cache.  Mutable because
+   * const reads may have to re-open the descriptor.
+   */
+  mutable DescriptorCache::Slot descriptor_;
+
+  /**
+   * Durability policy applied by commit().
+   */
+  DurabilityPolicy durability_;
+
+  /**
+   * Growth policy applied by reserve().
+   */
+  GrowthPolicy growth_;
+
+  /**
+   * Size of the file, including space reserved but not yet written.  Atomic
+   * since writes of existing pages may run alongside growth (see
+   * PageImageWrite).
+   */
+  std::atomic<std::uint64_t> reserved_bytes_;
+
+  /**
+   * Whether deleted pages are reclaimed by punching holes.
+   */
+  bool punch_holes_;
+
+  /**
+   * Delay added to every read, in microseconds.
+   */
+  std::uint32_t read_latency_us_;
+
+  /**
+   * Delay added to every write, in microseconds.
+   */
+  std::uint32_t write_latency_us_;
+
+  /**
+   * Merges fdatasync calls on the file.
+   */
+  SyncCoordinator sync_;
+
+  /**
+   * Which pages of the file are in use; loaded by File when the file is
+   * opened and kept in step with the bitmap pages on disk.
+   */
+  AllocationMap allocation_map_;
+
+  /**
+   * Where each page of a compressed file is stored; loaded by File when the
+   * file is opened and kept in step with the map pages on disk.  Empty for
+   * other files.
+   */
+  PageOffsetMap offset_map_;
+
+  /**
+   * Cached copy of the file header.
+   */
+  FileHeader header_;
+
+  /**
+   * Whether <header_> differs from the header on disk.
+   */
+  bool header_dirty_;
+
+  /**
+   * Guards <header_> and <header_dirty_>: copies in and out of the cache,
+   * and write-back by concurrent sync() callers.
+   */
+  mutable std::mutex header_mutex_;
+
+  /**
+   * Raises <reserved_bytes_> to <end> if it is below it.
+   */
+  void extendTo(const std::uint64_t end);
+
+  FileHandle(const FileHandle&);
+  FileHandle& operator=(const FileHandle&);
+};
+
+}
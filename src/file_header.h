@@ -0,0 +1,83 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Header metadata for files on disk which contain pages.
+ */
+struct FileHeader {
+  /**
+   * Identifies the file as a BadgerDB file in the current format.  Files
+   * written before the format was versioned have no magic number; see
+   * File::open().
+   */
+  std::uint32_t magic;
+
+  /**
+   * Version of the on-disk format.
+   */
+  std::uint32_t version;
+
+  /**
+   * Number of pages allocated in the file.
+   */
+  PageId num_pages;
+
+  /**
+   * Page number of the first used page in the file.
+   */
+  PageId first_used_page;
+
+  /**
+   * Number of free pages (allocated but unused) in the file.
+   */
+  PageId num_free_pages;
+
+  /**
+   * Page number of the first free (allocated but unused) page in the file.
+   */
+  PageId first_free_page;
+
+  /**
+   * Options stored with the file; see File::FLAG_CHECKSUMS.  Zero in files
+   * written before the field was added.
+   */
+  std::uint32_t flags;
+
+  /**
+   * Length of every record in a file of fixed-length records, whose pages
+   * are accessed through FixedPage; zero in files of variable-length records
+   * (and in files written before the field was added).
+   */
+  std::uint32_t record_size;
+
+  /**
+   * Returns true if this file header is equal to the other.
+   *
+   * @param rhs   Other file header to compare against.
+   * @return  True if the other header is equal to this one.
+   */
+  bool operator==(const FileHeader& rhs) const {
+    return magic == rhs.magic &&
+        version == rhs.version &&
+        num_pages == rhs.num_pages &&
+        num_free_pages == rhs.num_free_pages &&
+        first_used_page == rhs.first_used_page &&
+        first_free_page == rhs.first_free_page &&
+        flags == rhs.flags &&
+        record_size == rhs.record_size;
+  }
+};
+
+}
@@ -0,0 +1,126 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "file_page_cache.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace badgerdb {
+
+const FilePageCache::Key FilePageCache::EMPTY;
+
+FilePageCache::FilePageCache(const std::string& filename,
+                             const std::uint32_t capacity)
+    : filename_(filename),
+      handle_(new FileHandle(filename, true /* create_new */)),
+      slots_(capacity),
+      clock_hand_(0) {
+  std::memset(&stats_, 0, sizeof(stats_));
+  handle_->reserve(std::uint64_t(capacity) * Page::SIZE);
+  free_slots_.reserve(capacity);
+  for (std::uint32_t slot = capacity; slot > 0; --slot) {
+    slots_[slot - 1].key = EMPTY;
+    slots_[slot - 1].referenced = false;
+    free_slots_.push_back(slot - 1);
+  }
+}
+
+FilePageCache::~FilePageCache() {
+  handle_.reset();
+  std::remove(filename_.c_str());
+}
+
+void FilePageCache::store(const FileId file_id, const PageId page_number,
+                          const Page& page) {
+  if (slots_.empty()) {
+    return;
+  }
+  const Key key = keyOf(file_id, page_number);
+  std::unordered_map<Key, std::uint32_t>::const_iterator it = index_.find(key);
+  std::uint32_t slot;
+  if (it != index_.end()) {
+    // Overwrite the stale copy in place.
+    slot = it->second;
+    release(slot);
+  } else {
+    slot = takeSlot();
+  }
+  try {
+    handle_->write(std::uint64_t(slot) * Page::SIZE, &page, Page::SIZE);
+  } catch (...) {
+    free_slots_.push_back(slot);
+    throw;
+  }
+  slots_[slot].key = key;
+  slots_[slot].referenced = true;
+  index_[key] = slot;
+  ++stats_.pages;
+  ++stats_.stores;
+}
+
+bool FilePageCache::fetch(const FileId file_id, const PageId page_number,
+                          Page& page) {
+  std::unordered_map<Key, std::uint32_t>::const_iterator it =
+      index_.find(keyOf(file_id, page_number));
+  if (it == index_.end()) {
+    ++stats_.misses;
+    return false;
+  }
+  const std::uint32_t slot = it->second;
+  handle_->read(std::uint64_t(slot) * Page::SIZE, &page, Page::SIZE);
+  release(slot);
+  free_slots_.push_back(slot);
+  ++stats_.hits;
+  return true;
+}
+
+void FilePageCache::invalidate(const FileId file_id,
+                               const PageId page_number) {
+  std::unordered_map<Key, std::uint32_t>::const_iterator it =
+      index_.find(keyOf(file_id, page_number));
+  if (it != index_.end()) {
+    const std::uint32_t slot = it->second;
+    release(slot);
+    free_slots_.push_back(slot);
+  }
+}
+
+void FilePageCache::invalidateFile(const FileId file_id) {
+  for (std::uint32_t slot = 0; slot < slots_.size(); ++slot) {
+    if (slots_[slot].key != EMPTY && slots_[slot].key >> 32 == file_id) {
+      release(slot);
+      free_slots_.push_back(slot);
+    }
+  }
+}
+
+std::uint32_t FilePageCache::takeSlot() {
+  if (!free_slots_.empty()) {
+    const std::uint32_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    return slot;
+  }
+  while (slots_[clock_hand_].referenced) {
+    slots_[clock_hand_].referenced = false;
+    clock_hand_ = (clock_hand_ + 1) % slots_.size();
+  }
+  const std::uint32_t slot = clock_hand_;
+  clock_hand_ = (clock_hand_ + 1) % slots_.size();
+  release(slot);
+  ++stats_.evictions;
+  return slot;
+}
+
+void FilePageCache::release(const std::uint32_t slot) {
+  index_.erase(slots_[slot].key);
+  slots_[slot].key = EMPTY;
+  slots_[slot].referenced = false;
+  --stats_.pages;
+}
+
+}
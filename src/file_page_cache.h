@@ -0,0 +1,177 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "file_handle.h"
+#include "page_cache_tier.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Counters of a FilePageCache.
+ */
+struct FilePageCacheStats {
+  /**
+   * Lookups that found their page.
+   */
+  std::uint64_t hits;
+
+  /**
+   * Lookups that did not.
+   */
+  std::uint64_t misses;
+
+  /**
+   * Pages written to the cache file.
+   */
+  std::uint64_t stores;
+
+  /**
+   * Pages dropped to make room for others.
+   */
+  std::uint64_t evictions;
+
+  /**
+   * Pages held right now.
+   */
+  std::size_t pages;
+};
+
+/**
+ * @brief Second-tier cache that spills evicted pages to a local cache file.
+ *
+ * Meant for a fast local volume in front of data files on slow storage.  The
+ * cache file is divided into <capacity> page-sized slots.  An in-memory index
+ * maps each cached (file, page) to its slot, and each slot records the page
+ * it holds and a reference bit; when every slot is taken, a clock sweep over
+ * the reference bits picks the slot to reuse.  The cache file is scratch
+ * space: it is created empty and deleted when the cache is destroyed, and
+ * its contents do not survive a restart.
+ *
+ * @warning This class is not threadsafe; BufMgr calls it with its pool lock
+ * held.
+ */
+class FilePageCache : public PageCacheTier {
+ public:
+  /**
+   * Creates (or truncates) the cache file and sizes it for <capacity> pages.
+   *
+   * @param filename  Name of the cache file.
+   * @param capacity  Number of pages the cache can hold.
+   * @throws  IoException   If the cache file could not be created.
+   */
+  FilePageCache(const std::string& filename, const std::uint32_t capacity);
+
+  /**
+   * Closes and deletes the cache file.
+   */
+  ~FilePageCache();
+
+  void store(const FileId file_id, const PageId page_number,
+             const Page& page);
+
+  bool fetch(const FileId file_id, const PageId page_number, Page& page);
+
+  void invalidate(const FileId file_id, const PageId page_number);
+
+  void invalidateFile(const FileId file_id);
+
+  /**
+   * Returns the number of pages the cache can hold.
+   */
+  std::uint32_t capacity() const { return slots_.size(); }
+
+  /**
+   * Returns the cache's counters.
+   */
+  const FilePageCacheStats& stats() const { return stats_; }
+
+ private:
+  /**
+   * Key of a page: its file id in the high half and page number in the low.
+   */
+  typedef std::uint64_t Key;
+
+  /**
+   * Key of a slot that holds no page.  No page has number 0.
+   */
+  static const Key EMPTY = 0;
+
+  /**
+   * What a slot of the cache file holds.
+   */
+  struct Slot {
+    /**
+     * Page in the slot, or EMPTY.
+     */
+    Key key;
+
+    /**
+     * Set when the slot is stored to; cleared by the clock sweep.
+     */
+    bool referenced;
+  };
+
+  static Key keyOf(const FileId file_id, const PageId page_number) {
+    return (static_cast<Key>(file_id) << 32) | page_number;
+  }
+
+  /**
+   * Returns a slot to store a new page in, evicting a page if none is free.
+   */
+  std::uint32_t takeSlot();
+
+  /**
+   * Empties <slot> and removes its page from the index.
+   */
+  void release(const std::uint32_t slot);
+
+  /**
+   * Name of the cache file.
+   */
+  std::string filename_;
+
+  /**
+   * The open cache file.
+   */
+  std::unique_ptr<FileHandle> handle_;
+
+  /**
+   * Slot of every cached page.
+   */
+  std::unordered_map<Key, std::uint32_t> index_;
+
+  /**
+   * What each slot holds.
+   */
+  std::vector<Slot> slots_;
+
+  /**
+   * Slots holding no page.
+   */
+  std::vector<std::uint32_t> free_slots_;
+
+  /**
+   * Next slot the clock sweep looks at.
+   */
+  std::uint32_t clock_hand_;
+
+  /**
+   * Counters.
+   */
+  FilePageCacheStats stats_;
+};
+
+}
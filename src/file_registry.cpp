@@ -0,0 +1,57 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "file_registry.h"
+
+#include <cassert>
+
+namespace badgerdb {
+
+bool FileRegistry::find(const std::string& filename, FileId& file_id) const {
+  const std::map<std::string, FileId>::const_iterator entry =
+      ids_.find(filename);
+  if (entry == ids_.end()) {
+    return false;
+  }
+  file_id = entry->second;
+  return true;
+}
+
+FileId FileRegistry::add(const std::string& filename,
+                         const std::shared_ptr<FileHandle>& handle) {
+  // Take the lowest free id so that ids stay dense.
+  FileId file_id = 0;
+  while (file_id < entries_.size() && entries_[file_id].handle) {
+    ++file_id;
+  }
+  if (file_id == entries_.size()) {
+    entries_.push_back(Entry());
+  }
+  Entry& entry = entries_[file_id];
+  entry.filename = filename;
+  entry.handle = handle;
+  entry.references = 1;
+  ids_[filename] = file_id;
+  return file_id;
+}
+
+void FileRegistry::release(const FileId file_id) {
+  Entry& entry = entries_[file_id];
+  assert(entry.references > 0);
+  if (--entry.references > 0) {
+    return;
+  }
+  ids_.erase(entry.filename);
+  entry.filename.clear();
+  entry.handle.reset();
+  // Trim free ids off the end so idLimit() stays tight.
+  while (!entries_.empty() && !entries_.back().handle) {
+    entries_.pop_back();
+  }
+}
+
+}
@@ -0,0 +1,133 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "file_handle.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Registry of the files open in this process.
+ *
+ * Each open file is given a FileId, a small integer that stays the same for as
+ * long as any File object refers to the file.  Ids are dense: an id is
+ * recycled once its file is closed, and the lowest free id is always handed
+ * out first, so ids never exceed the number of files open at once and can be
+ * used to index per-file arrays.  Everything after open is keyed by id; the
+ * filename index is only consulted to open, remove or test a file by name.
+ *
+ * @warning This class is not threadsafe.
+ */
+class FileRegistry {
+ public:
+  /**
+   * Looks up the id of an open file by name.
+   *
+   * @param filename  Name of the file.
+   * @param file_id   Set to the file's id if it is open.
+   * @return  True if the file is open.
+   */
+  bool find(const std::string& filename, FileId& file_id) const;
+
+  /**
+   * Registers a newly opened file, with a reference count of one.
+   *
+   * @param filename  Name of the file.
+   * @param handle    Handle of the open file.
+   * @return  Id assigned to the file.
+   */
+  FileId add(const std::string& filename,
+             const std::shared_ptr<FileHandle>& handle);
+
+  /**
+   * Adds a reference to an open file.
+   *
+   * @param file_id   Id of the file.
+   */
+  void acquire(const FileId file_id) { ++entries_[file_id].references; }
+
+  /**
+   * Returns the number of File objects referring to an open file.
+   *
+   * @param file_id   Id of the file.
+   */
+  int references(const FileId file_id) const {
+    return entries_[file_id].references;
+  }
+
+  /**
+   * Drops a reference to an open file.  When the last reference goes, the
+   * file is unregistered and its id becomes free for reuse.
+   *
+   * @param file_id   Id of the file.
+   */
+  void release(const FileId file_id);
+
+  /**
+   * Returns the handle of an open file.
+   *
+   * @param file_id   Id of the file.
+   */
+  const std::shared_ptr<FileHandle>& handle(const FileId file_id) const {
+    return entries_[file_id].handle;
+  }
+
+  /**
+   * Returns the name of an open file.
+   *
+   * @param file_id   Id of the file.
+   */
+  const std::string& filename(const FileId file_id) const {
+    return entries_[file_id].filename;
+  }
+
+  /**
+   * Returns one more than the largest id currently in use, i.e. the size a
+   * per-file array indexed by FileId needs to have.
+   */
+  FileId idLimit() const { return static_cast<FileId>(entries_.size()); }
+
+ private:
+  /**
+   * @brief Registry entry for one id.
+   */
+  struct Entry {
+    /**
+     * Name of the file, or empty if the id is free.
+     */
+    std::string filename;
+
+    /**
+     * Handle of the file, or null if the id is free.
+     */
+    std::shared_ptr<FileHandle> handle;
+
+    /**
+     * Number of File objects referring to the file.
+     */
+    int references;
+  };
+
+  /**
+   * Entries indexed by FileId.
+   */
+  std::vector<Entry> entries_;
+
+  /**
+   * Ids of open files by filename.
+   */
+  std::map<std::string, FileId> ids_;
+};
+
+}
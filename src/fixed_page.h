@@ -0,0 +1,435 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "page.h"
+#include "types.h"
+#include "exceptions/insufficient_space_exception.h"
+#include "exceptions/invalid_record_exception.h"
+#include "exceptions/page_layout_exception.h"
+#include "exceptions/record_size_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Bookkeeping at the start of the data area of a page holding
+ * fixed-length records, as a FixedPage or a PaxPage.
+ */
+struct FixedPageHeader {
+  /**
+   * Length of every record on the page in bytes.
+   */
+  std::uint16_t record_size;
+
+  /**
+   * Number of records on the page.
+   */
+  std::uint16_t num_records;
+
+  /**
+   * Index of the first occupancy bitmap word that may have a clear bit.
+   * Every word before it is full.
+   */
+  std::uint16_t first_open_word;
+
+  /**
+   * Number of columns on a PaxPage; zero on a FixedPage.
+   */
+  std::uint16_t num_columns;
+};
+
+/**
+ * @brief View of a page as a dense array of <RecordSize>-byte records.
+ *
+ * A fixed-length record needs neither an offset nor a length, so instead of
+ * a slot array the page keeps one occupancy bit per record and stores record
+ * n at (n - 1) * RecordSize in the array after the bitmap.  Inserts, deletes
+ * and lookups are a bitmap probe and a copy; records never move, so nothing
+ * is ever compacted.  Record IDs are ordinary RecordIds whose slot number is
+ * the record's index in the array.
+ *
+ * Pages of a file created with a fixed record size (see File::create()) hold
+ * this layout and must only be accessed through a FixedPage of that size.
+ * The view wraps a Page obtained the usual way, from File::readPage() or a
+ * buffer pool frame, and changes it in place; the page is written back with
+ * File::writePage() or by the buffer manager as usual.  Constructing a view
+ * over a newly allocated (empty) page formats it.  The page header is left
+ * looking like a full page with no slots, so a fixed page read through the
+ * Page interface by mistake yields no records and accepts none.
+ *
+ * The view holds a reference to the page and keeps no state of its own, so
+ * it is cheap to construct for each access.
+ *
+ * @warning This class is not threadsafe.
+ */
+template <std::size_t RecordSize>
+class FixedPage {
+ public:
+  /**
+   * Number of records that fit on a page.
+   */
+  static const SlotId CAPACITY;
+
+  /**
+   * Wraps <page>, formatting it if it is newly allocated.
+   *
+   * @param page  Page holding <RecordSize>-byte records, or an empty page.
+   * @throws  RecordSizeException   If the page holds records of another size
+   *                                or variable-length records.
+   * @throws  PageLayoutException   If the page is a PaxPage.
+   */
+  explicit FixedPage(Page& page) : page_(page) {
+    PageHeader& header = page_.header_;
+    if (header.num_slots == 0 &&
+        header.free_space_upper_bound == Page::DATA_SIZE) {
+      format();
+    } else if (header.num_slots != 0 || header.free_space_upper_bound != 0) {
+      throw RecordSizeException(page_.page_number(), RecordSize, 0);
+    } else if (pageHeader().record_size != RecordSize) {
+      throw RecordSizeException(page_.page_number(), RecordSize,
+                                pageHeader().record_size);
+    } else if (pageHeader().num_columns != 0) {
+      throw PageLayoutException(page_.page_number());
+    }
+  }
+
+  /**
+   * Inserts a new record into the page.
+   *
+   * @param data  First of the <RecordSize> bytes of the record.
+   * @return  ID of the newly inserted record.
+   * @throws  InsufficientSpaceException  If the page is full.
+   */
+  RecordId insertRecord(const char* data) {
+    FixedPageHeader& header = pageHeader();
+    if (header.num_records == CAPACITY) {
+      throw InsufficientSpaceException(page_.page_number(), RecordSize, 0);
+    }
+    // Every word before first_open_word is full, and the bits past the last
+    // record are set at format time, so the search always stops at a record.
+    std::size_t word_index = header.first_open_word;
+    std::uint64_t word = loadWord(word_index);
+    while (word == ~std::uint64_t(0)) {
+      word = loadWord(++word_index);
+    }
+    header.first_open_word = static_cast<std::uint16_t>(word_index);
+    storeWord(word_index, word | (word + 1));
+    ++header.num_records;
+    const SlotId slot_number = static_cast<SlotId>(
+        word_index * 64 + __builtin_ctzll(~word) + 1);
+    std::memcpy(record(slot_number), data, RecordSize);
+    const RecordId record_id = {page_.page_number(), slot_number};
+    return record_id;
+  }
+
+  /**
+   * Returns the bytes of the record with the given ID, in place on the page.
+   * They stay valid until the record is deleted or the page leaves memory.
+   *
+   * @param record_id  ID of the record to return.
+   * @return  First of the <RecordSize> bytes of the record.
+   * @throws  InvalidRecordException  If the ID names no record on this page.
+   */
+  const char* getRecord(const RecordId& record_id) const {
+    validateRecordId(record_id);
+    return record(record_id.slot_number);
+  }
+
+  /**
+   * Returns a view of the record with the given ID, as Page::getRecordView()
+   * does.
+   *
+   * @param record_id  ID of the record to return.
+   * @return  View of the record's bytes on this page.
+   * @throws  InvalidRecordException  If the ID names no record on this page.
+   */
+  RecordView getRecordView(const RecordId& record_id) const {
+    const RecordView view = {getRecord(record_id), RecordSize};
+    return view;
+  }
+
+  /**
+   * Overwrites the record with the given ID.
+   *
+   * @param record_id   ID of record to update.
+   * @param data        First of the <RecordSize> bytes of the new version.
+   * @throws  InvalidRecordException  If the ID names no record on this page.
+   */
+  void updateRecord(const RecordId& record_id, const char* data) {
+    validateRecordId(record_id);
+    std::memmove(record(record_id.slot_number), data, RecordSize);
+  }
+
+  /**
+   * Deletes the record with the given ID.  Its slot is reused by a later
+   * insert.
+   *
+   * @param record_id   ID of the record to delete.
+   * @throws  InvalidRecordException  If the ID names no record on this page.
+   */
+  void deleteRecord(const RecordId& record_id) {
+    validateRecordId(record_id);
+    const std::size_t index = record_id.slot_number - 1;
+    const std::size_t word_index = index / 64;
+    storeWord(word_index,
+              loadWord(word_index) & ~(std::uint64_t(1) << index % 64));
+    FixedPageHeader& header = pageHeader();
+    --header.num_records;
+    if (word_index < header.first_open_word) {
+      header.first_open_word = static_cast<std::uint16_t>(word_index);
+    }
+  }
+
+  /**
+   * Returns true if the page has room for another record.
+   */
+  bool hasSpaceForRecord() const {
+    return pageHeader().num_records < CAPACITY;
+  }
+
+  /**
+   * Returns the number of records on the page.
+   */
+  SlotId getNumRecords() const { return pageHeader().num_records; }
+
+  class ViewIterator;
+
+  /**
+   * Returns an iterator yielding views of the records in the page, in slot
+   * order, starting at the first record.
+   *
+   * @return  View iterator at first record of page.
+   */
+  ViewIterator beginViews() const { return ViewIterator(this); }
+
+  /**
+   * Returns a view iterator representing the record after the last record in
+   * the page.  This iterator should not be dereferenced.
+   *
+   * @return  View iterator representing record after the last record.
+   */
+  ViewIterator endViews() const { return ViewIterator(); }
+
+  /**
+   * @brief Iterator over the records of a FixedPage, yielding a RecordView of
+   * each in place, like PageViewIterator.
+   *
+   * The iterator keeps the unvisited bits of the current bitmap word, so
+   * stepping to the next record is a bit scan rather than a bitmap lookup.
+   */
+  class ViewIterator {
+   public:
+    /**
+     * Constructs an end iterator.
+     */
+    ViewIterator()
+        : page_(NULL),
+          word_index_(0),
+          word_(0),
+          slot_number_(Page::INVALID_SLOT) {
+    }
+
+    /**
+     * Constructs an iterator at the first record of <page>.
+     *
+     * @param page  Page to iterate over.
+     */
+    explicit ViewIterator(const FixedPage* page)
+        : page_(page),
+          word_index_(0),
+          word_(page->usedBits(0)),
+          slot_number_(Page::INVALID_SLOT) {
+      ++*this;
+    }
+
+    /**
+     * Advances the iterator to the next record in the page.
+     */
+    ViewIterator& operator++() {
+      while (word_ == 0) {
+        if (++word_index_ == BITMAP_WORDS) {
+          page_ = NULL;
+          slot_number_ = Page::INVALID_SLOT;
+          return *this;
+        }
+        word_ = page_->usedBits(word_index_);
+      }
+      slot_number_ =
+          static_cast<SlotId>(word_index_ * 64 + __builtin_ctzll(word_) + 1);
+      word_ &= word_ - 1;
+      return *this;
+    }
+
+    bool operator==(const ViewIterator& rhs) const {
+      return page_ == rhs.page_ && slot_number_ == rhs.slot_number_;
+    }
+
+    bool operator!=(const ViewIterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+    /**
+     * Returns a view of the record the iterator is at.
+     *
+     * @return  View of the record's bytes on the page.
+     */
+    RecordView operator*() const {
+      const RecordView view = {page_->record(slot_number_), RecordSize};
+      return view;
+    }
+
+    /**
+     * Returns the ID of the record the iterator is at.
+     *
+     * @return  ID of current record.
+     */
+    RecordId record_id() const {
+      const RecordId record_id = {page_->page_.page_number(), slot_number_};
+      return record_id;
+    }
+
+   private:
+    /**
+     * Page being iterated over, or NULL at the end.
+     */
+    const FixedPage* page_;
+
+    /**
+     * Index of the bitmap word holding the current record's bit.
+     */
+    std::size_t word_index_;
+
+    /**
+     * Bits of the records after the current one in that word.
+     */
+    std::uint64_t word_;
+
+    /**
+     * Slot of the current record.
+     */
+    SlotId slot_number_;
+  };
+
+ private:
+  static_assert(RecordSize > 0, "Records must have at least one byte.");
+
+  /**
+   * Returns the largest number of records for which the bookkeeping, the
+   * bitmap (rounded up to whole words) and the records fit in the page's data
+   * area, trying <n> and then fewer.
+   */
+  static constexpr std::size_t capacityAtMost(const std::size_t n) {
+    return sizeof(FixedPageHeader) + (n + 63) / 64 * 8 + n * RecordSize <=
+                   Page::DATA_SIZE
+               ? n
+               : capacityAtMost(n - 1);
+  }
+
+  /**
+   * Number of 64-bit words in the occupancy bitmap.
+   */
+  static const std::size_t BITMAP_WORDS;
+
+  /**
+   * Offset of the first record in the page's data area.
+   */
+  static const std::size_t RECORDS_OFFSET;
+
+  /**
+   * Lays out an empty page: an empty bitmap, with the bits past the last
+   * record set so that inserts never pick them, and a header that gives the
+   * Page interface no space.
+   */
+  void format() {
+    FixedPageHeader& header = pageHeader();
+    header.record_size = RecordSize;
+    header.num_records = 0;
+    header.first_open_word = 0;
+    header.num_columns = 0;
+    for (std::size_t i = 0; i < BITMAP_WORDS; ++i) {
+      storeWord(i, 0);
+    }
+    if (CAPACITY % 64 != 0) {
+      storeWord(BITMAP_WORDS - 1, ~std::uint64_t(0) << CAPACITY % 64);
+    }
+    page_.header_.free_space_upper_bound = 0;
+    page_.header_.fragmented_space = 0;
+  }
+
+  /**
+   * Throws an exception if the given record ID does not name a record on
+   * this page.
+   *
+   * @param record_id   Record ID to validate.
+   * @throws  InvalidRecordException  If the ID has a bad page or slot number.
+   */
+  void validateRecordId(const RecordId& record_id) const {
+    const std::size_t index = record_id.slot_number - 1;
+    if (record_id.page_number != page_.page_number() ||
+        record_id.slot_number == Page::INVALID_SLOT ||
+        index >= CAPACITY ||
+        (loadWord(index / 64) & std::uint64_t(1) << index % 64) == 0) {
+      throw InvalidRecordException(record_id, page_.page_number());
+    }
+  }
+
+  FixedPageHeader& pageHeader() {
+    return *reinterpret_cast<FixedPageHeader*>(page_.data_);
+  }
+
+  const FixedPageHeader& pageHeader() const {
+    return *reinterpret_cast<const FixedPageHeader*>(page_.data_);
+  }
+
+  std::uint64_t loadWord(const std::size_t i) const {
+    std::uint64_t word;
+    std::memcpy(&word, page_.data_ + sizeof(FixedPageHeader) + i * 8, 8);
+    return word;
+  }
+
+  /**
+   * Returns bitmap word <i> without the bits set past the last record.
+   */
+  std::uint64_t usedBits(const std::size_t i) const {
+    if (CAPACITY % 64 != 0 && i == BITMAP_WORDS - 1) {
+      return loadWord(i) & ~(~std::uint64_t(0) << CAPACITY % 64);
+    }
+    return loadWord(i);
+  }
+
+  void storeWord(const std::size_t i, const std::uint64_t word) {
+    std::memcpy(page_.data_ + sizeof(FixedPageHeader) + i * 8, &word, 8);
+  }
+
+  char* record(const SlotId slot_number) const {
+    return page_.data_ + RECORDS_OFFSET + (slot_number - 1) * RecordSize;
+  }
+
+  /**
+   * Page being viewed.
+   */
+  Page& page_;
+};
+
+template <std::size_t RecordSize>
+const SlotId FixedPage<RecordSize>::CAPACITY = static_cast<SlotId>(
+    capacityAtMost((Page::DATA_SIZE - sizeof(FixedPageHeader)) * 8 /
+                   (RecordSize * 8 + 1)));
+
+template <std::size_t RecordSize>
+const std::size_t FixedPage<RecordSize>::BITMAP_WORDS = (CAPACITY + 63) / 64;
+
+template <std::size_t RecordSize>
+const std::size_t FixedPage<RecordSize>::RECORDS_OFFSET =
+    sizeof(FixedPageHeader) + BITMAP_WORDS * 8;
+
+}
@@ -1,17 +1,36 @@
 #include <iostream>
 #include <stdlib.h>
 //#include <stdio.h>
+#include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <fstream>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 #include "page.h"
 #include "buffer.h"
+#include "compressed_page_cache.h"
+#include "crc32c.h"
+#include "file_page_cache.h"
 #include "file_iterator.h"
+#include "fixed_page.h"
+#include "pax_page.h"
+#include "record_scan.h"
 #include "page_iterator.h"
 #include "exceptions/file_not_found_exception.h"
 #include "exceptions/invalid_page_exception.h"
+#include "exceptions/invalid_record_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
 #include "exceptions/buffer_exceeded_exception.h"
+#include "exceptions/corrupt_page_exception.h"
+#include "exceptions/insufficient_space_exception.h"
+#include "exceptions/invalid_predicate_exception.h"
+#include "exceptions/invalid_schema_exception.h"
+#include "exceptions/page_layout_exception.h"
+#include "exceptions/record_size_exception.h"
 
 #define PRINT_ERROR(str) \
 { \
@@ -36,7 +55,627 @@ void test3();
 void test4();
 void test5();
 void test6();
+void test7();
+void test8();
+void test9();
+void test10();
 void testBufMgr();
+void testPage();
+void testFile();
+void testRecordViews()
+{
+	Page page;
+	std::vector<RecordId> rids;
+	for (int n = 0; n < 6; n++)
+	{
+		sprintf((char*)tmpbuf, "viewed record %d", n);
+		rids.push_back(page.insertRecord(tmpbuf));
+	}
+	page.deleteRecord(rids[2]);
+
+	//Views see the same bytes as copies, in place on the page
+	for (int n = 0; n < 6; n++)
+	{
+		if(n == 2)
+		{
+			continue;
+		}
+		const RecordView view = page.getRecordView(rids[n]);
+		if(view.str() != page.getRecord(rids[n]) ||
+			 view.data < reinterpret_cast<const char*>(&page) ||
+			 view.data + view.length > reinterpret_cast<const char*>(&page) + Page::SIZE)
+		{
+			PRINT_ERROR("ERROR :: Record view should point at the record on the page.");
+		}
+	}
+	try
+	{
+		page.getRecordView(rids[2]);
+		PRINT_ERROR("ERROR :: Viewing a deleted record should throw.");
+	}
+	catch(InvalidRecordException&)
+	{
+	}
+	//On a full page the bytes past the last slot are record bytes, not slots
+	{
+		Page full_page;
+		const std::string filler(13, '\xff');
+		SlotId num_slots = 0;
+		while(full_page.hasSpaceForRecord(filler))
+		{
+			full_page.insertRecord(filler);
+			num_slots++;
+		}
+		try
+		{
+			const RecordId past_end = {full_page.page_number(), static_cast<SlotId>(num_slots + 100)};
+			full_page.getRecordView(past_end);
+			PRINT_ERROR("ERROR :: Viewing a slot past the last one should throw.");
+		}
+		catch(InvalidRecordException&)
+		{
+		}
+	}
+
+	//The view iterator visits the same records as PageIterator
+	PageIterator copies = page.begin();
+	int num_records = 0;
+	for (PageViewIterator iter = page.beginViews(); iter != page.endViews(); ++iter)
+	{
+		if(copies == page.end() || (*iter).str() != *copies)
+		{
+			PRINT_ERROR("ERROR :: View iterator should match PageIterator.");
+		}
+		if(page.getRecordView(iter.record_id()).data != (*iter).data)
+		{
+			PRINT_ERROR("ERROR :: View iterator should report the record ID it views.");
+		}
+		++copies;
+		num_records++;
+	}
+	if(num_records != 5 || copies != page.end())
+	{
+		PRINT_ERROR("ERROR :: View iterator should visit every record.");
+	}
+	const Page empty_page;
+	if(empty_page.beginViews() != empty_page.endViews())
+	{
+		PRINT_ERROR("ERROR :: View iterator over an empty page should be at its end.");
+	}
+
+	std::cout << "Record view test passed" << "\n";
+}
+
+void testRecordSpans()
+{
+	//Records are taken from one buffer without building strings
+	std::vector<char> buffer;
+	std::vector<RecordView> records;
+	std::vector<std::size_t> offsets;
+	for (int n = 0; n < 500; n++)
+	{
+		const int length = sprintf((char*)tmpbuf, "spanned record %d", n);
+		offsets.push_back(buffer.size());
+		buffer.insert(buffer.end(), (char*)tmpbuf, (char*)tmpbuf + length);
+	}
+	for (std::size_t n = 0; n < offsets.size(); n++)
+	{
+		const std::size_t end = n + 1 < offsets.size() ? offsets[n + 1] : buffer.size();
+		const RecordView record = {&buffer[offsets[n]], end - offsets[n]};
+		records.push_back(record);
+	}
+
+	Page page;
+	const RecordId first = page.insertRecord(records[0].data, records[0].length);
+	if(page.getRecord(first) != records[0].str() || !page.hasSpaceForRecord(records[1]))
+	{
+		PRINT_ERROR("ERROR :: Record inserted from a pointer and length should read back.");
+	}
+	page.updateRecord(first, records[1]);
+	if(page.getRecord(first) != records[1].str())
+	{
+		PRINT_ERROR("ERROR :: Record updated from a view should read back.");
+	}
+	page.deleteRecord(first);
+
+	//A batch insert fills the page and stops at the first record that does not fit
+	std::vector<RecordId> rids(records.size());
+	std::size_t inserted = page.insertRecords(&records[0], records.size(), &rids[0]);
+	if(inserted == 0 || inserted == records.size() || page.hasSpaceForRecord(records[inserted]))
+	{
+		PRINT_ERROR("ERROR :: Batch insert should fill the page.");
+	}
+	for (std::size_t n = 0; n < inserted; n++)
+	{
+		if(page.getRecord(rids[n]) != records[n].str())
+		{
+			PRINT_ERROR("ERROR :: Batch inserted records should read back.");
+		}
+	}
+	Page next_page;
+	const std::size_t rest = next_page.insertRecords(&records[inserted], records.size() - inserted, &rids[inserted]);
+	if(rest != records.size() - inserted || next_page.getRecord(rids.back()) != records.back().str())
+	{
+		PRINT_ERROR("ERROR :: Batch insert should continue on the next page.");
+	}
+
+	std::cout << "Record span test passed" << "\n";
+}
+
+void testLazyCompaction()
+{
+	Page page;
+	std::vector<RecordId> rids;
+	while (true)
+	{
+		sprintf((char*)tmpbuf, "churned record %04d", (int)rids.size());
+		if(!page.hasSpaceForRecord(tmpbuf))
+		{
+			break;
+		}
+		rids.push_back(page.insertRecord(tmpbuf));
+	}
+
+	//Deletes leave holes, but the space still counts as free
+	const std::uint16_t full_free_space = page.getFreeSpace();
+	std::size_t freed = 0;
+	//(The last record stays, so no slots are freed.)
+	for (std::size_t n = 0; n + 1 < rids.size(); n += 2)
+	{
+		freed += page.getRecord(rids[n]).size();
+		page.deleteRecord(rids[n]);
+	}
+	if(page.getFreeSpace() != full_free_space + freed)
+	{
+		PRINT_ERROR("ERROR :: Deleted records should count as free space.");
+	}
+
+	//A record bigger than any hole compacts the page
+	const std::string big(freed / 2, 'b');
+	const RecordId big_rid = page.insertRecord(big);
+	if(page.getRecord(big_rid) != big)
+	{
+		PRINT_ERROR("ERROR :: Insert needing the holes should compact the page.");
+	}
+	for (std::size_t n = 1; n < rids.size(); n += 2)
+	{
+		sprintf((char*)tmpbuf, "churned record %04d", (int)n);
+		if(page.getRecord(rids[n]) != tmpbuf)
+		{
+			PRINT_ERROR("ERROR :: Compaction should keep the other records.");
+		}
+	}
+
+	//So does growing a record into the remaining free space
+	const std::string bigger(big.size() + page.getFreeSpace(), 'B');
+	page.updateRecord(big_rid, bigger);
+	if(page.getRecord(big_rid) != bigger || page.getFreeSpace() != 0 ||
+		 page.getRecord(rids[1]) != "churned record 0001")
+	{
+		PRINT_ERROR("ERROR :: Update needing the holes should compact the page.");
+	}
+
+	//Emptying the page gives all of it back
+	page.deleteRecord(big_rid);
+	for (std::size_t n = 1; n < rids.size(); n += 2)
+	{
+		page.deleteRecord(rids[n]);
+	}
+	if(rids.size() % 2 == 1)
+	{
+		page.deleteRecord(rids.back());
+	}
+	if(page.getFreeSpace() != Page().getFreeSpace() || page.insertRecord(std::string(Page::DATA_SIZE - page.getSlotSize(), 'x')).slot_number != 1)
+	{
+		PRINT_ERROR("ERROR :: Emptied page should be entirely free.");
+	}
+
+	//New slots can grow over the bytes of a deleted record
+	Page slot_page;
+	const std::string wide(100, 'x');
+	RecordId last_rid = slot_page.insertRecord(wide);
+	while(slot_page.hasSpaceForRecord(wide))
+	{
+		last_rid = slot_page.insertRecord(wide);
+	}
+	slot_page.deleteRecord(last_rid);
+	while(slot_page.hasSpaceForRecord("y"))
+	{
+		slot_page.insertRecord("y");
+	}
+
+	std::cout << "Lazy compaction test passed" << "\n";
+}
+
+void testFreeSlots()
+{
+	Page page;
+	std::vector<RecordId> rids;
+	while(page.hasSpaceForRecord("slot"))
+	{
+		rids.push_back(page.insertRecord("slot"));
+	}
+
+	//Free every third slot, and a long run in the middle
+	std::vector<bool> used(rids.size() + 1, true);
+	for (std::size_t n = 0; n + 1 < rids.size(); n++)
+	{
+		if(n % 3 == 0 || (n > 100 && n < 200))
+		{
+			page.deleteRecord(rids[n]);
+			used[rids[n].slot_number] = false;
+		}
+	}
+
+	//The iterators skip exactly the freed slots
+	SlotId expected = 0;
+	PageViewIterator views = page.beginViews();
+	for (PageIterator iter = page.begin(); iter != page.end(); ++iter, ++views)
+	{
+		do
+		{
+			expected++;
+		} while(!used[expected]);
+		if(views == page.endViews() || views.record_id().slot_number != expected)
+		{
+			PRINT_ERROR("ERROR :: Iterators should visit exactly the used slots.");
+		}
+	}
+	if(views != page.endViews() || expected != rids.back().slot_number)
+	{
+		PRINT_ERROR("ERROR :: Iterators should stop after the last used slot.");
+	}
+
+	//Inserts take the freed slots before growing the slot array
+	std::size_t num_freed = std::count(used.begin() + 1, used.end(), false);
+	for (std::size_t n = 0; n < num_freed; n++)
+	{
+		const SlotId slot_number = page.insertRecord("tols").slot_number;
+		if(slot_number > rids.back().slot_number || used[slot_number])
+		{
+			PRINT_ERROR("ERROR :: Insert should reuse a free slot.");
+		}
+		used[slot_number] = true;
+	}
+	if(page.hasSpaceForRecord("slot") && page.insertRecord("slot").slot_number != rids.back().slot_number + 1)
+	{
+		PRINT_ERROR("ERROR :: Insert should grow the slot array once no slot is free.");
+	}
+
+	std::cout << "Free slot test passed" << "\n";
+}
+
+void testInPlaceUpdate()
+{
+	Page page;
+	std::vector<RecordId> rids;
+	while(page.hasSpaceForRecord("counter 0000"))
+	{
+		rids.push_back(page.insertRecord("counter 0000"));
+	}
+	const std::uint16_t full_free_space = page.getFreeSpace();
+
+	//Same-length updates overwrite the record where it is
+	const RecordId middle = rids[rids.size() / 2];
+	const char* const middle_bytes = page.getRecordView(middle).data;
+	page.updateRecord(middle, "counter 0001");
+	if(page.getRecord(middle) != "counter 0001" ||
+		 page.getRecordView(middle).data != middle_bytes ||
+		 page.getFreeSpace() != full_free_space ||
+		 page.getRecord(rids[rids.size() / 2 - 1]) != "counter 0000" ||
+		 page.getRecord(rids[rids.size() / 2 + 1]) != "counter 0000")
+	{
+		PRINT_ERROR("ERROR :: Same-length update should overwrite in place.");
+	}
+
+	//Shorter updates give back the unused bytes, wherever the record is
+	page.updateRecord(middle, "counter 1");
+	page.updateRecord(rids.back(), "counter 2");
+	if(page.getRecord(middle) != "counter 1" || page.getRecordView(middle).data != middle_bytes ||
+		 page.getRecord(rids.back()) != "counter 2" ||
+		 page.getFreeSpace() != full_free_space + 6)
+	{
+		PRINT_ERROR("ERROR :: Shorter update should overwrite in place.");
+	}
+
+	//A record can be updated from a view of its own bytes
+	page.updateRecord(middle, page.getRecordView(middle).data + 8, 1);
+	if(page.getRecord(middle) != "1")
+	{
+		PRINT_ERROR("ERROR :: Update from the record's own bytes should work.");
+	}
+
+	//Longer updates still move the record, compacting the page if needed
+	const std::string longer(page.getFreeSpace() + 1, 'l');
+	page.updateRecord(middle, longer);
+	if(page.getRecord(middle) != longer || page.getFreeSpace() != 0 ||
+		 page.getRecord(rids.back()) != "counter 2" ||
+		 page.getRecord(rids.front()) != "counter 0000")
+	{
+		PRINT_ERROR("ERROR :: Longer update should move the record.");
+	}
+
+	std::cout << "In-place update test passed" << "\n";
+}
+
+void testFixedPage()
+{
+	typedef FixedPage<16> Fixed16;
+	Page page;
+	Fixed16 fixed(page);
+	std::vector<RecordId> rids;
+	while(fixed.hasSpaceForRecord())
+	{
+		sprintf((char*)tmpbuf, "fixed rec %05d", (int)rids.size());
+		rids.push_back(fixed.insertRecord(tmpbuf));
+	}
+	Page slotted;
+	std::size_t num_slotted = 0;
+	for (; slotted.hasSpaceForRecord(16); num_slotted++)
+	{
+		slotted.insertRecord(tmpbuf, 16);
+	}
+	//Only the bookkeeping, a bit per record and less than a record go unused
+	if(rids.size() != Fixed16::CAPACITY || fixed.getNumRecords() != Fixed16::CAPACITY ||
+		 Page::DATA_SIZE - Fixed16::CAPACITY * 16 >= sizeof(FixedPageHeader) + (Fixed16::CAPACITY + 63) / 64 * 8 + 16 ||
+		 rids.size() <= num_slotted)
+	{
+		PRINT_ERROR("ERROR :: Fixed page should fill its data area with records.");
+	}
+	try
+	{
+		fixed.insertRecord(tmpbuf);
+		PRINT_ERROR("ERROR :: Insert into a full fixed page should throw.");
+	}
+	catch(InsufficientSpaceException&)
+	{
+	}
+
+	//Records are read, updated and deleted by slot number
+	const RecordId middle = rids[rids.size() / 2];
+	fixed.updateRecord(middle, "updated record!!");
+	fixed.deleteRecord(rids[1]);
+	fixed.deleteRecord(rids[200]);
+	if(std::strcmp(fixed.getRecord(rids[0]), "fixed rec 00000") != 0 ||
+		 fixed.getRecordView(middle).str() != "updated record!!" ||
+		 fixed.getNumRecords() != Fixed16::CAPACITY - 2)
+	{
+		PRINT_ERROR("ERROR :: Fixed page records should read back.");
+	}
+	try
+	{
+		fixed.getRecord(rids[200]);
+		PRINT_ERROR("ERROR :: Reading a deleted fixed record should throw.");
+	}
+	catch(InvalidRecordException&)
+	{
+	}
+
+	//Inserts reuse the lowest free slot
+	if(fixed.insertRecord("reused record 01") != rids[1] ||
+		 fixed.insertRecord("reused record 02") != rids[200])
+	{
+		PRINT_ERROR("ERROR :: Fixed page should reuse deleted slots.");
+	}
+
+	//Slot iteration skips deleted records
+	fixed.deleteRecord(rids[0]);
+	fixed.deleteRecord(rids[64]);
+	fixed.deleteRecord(rids.back());
+	SlotId num_visited = 0;
+	for (Fixed16::ViewIterator iter = fixed.beginViews(); iter != fixed.endViews(); ++iter)
+	{
+		const RecordId rid = iter.record_id();
+		if(rid == rids[0] || rid == rids[64] || rid == rids.back() ||
+			 (*iter).data != fixed.getRecord(rid) || (*iter).length != 16)
+		{
+			PRINT_ERROR("ERROR :: Fixed page iteration should skip deleted records.");
+		}
+		num_visited++;
+	}
+	if(num_visited != fixed.getNumRecords())
+	{
+		PRINT_ERROR("ERROR :: Fixed page iteration should visit every record.");
+	}
+
+	//Through the Page interface a fixed page looks full and empty
+	if(page.beginViews() != page.endViews() || page.hasSpaceForRecord(1))
+	{
+		PRINT_ERROR("ERROR :: Page interface should see no records on a fixed page.");
+	}
+
+	//A page of other records cannot be viewed as one of 16-byte records
+	try
+	{
+		FixedPage<8> wrong_size(page);
+		PRINT_ERROR("ERROR :: Viewing a fixed page with the wrong size should throw.");
+	}
+	catch(RecordSizeException& e)
+	{
+		if(e.actual_size() != 16)
+		{
+			PRINT_ERROR("ERROR :: Record size exception should report the page's size.");
+		}
+	}
+	try
+	{
+		Fixed16 not_fixed(slotted);
+		PRINT_ERROR("ERROR :: Viewing a slotted page as fixed should throw.");
+	}
+	catch(RecordSizeException&)
+	{
+	}
+
+	std::cout << "Fixed page test passed" << "\n";
+}
+
+void testPaxPage()
+{
+	//Records of a 4-byte key, a 2-byte flag and a 10-byte name
+	std::vector<std::uint16_t> widths;
+	widths.push_back(4);
+	widths.push_back(2);
+	widths.push_back(10);
+	const PaxSchema schema(widths);
+	if(schema.recordSize() != 16 || schema.fieldOffset(2) != 6 ||
+		 schema.capacity() < FixedPage<16>::CAPACITY - 2 || schema.capacity() > FixedPage<16>::CAPACITY)
+	{
+		PRINT_ERROR("ERROR :: PAX schema should fit about as many records as a fixed page.");
+	}
+
+	Page page;
+	PaxPage pax(page, schema);
+	std::vector<RecordId> rids;
+	char record[16];
+	while(pax.hasSpaceForRecord())
+	{
+		const std::uint32_t key = rids.size();
+		std::memcpy(record, &key, 4);
+		std::memcpy(record + 4, key % 3 == 0 ? "Y." : "N.", 2);
+		sprintf(record + 6, "name %04u", key);
+		rids.push_back(pax.insertRecord(record));
+	}
+	if(rids.size() != schema.capacity() || pax.getNumRecords() != schema.capacity())
+	{
+		PRINT_ERROR("ERROR :: PAX page should fill to its capacity.");
+	}
+
+	//Records read back whole and by field, and fields update alone
+	pax.updateField(rids[7], 1, "Y!");
+	pax.deleteRecord(rids[3]);
+	pax.deleteRecord(rids[100]);
+	pax.getRecord(rids[7], record);
+	if(std::memcmp(record + 4, "Y!name 0007", 11) != 0 ||
+		 std::memcmp(pax.getField(rids[8], 2), "name 0008", 10) != 0 ||
+		 pax.getNumRecords() != schema.capacity() - 2)
+	{
+		PRINT_ERROR("ERROR :: PAX records should read back.");
+	}
+	try
+	{
+		pax.getField(rids[3], 0);
+		PRINT_ERROR("ERROR :: Reading a deleted PAX record should throw.");
+	}
+	catch(InvalidRecordException&)
+	{
+	}
+	if(pax.insertRecord(record) != rids[3])
+	{
+		PRINT_ERROR("ERROR :: PAX page should reuse deleted slots.");
+	}
+
+	//A column scan visits each used slot's field, in the column's minipage
+	std::size_t num_flagged = 0;
+	std::size_t num_visited = 0;
+	for (PaxPage::ColumnIterator iter = pax.beginColumn(1); iter != pax.endColumn(); ++iter, num_visited++)
+	{
+		if(iter.record_id() == rids[100] || *iter != pax.getField(iter.record_id(), 1))
+		{
+			PRINT_ERROR("ERROR :: Column iterator should visit the used slots.");
+		}
+		num_flagged += (*iter)[0] == 'Y';
+	}
+	//As does a masked scan of the column as an array
+	const ColumnView keys = pax.getColumn(0);
+	std::size_t num_masked = 0;
+	for (SlotId slot = 1; slot <= keys.num_slots; slot++)
+	{
+		std::uint32_t key;
+		std::memcpy(&key, keys.data + (slot - 1) * keys.width, 4);
+		if((pax.getOccupancy((slot - 1) / 64) >> (slot - 1) % 64 & 1) && key % 3 == 0)
+		{
+			num_masked++;
+		}
+	}
+	//(Key 3 was deleted, and key 7 flagged and copied into its slot.)
+	if(num_visited != pax.getNumRecords() || num_flagged != num_masked + 2 ||
+		 num_masked != static_cast<std::size_t>((schema.capacity() + 2) / 3 - 1))
+	{
+		PRINT_ERROR("ERROR :: Column scans should see every record once.");
+	}
+
+	//Pages of other layouts are refused
+	try
+	{
+		std::vector<std::uint16_t> other_widths(2, 8);
+		const PaxSchema other(other_widths);
+		PaxPage wrong(page, other);
+		PRINT_ERROR("ERROR :: Viewing a PAX page with other columns should throw.");
+	}
+	catch(PageLayoutException&)
+	{
+	}
+	try
+	{
+		FixedPage<16> fixed(page);
+		PRINT_ERROR("ERROR :: Viewing a PAX page as a fixed page should throw.");
+	}
+	catch(PageLayoutException&)
+	{
+	}
+
+	//Schemas without a column to lay out are refused
+	try
+	{
+		const std::vector<std::uint16_t> no_widths;
+		const PaxSchema empty(no_widths);
+		PRINT_ERROR("ERROR :: A PAX schema without columns should throw.");
+	}
+	catch(InvalidSchemaException&)
+	{
+	}
+	try
+	{
+		std::vector<std::uint16_t> zero_widths(widths);
+		zero_widths[1] = 0;
+		const PaxSchema zero(zero_widths);
+		PRINT_ERROR("ERROR :: A PAX schema with a column of width 0 should throw.");
+	}
+	catch(InvalidSchemaException&)
+	{
+	}
+	try
+	{
+		const std::vector<std::uint16_t> narrow_widths(5000, 1);
+		const PaxSchema narrow(narrow_widths);
+		PRINT_ERROR("ERROR :: A PAX schema whose column widths overflow the page should throw.");
+	}
+	catch(InvalidSchemaException&)
+	{
+	}
+	try
+	{
+		const std::vector<std::uint16_t> wide_widths(2, 60000);
+		const PaxSchema wide(wide_widths);
+		PRINT_ERROR("ERROR :: A PAX schema with records larger than a page should throw.");
+	}
+	catch(InvalidSchemaException&)
+	{
+	}
+
+	std::cout << "PAX page test passed" << "\n";
+}
+
+void testDurability();
+void testAllocation();
+void testLegacyUpgrade();
+void testSharedHeader();
+void testGrowth();
+void testReclaim();
+void testCompaction();
+void testFileIds();
+void testReusedFileIds();
+void testDescriptorCache();
+void testMultiPageIo();
+void testChecksums();
+void testCompression();
+void testRecordViews();
+void testRecordSpans();
+void testLazyCompaction();
+void testFreeSlots();
+void testFixedRecordFile();
+void testColumnarFile();
+void testRecordScanFile();
 
 int main() 
 {
@@ -75,11 +714,12 @@ int main()
          iter != new_file.end();
          ++iter) {
       // Iterate through all records on the page.
-      for (PageIterator page_iter = (*iter).begin();
-           page_iter != (*iter).end();
+      Page curr_page = *iter;
+      for (PageIterator page_iter = curr_page.begin();
+           page_iter != curr_page.end();
            ++page_iter) {
         std::cout << "Found record: " << *page_iter
-            << " on page " << (*iter).page_number() << "\n";
+            << " on page " << curr_page.page_number() << "\n";
       }
     }
 
@@ -97,14 +737,190 @@ int main()
   // Delete the file since we're done with it.
   File::remove(filename);
 
+	//This function tests page level features, comment this line if you don't wish to test them
+	testPage();
+
+	//This function tests file level features, comment this line if you don't wish to test them
+	testFile();
+
 	//This function tests buffer manager, comment this line if you don't wish to test buffer manager
 	testBufMgr();
 }
 
-void testBufMgr()
+void testRecordScan()
 {
-	// create buffer manager
-	bufMgr = new BufMgr(num);
+	//Random records over a small alphabet, and a few copies of a long one, so
+	//every predicate has some matches.  The first record inserted is short and
+	//sits at the end of the page, where the kernels must not load past it.
+	Page page;
+	srand(7);
+	page.insertRecord("ab", 2);
+	while(true)
+	{
+		int length = rand() % 40;
+		for (int i = 0; i < length; i++)
+		{
+			tmpbuf[i] = 'a' + rand() % 4;
+		}
+		if(rand() % 8 == 0)
+		{
+			length = 38;
+			memcpy(tmpbuf, "abcdabcdabcdabcdabcdabcdabcdabcdabcdab", length);
+		}
+		if(!page.hasSpaceForRecord(length))
+		{
+			break;
+		}
+		page.insertRecord(tmpbuf, length);
+	}
+	std::size_t num_records = 0;
+	for (PageViewIterator iter = page.beginViews(); iter != page.endViews(); ++iter)
+	{
+		num_records++;
+	}
+	for (SlotId slot = 2; slot < 200; slot += 3, num_records--)
+	{
+		const RecordId rid = {page.page_number(), slot};
+		page.deleteRecord(rid);
+	}
+
+	std::vector<RecordPredicate> predicates;
+	predicates.push_back(RecordPredicate::prefix("ab"));
+	predicates.push_back(RecordPredicate::bytesAt(3, "dcb"));
+	predicates.push_back(RecordPredicate::bytesAt(1, "bcdabcdabcdabcdabcdabcdabcdabcdabc"));
+	predicates.push_back(RecordPredicate::contains("b"));
+	predicates.push_back(RecordPredicate::contains("cab"));
+	predicates.push_back(RecordPredicate::contains("dddd"));
+	predicates.push_back(RecordPredicate::contains("abcdabcdabcdabcdabcdabcdabcdabcdabc"));
+	predicates.push_back(RecordPredicate::int32Between(2, 0x61610000, 0x63640000));
+	predicates.push_back(RecordPredicate::int64Between(5, 0x6361000000000000LL, 0x6462000000000000LL));
+	const ScanKernel kernels[] = {SCAN_SCALAR, SCAN_SSE2, SCAN_AVX2};
+	for (std::size_t p = 0; p < predicates.size(); p++)
+	{
+		std::vector<RecordId> expected;
+		for (PageViewIterator iter = page.beginViews(); iter != page.endViews(); ++iter)
+		{
+			if(predicates[p].matches((*iter).data, (*iter).length))
+			{
+				expected.push_back(iter.record_id());
+			}
+		}
+		if(expected.empty() || expected.size() == num_records)
+		{
+			PRINT_ERROR("ERROR :: Scan test predicates should match some records.");
+		}
+		for (int k = 0; k < 3; k++)
+		{
+			const RecordScanner scanner(predicates[p], kernels[k]);
+			std::vector<RecordId> rids;
+			std::vector<RecordView> views;
+			scanner.scanPage(page, rids);
+			scanner.scanPage(page, views);
+			if(rids != expected || views.size() != expected.size())
+			{
+				PRINT_ERROR("ERROR :: Every scan kernel should find the same records.");
+			}
+			for (std::size_t i = 0; i < views.size(); i++)
+			{
+				const RecordView view = page.getRecordView(expected[i]);
+				if(views[i].data != view.data || views[i].length != view.length)
+				{
+					PRINT_ERROR("ERROR :: Scan views should point at the records on the page.");
+				}
+			}
+		}
+	}
+
+	//Predicates no record could be tested against are refused
+	try
+	{
+		RecordPredicate::contains("");
+		PRINT_ERROR("ERROR :: Empty substring should be refused.");
+	}
+	catch(InvalidPredicateException&)
+	{
+	}
+	try
+	{
+		RecordPredicate::bytesAt(4, "");
+		PRINT_ERROR("ERROR :: Empty pattern should be refused.");
+	}
+	catch(InvalidPredicateException&)
+	{
+	}
+	try
+	{
+		RecordPredicate::int32Between(0, 5, 4);
+		PRINT_ERROR("ERROR :: Range ending below its start should be refused.");
+	}
+	catch(InvalidPredicateException&)
+	{
+	}
+	try
+	{
+		RecordPredicate::int64Between(0, 1, -1);
+		PRINT_ERROR("ERROR :: Range ending below its start should be refused.");
+	}
+	catch(InvalidPredicateException&)
+	{
+	}
+	//Fields that would end past any record are refused, however large the offset
+	try
+	{
+		RecordPredicate::bytesAt(SIZE_MAX - 1, "ab");
+		PRINT_ERROR("ERROR :: Pattern at a huge offset should be refused.");
+	}
+	catch(InvalidPredicateException&)
+	{
+	}
+	try
+	{
+		RecordPredicate::int32Between(Page::DATA_SIZE - 3, 0, 1);
+		PRINT_ERROR("ERROR :: Key ending past the data area should be refused.");
+	}
+	catch(InvalidPredicateException&)
+	{
+	}
+
+	std::cout << "Record scan test passed" << "\n";
+}
+
+void testPage()
+{
+	testRecordViews();
+	testRecordSpans();
+	testLazyCompaction();
+	testFreeSlots();
+	testInPlaceUpdate();
+	testFixedPage();
+	testPaxPage();
+	testRecordScan();
+}
+
+void testFile()
+{
+	testDurability();
+	testAllocation();
+	testLegacyUpgrade();
+	testSharedHeader();
+	testGrowth();
+	testReclaim();
+	testCompaction();
+	testFileIds();
+	testReusedFileIds();
+	testDescriptorCache();
+	testMultiPageIo();
+	testChecksums();
+	testCompression();
+	testFixedRecordFile();
+	testColumnarFile();
+	testRecordScanFile();
+}
+
+void testBufMgr()
+{
+	// create buffer manager
+	bufMgr = new BufMgr(num);
 
 	// create dummy files
   const std::string& filename1 = "test.1";
@@ -146,177 +962,1645 @@ void testBufMgr()
 	test4();
 	test5();
 	test6();
+	test7();
+	test8();
+	test9();
+	test10();
+
+    // delete the bufMgr before deleting files
+	delete bufMgr;
+
+	//Close files before deleting them
+	file1.~File();
+	file2.~File();
+	file3.~File();
+	file4.~File();
+	file5.~File();
+
+	//Delete files
+	File::remove(filename1);
+	File::remove(filename2);
+	File::remove(filename3);
+	File::remove(filename4);
+	File::remove(filename5);
+
+	std::cout << "\n" << "Passed all tests." << "\n";
+}
+
+void test1()
+{
+	//Allocating pages in a file...
+	for (i = 0; i < num; i++)
+	{
+		bufMgr->allocPage(file1ptr, pid[i], page);
+		sprintf((char*)tmpbuf, "test.1 Page %d %7.1f", pid[i], (float)pid[i]);
+		rid[i] = page->insertRecord(tmpbuf);
+		bufMgr->unPinPage(file1ptr, pid[i], true);
+	}
+
+	//Reading pages back...
+	for (i = 0; i < num; i++)
+	{
+		bufMgr->readPage(file1ptr, pid[i], page);
+		sprintf((char*)&tmpbuf, "test.1 Page %d %7.1f", pid[i], (float)pid[i]);
+		if(strncmp(page->getRecord(rid[i]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+		bufMgr->unPinPage(file1ptr, pid[i], false);
+	}
+	std::cout<< "Test 1 passed" << "\n";
+}
+
+void test2()
+{
+	//Writing and reading back multiple files
+	//The page number and the value should match
+
+	for (i = 0; i < num/3; i++) 
+	{
+		bufMgr->allocPage(file2ptr, pageno2, page2);
+		sprintf((char*)tmpbuf, "test.2 Page %d %7.1f", pageno2, (float)pageno2);
+		rid2 = page2->insertRecord(tmpbuf);
+
+		int index = rand() % num;
+        pageno1 = pid[index];
+		bufMgr->readPage(file1ptr, pageno1, page);
+		sprintf((char*)tmpbuf, "test.1 Page %d %7.1f", pageno1, (float)pageno1);
+		if(strncmp(page->getRecord(rid[index]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+
+		bufMgr->allocPage(file3ptr, pageno3, page3);
+		sprintf((char*)tmpbuf, "test.3 Page %d %7.1f", pageno3, (float)pageno3);
+		rid3 = page3->insertRecord(tmpbuf);
+
+		bufMgr->readPage(file2ptr, pageno2, page2);
+		sprintf((char*)&tmpbuf, "test.2 Page %d %7.1f", pageno2, (float)pageno2);
+		if(strncmp(page2->getRecord(rid2).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+
+		bufMgr->readPage(file3ptr, pageno3, page3);
+		sprintf((char*)&tmpbuf, "test.3 Page %d %7.1f", pageno3, (float)pageno3);
+		if(strncmp(page3->getRecord(rid3).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+
+		bufMgr->unPinPage(file1ptr, pageno1, false);
+	}
+
+	for (i = 0; i < num/3; i++) {
+		bufMgr->unPinPage(file2ptr, i+1, true);
+		bufMgr->unPinPage(file2ptr, i+1, true);
+		bufMgr->unPinPage(file3ptr, i+1, true);
+		bufMgr->unPinPage(file3ptr, i+1, true);
+	}
+
+	std::cout << "Test 2 passed" << "\n";
+}
+
+void test3()
+{
+	try
+	{
+		bufMgr->readPage(file4ptr, 1, page);
+		PRINT_ERROR("ERROR :: File4 should not exist. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(InvalidPageException e)
+	{
+	}
+
+	std::cout << "Test 3 passed" << "\n";
+}
+
+void test4()
+{
+	bufMgr->allocPage(file4ptr, i, page);
+	bufMgr->unPinPage(file4ptr, i, true);
+	try
+	{
+		bufMgr->unPinPage(file4ptr, i, false);
+		PRINT_ERROR("ERROR :: Page is already unpinned. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(PageNotPinnedException e)
+	{
+	}
+
+	std::cout << "Test 4 passed" << "\n";
+}
+
+void test5()
+{
+	for (i = 0; i < num; i++) {
+		bufMgr->allocPage(file5ptr, pid[i], page);
+		sprintf((char*)tmpbuf, "test.5 Page %d %7.1f", pid[i], (float)pid[i]);
+		rid[i] = page->insertRecord(tmpbuf);
+	}
+
+	PageId tmp;
+	try
+	{
+		bufMgr->allocPage(file5ptr, tmp, page);
+		PRINT_ERROR("ERROR :: No more frames left for allocation. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(BufferExceededException e)
+	{
+	}
+
+	std::cout << "Test 5 passed" << "\n";
+
+	for (i = 1; i <= num; i++)
+		bufMgr->unPinPage(file5ptr, i, true);
+}
+
+void test6()
+{
+	//flushing file with pages still pinned. Should generate an error
+	for (i = 1; i <= num; i++) {
+		bufMgr->readPage(file1ptr, i, page);
+	}
+
+	try
+	{
+		bufMgr->flushFile(file1ptr);
+		PRINT_ERROR("ERROR :: Pages pinned for file being flushed. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(PagePinnedException e)
+	{
+	}
+
+	std::cout << "Test 6 passed" << "\n";
+
+	for (i = 1; i <= num; i++) 
+		bufMgr->unPinPage(file1ptr, i, true);
+
+	bufMgr->flushFile(file1ptr);
+}
+
+void test7()
+{
+	//Checkpoint dirty pages of several files; a pinned page is left dirty
+	PageId pageNos[3];
+	for (i = 0; i < 3; i++)
+	{
+		File* file = (i == 1) ? file5ptr : file4ptr;
+		bufMgr->allocPage(file, pageNos[i], page);
+		sprintf((char*)tmpbuf, "checkpoint %d", i);
+		page->insertRecord(tmpbuf);
+		bufMgr->unPinPage(file, pageNos[i], true);
+	}
+	bufMgr->readPage(file4ptr, pageNos[2], page);
+	page->insertRecord("pinned");
+
+	CheckpointPolicy policy;
+	policy.batch_pages = 1;
+	bufMgr->setCheckpointPolicy(policy);
+	const CheckpointStats& stats = bufMgr->flushAll();
+	if(stats.pages_written < 2 || stats.pages_skipped != 1)
+	{
+		PRINT_ERROR("ERROR :: Checkpoint should write unpinned dirty pages and skip pinned ones.");
+	}
+	for (i = 0; i < 2; i++)
+	{
+		File* file = (i == 1) ? file5ptr : file4ptr;
+		sprintf((char*)tmpbuf, "checkpoint %d", i);
+		if(file->readPage(pageNos[i]).getRecord({pageNos[i], 1}) != tmpbuf)
+		{
+			PRINT_ERROR("ERROR :: Checkpointed page not found on disk.");
+		}
+	}
+	if(!file4ptr->isDurable() || !file5ptr->isDurable())
+	{
+		PRINT_ERROR("ERROR :: Checkpoint should sync the files it wrote.");
+	}
+
+	//Once unpinned, the page is written by the next checkpoint
+	bufMgr->unPinPage(file4ptr, pageNos[2], true);
+	bufMgr->flushAll();
+	if(file4ptr->readPage(pageNos[2]).getRecord({pageNos[2], 2}) != "pinned")
+	{
+		PRINT_ERROR("ERROR :: Page pinned during a checkpoint should be written by the next one.");
+	}
+
+	//Pages are pinned without waiting for a checkpoint's write, even the page being written, and a page
+	//dirtied during the write stays dirty
+	bufMgr->setCheckpointPolicy(CheckpointPolicy());
+	for (i = 0; i < 2; i++)
+	{
+		File* file = (i == 1) ? file5ptr : file4ptr;
+		bufMgr->readPage(file, pageNos[i], page);
+		bufMgr->unPinPage(file, pageNos[i], true);
+	}
+	file4ptr->setWriteLatency(300000);
+	std::thread checkpoint([]() { bufMgr->flushAll(); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bufMgr->readPage(file5ptr, pageNos[1], page);
+	bufMgr->unPinPage(file5ptr, pageNos[1], false);
+	bufMgr->readPage(file4ptr, pageNos[0], page);
+	page->insertRecord("written later");
+	bufMgr->unPinPage(file4ptr, pageNos[0], true);
+	const std::chrono::steady_clock::duration waited = std::chrono::steady_clock::now() - start;
+	//growing the file being written only touches its metadata under the pool's lock
+	PageId grown;
+	bufMgr->allocPage(file4ptr, grown, page);
+	bufMgr->unPinPage(file4ptr, grown, false);
+	checkpoint.join();
+	file4ptr->setWriteLatency(0);
+	bufMgr->disposePage(file4ptr, grown);
+	if(waited > std::chrono::milliseconds(150))
+	{
+		PRINT_ERROR("ERROR :: Pins should not wait for a checkpoint's write.");
+	}
+	if(bufMgr->flushAll().pages_dirty != 1 ||
+		 file4ptr->readPage(pageNos[0]).getRecord({pageNos[0], 2}) != "written later")
+	{
+		PRINT_ERROR("ERROR :: Page dirtied during a checkpoint's write should be written by the next one.");
+	}
+
+	std::cout << "Test 7 passed" << "\n";
+}
+
+void test8()
+{
+	//Save the working set and bring it back into a fresh pool in the background
+	const std::string& working_set = "test.ws";
+	bufMgr->flushAll();
+	bufMgr->saveWorkingSet(working_set);
+
+	{
+		BufMgr warm(num);
+		std::vector<File*> files;
+		files.push_back(file1ptr);
+		files.push_back(file4ptr);
+		files.push_back(file5ptr);
+		const std::uint32_t queued = warm.startPrewarm(working_set, files, 1000);
+		if(queued == 0)
+		{
+			PRINT_ERROR("ERROR :: Saved working set should queue pages for prewarming.");
+		}
+
+		//Reading while the prewarmer runs waits for or overtakes it, never doubling up
+		warm.readPage(file1ptr, pid[num - 1], page);
+		sprintf((char*)&tmpbuf, "test.1 Page %d %7.1f", pid[num - 1], (float)pid[num - 1]);
+		if(strncmp(page->getRecord(rid[num - 1]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+		{
+			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+		}
+		warm.unPinPage(file1ptr, pid[num - 1], false);
+
+		warm.waitForPrewarm();
+		const PrewarmStats stats = warm.getPrewarmStats();
+		if(stats.running || stats.pages_loaded == 0 ||
+			 stats.pages_loaded + stats.pages_skipped != stats.pages_queued)
+		{
+			PRINT_ERROR("ERROR :: Prewarmer should load the saved pages.");
+		}
+		for (i = 0; i < num; i++)
+		{
+			warm.readPage(file1ptr, pid[i], page);
+			sprintf((char*)&tmpbuf, "test.1 Page %d %7.1f", pid[i], (float)pid[i]);
+			if(strncmp(page->getRecord(rid[i]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+			warm.unPinPage(file1ptr, pid[i], false);
+		}
+	}
+	std::remove(working_set.c_str());
+
+	std::cout << "Test 8 passed" << "\n";
+}
+
+void test9()
+{
+	//A small pool backed by a compressed tier serves re-reads from memory
+	CompressedPageCache tier(64 * 1024);
+	{
+		BufMgr small(3);
+		small.addCacheTier(&tier);
+		for (int round = 0; round < 2; round++)
+		{
+			for (i = 0; i < 10; i++)
+			{
+				small.readPage(file1ptr, pid[i], page);
+				sprintf((char*)&tmpbuf, "test.1 Page %d %7.1f", pid[i], (float)pid[i]);
+				if(strncmp(page->getRecord(rid[i]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+				{
+					PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+				}
+				small.unPinPage(file1ptr, pid[i], false);
+			}
+		}
+	}
+	const CompressedPageCacheStats& stats = tier.stats();
+	if(stats.hits < 7 || stats.bytes > tier.budget() || stats.bytes >= stats.pages * Page::SIZE)
+	{
+		PRINT_ERROR("ERROR :: Compressed tier should serve evicted pages in compressed form.");
+	}
+
+	//Closing a file drops all of its pages, since its id is given to the next file opened
+	Page fetched;
+	tier.invalidateFile(file1ptr->id());
+	if(stats.pages != 0 || stats.bytes != 0 || tier.fetch(file1ptr->id(), pid[0], fetched))
+	{
+		PRINT_ERROR("ERROR :: Compressed tier should drop every page of a closed file.");
+	}
+
+	std::cout << "Test 9 passed" << "\n";
+}
+
+void test10()
+{
+	//A small pool backed by a four-page cache file serves re-reads from the file
+	FilePageCache tier("test.cache", 4);
+	BufMgr small(3);
+	small.addCacheTier(&tier);
+	for (int round = 0; round < 2; round++)
+	{
+		//The second round walks back over the pages evicted most recently
+		for (int n = 0; n < 8; n++)
+		{
+			i = round == 0 ? n : 7 - n;
+			small.readPage(file1ptr, pid[i], page);
+			sprintf((char*)&tmpbuf, "test.1 Page %d %7.1f", pid[i], (float)pid[i]);
+			if(strncmp(page->getRecord(rid[i]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+			{
+				PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			}
+			small.unPinPage(file1ptr, pid[i], false);
+		}
+	}
+	if(tier.stats().hits == 0 || tier.stats().evictions == 0 || tier.stats().pages > tier.capacity())
+	{
+		PRINT_ERROR("ERROR :: Cache file should serve evicted pages.");
+	}
+
+	//A page changed in the pool must come back from the tier with its changes
+	small.readPage(file1ptr, pid[0], page);
+	const RecordId changed = page->insertRecord("test.10 changed");
+	small.unPinPage(file1ptr, pid[0], true);
+	for (i = 1; i < 4; i++)
+	{
+		small.readPage(file1ptr, pid[i], page);
+		small.unPinPage(file1ptr, pid[i], false);
+	}
+	const std::uint64_t hits = tier.stats().hits;
+	small.readPage(file1ptr, pid[0], page);
+	if(tier.stats().hits != hits + 1 || page->getRecord(changed) != "test.10 changed")
+	{
+		PRINT_ERROR("ERROR :: Cache file returned a stale page.");
+	}
+	small.unPinPage(file1ptr, pid[0], false);
+
+	//Disposing of a page drops it from the tier
+	PageId disposed;
+	small.allocPage(file1ptr, disposed, page);
+	small.unPinPage(file1ptr, disposed, false);
+	for (i = 4; i < 7; i++)
+	{
+		small.readPage(file1ptr, pid[i], page);
+		small.unPinPage(file1ptr, pid[i], false);
+	}
+	const std::size_t pages = tier.stats().pages;
+	small.disposePage(file1ptr, disposed);
+	if(tier.stats().pages != pages - 1)
+	{
+		PRINT_ERROR("ERROR :: Disposed page was not dropped from the cache file.");
+	}
+
+	Page fetched;
+	tier.invalidateFile(file1ptr->id());
+	if(tier.stats().pages != 0 || tier.fetch(file1ptr->id(), pid[4], fetched))
+	{
+		PRINT_ERROR("ERROR :: Cache file should drop every page of a closed file.");
+	}
+
+	std::cout << "Test 10 passed" << "\n";
+}
+
+void testDurability()
+{
+	const std::string& filename = "test.d";
+	try
+	{
+		File::remove(filename);
+	}
+	catch(FileNotFoundException&)
+	{
+	}
+
+	{
+		File file = File::create(filename);
+		DurabilityPolicy policy = {DURABILITY_GROUP_COMMIT, 4 * Page::SIZE, 0};
+		file.setDurability(policy);
+
+		//Writes inside the group commit window are written but not yet durable
+		Page new_page = file.allocatePage();
+		new_page.insertRecord("durable?");
+		file.writePage(new_page);
+		if(file.isDurable())
+		{
+			PRINT_ERROR("ERROR :: Write inside the group commit window should not be durable yet.");
+		}
+
+		//Copies of the file share the policy, and an explicit sync covers every write
+		File copy = File::open(filename);
+		if(copy.durability().mode != DURABILITY_GROUP_COMMIT)
+		{
+			PRINT_ERROR("ERROR :: Durability policy should be shared by all File objects for a file.");
+		}
+		copy.sync();
+		if(!file.isDurable())
+		{
+			PRINT_ERROR("ERROR :: All writes should be durable after sync.");
+		}
+
+		//Crossing the byte window syncs on its own
+		for (int j = 0; j < 4; j++)
+		{
+			file.allocatePage();
+		}
+		if(!file.isDurable())
+		{
+			PRINT_ERROR("ERROR :: Writes past the group commit window should have been synced.");
+		}
+
+		//Per-write durability syncs every call
+		policy.mode = DURABILITY_PER_WRITE;
+		file.setDurability(policy);
+		new_page = file.readPage(new_page.page_number());
+		new_page.insertRecord("durable!");
+		file.writePage(new_page);
+		if(!file.isDurable())
+		{
+			PRINT_ERROR("ERROR :: Per-write durability should sync every write.");
+		}
+	}
+	File::remove(filename);
+
+	std::cout << "Durability test passed" << "\n";
+}
+
+void testAllocation()
+{
+	const std::string& filename = "test.a";
+	try
+	{
+		File::remove(filename);
+	}
+	catch(FileNotFoundException&)
+	{
+	}
+
+	{
+		File file = File::create(filename);
+		for (int j = 0; j < 10; j++)
+		{
+			file.allocatePage();
+		}
+		file.deletePage(7);
+		file.deletePage(3);
+
+		//Freed pages are reused lowest first before the file grows
+		if(file.allocatePage().page_number() != 3 || file.allocatePage().page_number() != 7 ||
+			 file.allocatePage().page_number() != 11)
+		{
+			PRINT_ERROR("ERROR :: Freed pages should be reused in page number order.");
+		}
+		file.deletePage(5);
+	}
+
+	{
+		//The bitmap survives reopening the file
+		File file = File::open(filename);
+		PageId expected = 1;
+		for (FileIterator iter = file.begin(); iter != file.end(); ++iter)
+		{
+			if(expected == 5)
+			{
+				expected++;
+			}
+			if((*iter).page_number() != expected)
+			{
+				PRINT_ERROR("ERROR :: Pages should be iterated in physical order, skipping free pages.");
+			}
+			expected++;
+		}
+		if(expected != 12)
+		{
+			PRINT_ERROR("ERROR :: Iteration should visit every used page.");
+		}
+		try
+		{
+			file.readPage(5);
+			PRINT_ERROR("ERROR :: Deleted page should not be readable.");
+		}
+		catch(InvalidPageException&)
+		{
+		}
+	}
+	File::remove(filename);
+
+	std::cout << "Allocation test passed" << "\n";
+}
+
+void testLegacyUpgrade()
+{
+	const std::string& filename = "test.l";
+	try
+	{
+		File::remove(filename);
+	}
+	catch(FileNotFoundException&)
+	{
+	}
+
+	{
+		//Hand-write a file in the unversioned layout: a 16 byte header followed by
+		//pages 1 and 3 in use and page 2 free.  Page 1 holds one record in slot 2
+		//and has slot 1 free; like every page of that era it keeps its free space
+		//lower bound and its number of free slots in the header.
+		std::ofstream legacy(filename.c_str(), std::ios::binary);
+		const PageId legacy_header[4] = {4 /* num_pages */, 1 /* first_used_page */,
+																		 1 /* num_free_pages */, 2 /* first_free_page */};
+		legacy.write(reinterpret_cast<const char*>(legacy_header), sizeof(legacy_header));
+		for (PageId n = 1; n <= 3; n++)
+		{
+			std::string page_bytes(Page::SIZE, '\0');
+			PageHeader page_header = {0, Page::DATA_SIZE, 0, 0 /* compact_slots */, 0, n == 2 ? 0 : n, n == 1 ? 3u : 0u};
+			if(n == 1)
+			{
+				const std::string record = "legacy record";
+				const PageSlot slot = {true, std::uint16_t(Page::DATA_SIZE - record.size()),
+															 std::uint16_t(record.size())};
+				page_header.fragmented_space = 2 * sizeof(slot);
+				page_header.free_space_upper_bound = slot.item_offset;
+				page_header.num_slots = 2;
+				page_header.first_free_slot = 1;
+				page_bytes.replace(sizeof(page_header) + sizeof(slot), sizeof(slot),
+													 reinterpret_cast<const char*>(&slot), sizeof(slot));
+				page_bytes.replace(sizeof(page_header) + slot.item_offset, record.size(), record);
+			}
+			page_bytes.replace(0, sizeof(page_header), reinterpret_cast<const char*>(&page_header),
+												 sizeof(page_header));
+			legacy.write(page_bytes.data(), page_bytes.size());
+		}
+	}
+
+	{
+		File file = File::open(filename);
+		FileIterator iter = file.begin();
+		if((*iter).page_number() != 1 || (*++iter).page_number() != 3 || ++iter != file.end())
+		{
+			PRINT_ERROR("ERROR :: Upgraded file should keep its used pages.");
+		}
+		Page first_page = file.readPage(1);
+		if(first_page.getRecord({1, 2}) != "legacy record" ||
+			 first_page.getFreeSpace() != Page::DATA_SIZE - 2 * sizeof(PageSlot) - 13 ||
+			 first_page.insertRecord("reused").slot_number != 1)
+		{
+			PRINT_ERROR("ERROR :: Upgraded pages should keep their records, free space and free slots.");
+		}
+
+		//The old 6-byte slots stay until the page is next compacted
+		if(first_page.getSlotSize() != sizeof(PageSlot))
+		{
+			PRINT_ERROR("ERROR :: Pages in the old slot format should keep it.");
+		}
+		std::vector<RecordId> rids;
+		while(first_page.hasSpaceForRecord("filler record"))
+		{
+			rids.push_back(first_page.insertRecord("filler record"));
+		}
+		//A record longer than the hole it replaces forces a compaction
+		first_page.deleteRecord(rids[0]);
+		const std::uint16_t free_space = first_page.getFreeSpace();
+		first_page.insertRecord("filler record plus");
+		if(first_page.getSlotSize() != sizeof(CompactPageSlot) ||
+			 first_page.getRecord({1, 2}) != "legacy record" ||
+			 first_page.getRecord({1, 1}) != "reused" ||
+			 first_page.getRecord(rids.back()) != "filler record" ||
+			 first_page.getFreeSpace() != free_space - 18 + (rids.size() + 2) * (sizeof(PageSlot) - sizeof(CompactPageSlot)))
+		{
+			PRINT_ERROR("ERROR :: Compacting an old page should switch it to compact slots.");
+		}
+		file.writePage(first_page);
+		if(file.readPage(1).getRecord({1, 2}) != "legacy record")
+		{
+			PRINT_ERROR("ERROR :: Page in the compact slot format should read back.");
+		}
+		Page page = file.readPage(3);
+		const RecordId& rid = page.insertRecord("upgraded");
+		file.writePage(page);
+		if(file.readPage(3).getRecord(rid) != "upgraded" || file.allocatePage().page_number() != 2)
+		{
+			PRINT_ERROR("ERROR :: Upgraded file should be usable.");
+		}
+	}
+	File::remove(filename);
+
+	std::cout << "Legacy upgrade test passed" << "\n";
+}
+
+void testSharedHeader()
+{
+	const std::string& filename = "test.h";
+	try
+	{
+		File::remove(filename);
+	}
+	catch(FileNotFoundException&)
+	{
+	}
+
+	{
+		//Every File object for the file sees the same cached header
+		File first = File::create(filename);
+		File second = File::open(filename);
+		File third = second;
+		if(first.allocatePage().page_number() != 1 || second.allocatePage().page_number() != 2 ||
+			 third.allocatePage().page_number() != 3)
+		{
+			PRINT_ERROR("ERROR :: File objects for the same file should share one header.");
+		}
+		second.deletePage(2);
+		if(first.allocatePage().page_number() != 2)
+		{
+			PRINT_ERROR("ERROR :: Page freed through one File object should be reused through another.");
+		}
+	}
+
+	{
+		//The cached header is written back when the last File object goes away
+		File file = File::open(filename);
+		if(file.allocatePage().page_number() != 4)
+		{
+			PRINT_ERROR("ERROR :: Cached header should be written back on close.");
+		}
+	}
+	File::remove(filename);
+
+	std::cout << "Shared header test passed" << "\n";
+}
+
+void testGrowth()
+{
+	const std::string& filename = "test.g";
+	try
+	{
+		File::remove(filename);
+	}
+	catch(FileNotFoundException&)
+	{
+	}
+
+	const std::streamoff extent = 1 << 20;
+	{
+		File file = File::create(filename);
+		GrowthPolicy policy = {extent / Page::SIZE, false, 0};
+		file.setGrowth(policy);
+
+		//The first page reserves a whole extent, and the pages after it come out of that extent
+		for (int j = 0; j < 100; j++)
+		{
+			Page new_page = file.allocatePage();
+			new_page.insertRecord("extent");
+			file.writePage(new_page);
+			std::ifstream on_disk(filename.c_str(), std::ios::binary | std::ios::ate);
+			if(on_disk.tellg() != extent)
+			{
+				PRINT_ERROR("ERROR :: File should grow by whole extents.");
+			}
+		}
+	}
+
+	{
+		File file = File::open(filename);
+		int num_pages = 0;
+		for (FileIterator iter = file.begin(); iter != file.end(); ++iter)
+		{
+			num_pages++;
+		}
+		if(num_pages != 100 || file.allocatePage().page_number() != 101)
+		{
+			PRINT_ERROR("ERROR :: Reserved but unused pages should not be treated as allocated.");
+		}
+	}
+	File::remove(filename);
+
+	std::cout << "Growth test passed" << "\n";
+}
+
+void testReclaim()
+{
+	const std::string& filename = "test.r";
+	try
+	{
+		File::remove(filename);
+	}
+	catch(FileNotFoundException&)
+	{
+	}
+
+	{
+		File file = File::create(filename);
+		for (int j = 0; j < 300; j++)
+		{
+			Page new_page = file.allocatePage();
+			new_page.insertRecord("reclaim me");
+			file.writePage(new_page);
+		}
+		for (PageId n = 101; n <= 300; n++)
+		{
+			file.deletePage(n);
+		}
+		for (PageId n = 10; n <= 50; n++)
+		{
+			file.deletePage(n);
+		}
+
+		//Trailing free pages are truncated away and the rest get holes punched over them
+		ReclaimStats stats = file.reclaimSpace();
+		if(stats.pages_truncated != 200 || stats.pages_punched != 41)
+		{
+			PRINT_ERROR("ERROR :: Free pages should have been truncated or punched.");
+		}
+		if(file.readPage(100).page_number() != 100 || file.readPage(51).page_number() != 51)
+		{
+			PRINT_ERROR("ERROR :: Used pages should survive reclamation.");
+		}
+
+		//Reclaiming again only punches, and counts, pages that still take up blocks
+		stats = file.reclaimSpace();
+		if(stats.pages_truncated != 0 || stats.pages_punched != 0)
+		{
+			PRINT_ERROR("ERROR :: Pages already punched should not be punched again.");
+		}
+		file.deletePage(70);
+		stats = file.reclaimSpace();
+		if(stats.pages_punched != 1)
+		{
+			PRINT_ERROR("ERROR :: A page deleted since should be punched.");
+		}
+
+		//Punched pages are handed out again first, then the file grows from its new end
+		if(file.allocatePage().page_number() != 10)
+		{
+			PRINT_ERROR("ERROR :: Punched pages should be reusable.");
+		}
+		//(Pages 11 to 50, and 70.)
+		for (int j = 0; j < 41; j++)
+		{
+			file.allocatePage();
+		}
+		if(file.allocatePage().page_number() != 101)
+		{
+			PRINT_ERROR("ERROR :: File should grow from its truncated end.");
+		}
+
+		//Pages deleted with hole punching on read back as free
+		file.setPunchHoles(true);
+		file.deletePage(60);
+		try
+		{
+			file.readPage(60);
+			PRINT_ERROR("ERROR :: Punched page should not be readable.");
+		}
+		catch(InvalidPageException&)
+		{
+		}
+		Page page = file.allocatePage();
+		if(page.page_number() != 60 || page.getFreeSpace() != Page::DATA_SIZE)
+		{
+			PRINT_ERROR("ERROR :: Punched page should be reallocated as an empty page.");
+		}
+	}
+	File::remove(filename);
+
+	std::cout << "Reclaim test passed" << "\n";
+}
+
+void testCompaction()
+{
+	const std::string& filename = "test.c";
+	try
+	{
+		File::remove(filename);
+	}
+	catch(FileNotFoundException&)
+	{
+	}
+
+	{
+		File file = File::create(filename);
+		for (i = 0; i < 20; i++)
+		{
+			Page new_page = file.allocatePage();
+			sprintf((char*)tmpbuf, "compact Page %d", new_page.page_number());
+			rid[i] = new_page.insertRecord(tmpbuf);
+			file.writePage(new_page);
+		}
+		for (PageId n = 2; n <= 20; n += 3)
+		{
+			file.deletePage(n);
+		}
+
+		const PageForwardingMap forwarding = file.compact();
+
+		//Used pages are now contiguous from the start of the file and keep their order
+		PageId expected = 1;
+		PageId last_original = 0;
+		for (FileIterator iter = file.begin(); iter != file.end(); ++iter)
+		{
+			Page page = *iter;
+			if(page.page_number() != expected++)
+			{
+				PRINT_ERROR("ERROR :: Compacted file should have no holes.");
+			}
+			PageId original;
+			sscanf(page.getRecord({page.page_number(), 1}).c_str(), "compact Page %u", &original);
+			if(original <= last_original)
+			{
+				PRINT_ERROR("ERROR :: Compaction should keep pages in order.");
+			}
+			last_original = original;
+		}
+		if(expected != 14 || file.allocatePage().page_number() != 14)
+		{
+			PRINT_ERROR("ERROR :: Compaction should truncate the free pages.");
+		}
+
+		//Record IDs of moved pages are translated through the forwarding map
+		for (i = 0; i < 20; i++)
+		{
+			if(i % 3 == 1)
+			{
+				continue;
+			}
+			const RecordId moved = forwardRecordId(forwarding, rid[i]);
+			sprintf((char*)tmpbuf, "compact Page %d", rid[i].page_number);
+			if(file.readPage(moved.page_number).getRecord(moved) != tmpbuf)
+			{
+				PRINT_ERROR("ERROR :: Forwarded record ID should find the moved record.");
+			}
+		}
+	}
+	File::remove(filename);
+
+	//A pool and its tier drop what they hold of a compacted file, after writing what is dirty
+	{
+		CompressedPageCache tier(64 * 1024);
+		BufMgr buffers(2);
+		buffers.addCacheTier(&tier);
+		File file = File::create(filename);
+		for (i = 0; i < 4; i++)
+		{
+			Page new_page = file.allocatePage();
+			sprintf((char*)tmpbuf, "compact pool %d", new_page.page_number());
+			new_page.insertRecord(tmpbuf);
+			file.writePage(new_page);
+		}
+		file.deletePage(1);
+		Page* page;
+		//Page 2 goes out to the tier, page 3 stays clean in the pool and page 4 dirty
+		for (PageId n = 2; n <= 4; n++)
+		{
+			buffers.readPage(&file, n, page);
+			if(n == 4)
+			{
+				page->insertRecord("CHANGED");
+			}
+			buffers.unPinPage(&file, n, n == 4);
+		}
+
+		buffers.readPage(&file, 3, page);
+		try
+		{
+			file.compact();
+			PRINT_ERROR("ERROR :: Compaction should refuse while a page is pinned.");
+		}
+		catch(PagePinnedException&)
+		{
+		}
+		buffers.unPinPage(&file, 3, false);
+		if(file.readPage(4).getRecord({4, 1}) != "compact pool 4")
+		{
+			PRINT_ERROR("ERROR :: Refused compaction should move nothing.");
+		}
+
+		file.compact();
+		for (PageId n = 1; n <= 3; n++)
+		{
+			buffers.readPage(&file, n, page);
+			sprintf((char*)tmpbuf, "compact pool %d", n + 1);
+			if(page->getRecord({n, 1}) != tmpbuf)
+			{
+				PRINT_ERROR("ERROR :: Pool should not serve a page under its number before compaction.");
+			}
+			buffers.unPinPage(&file, n, false);
+		}
+		buffers.readPage(&file, 3, page);
+		if(page->getRecord({3, 2}) != "CHANGED")
+		{
+			PRINT_ERROR("ERROR :: Dirty page should be written before compaction moves it.");
+		}
+		buffers.unPinPage(&file, 3, false);
+	}
+	File::remove(filename);
+
+	std::cout << "Compaction test passed" << "\n";
+}
+
+void testFileIds()
+{
+	const std::string& filename1 = "test.i1";
+	const std::string& filename2 = "test.i2";
+	try
+	{
+		File::remove(filename1);
+	}
+	catch(FileNotFoundException&)
+	{
+	}
+	try
+	{
+		File::remove(filename2);
+	}
+	catch(FileNotFoundException&)
+	{
+	}
+
+	{
+		File first = File::create(filename1);
+		File second = File::open(filename1);
+		File copy = first;
+		if(first.id() != second.id() || first.id() != copy.id())
+		{
+			PRINT_ERROR("ERROR :: File objects for the same file should share an id.");
+		}
+		FileId closed_id;
+		{
+			File other = File::create(filename2);
+			closed_id = other.id();
+			if(other.id() == first.id() || other.filename() != filename2)
+			{
+				PRINT_ERROR("ERROR :: Different files should get different ids.");
+			}
+		}
+		//The id of a closed file is handed out again
+		File reopened = File::open(filename2);
+		if(reopened.id() != closed_id)
+		{
+			PRINT_ERROR("ERROR :: Ids of closed files should be reused.");
+		}
+		copy = reopened;
+		if(copy.id() != reopened.id() || copy.filename() != filename2)
+		{
+			PRINT_ERROR("ERROR :: Assignment should take over the id.");
+		}
+	}
+	File::remove(filename1);
+	File::remove(filename2);
+
+	std::cout << "File id test passed" << "\n";
+}
+
+void testReusedFileIds()
+{
+	const std::string& filename1 = "test.r1";
+	const std::string& filename2 = "test.r2";
+	try
+	{
+		File::remove(filename1);
+	}
+	catch(FileNotFoundException&)
+	{
+	}
+	try
+	{
+		File::remove(filename2);
+	}
+	catch(FileNotFoundException&)
+	{
+	}
+
+	CompressedPageCache tier(64 * 1024);
+	BufMgr buffers(2);
+	buffers.addCacheTier(&tier);
+	Page* page;
+	FileId closed_id;
+	PageId evicted, resident;
+	{
+		File file1 = File::create(filename1);
+		closed_id = file1.id();
+		buffers.allocPage(&file1, evicted, page);
+		page->insertRecord("FROM_FILE_1");
+		buffers.unPinPage(&file1, evicted, true);
+		//Push the first page out to the tier, and leave the last one dirty in the pool
+		for (int n = 0; n < 2; n++)
+		{
+			buffers.allocPage(&file1, resident, page);
+			page->insertRecord("FROM_FILE_1");
+			buffers.unPinPage(&file1, resident, true);
+		}
+	}
+	if(tier.stats().pages != 0)
+	{
+		PRINT_ERROR("ERROR :: Closing a file should drop its pages from the cache tiers.");
+	}
+	{
+		//The dirty page was written when the file closed
+		File file1 = File::open(filename1);
+		Page written = file1.readPage(resident);
+		if(written.beginViews() == written.endViews() || (*written.beginViews()).str() != "FROM_FILE_1")
+		{
+			PRINT_ERROR("ERROR :: Closing a file should write its dirty pages.");
+		}
+	}
 
-    // delete the bufMgr before deleting files
-	delete bufMgr;
+	{
+		//A new file under the same id must see its own pages, not the closed file's
+		File file2 = File::create(filename2);
+		if(file2.id() != closed_id)
+		{
+			PRINT_ERROR("ERROR :: Test expects the closed file's id to be reused.");
+		}
+		PageId page_number = Page::INVALID_NUMBER;
+		while(page_number != resident)
+		{
+			buffers.allocPage(&file2, page_number, page);
+			if(page->beginViews() != page->endViews())
+			{
+				PRINT_ERROR("ERROR :: New file was handed a page of a closed file.");
+			}
+			buffers.unPinPage(&file2, page_number, false);
+		}
+		buffers.readPage(&file2, evicted, page);
+		if(page->beginViews() != page->endViews())
+		{
+			PRINT_ERROR("ERROR :: New file was handed a page of a closed file.");
+		}
+		buffers.unPinPage(&file2, evicted, false);
+	}
 
-	//Close files before deleting them
-	file1.~File();
-	file2.~File();
-	file3.~File();
-	file4.~File();
-	file5.~File();
+	//Closing a file with a pinned page still drops the page, but says so
+	{
+		File file2 = File::open(filename2);
+		File file1 = File::open(filename1);
+		buffers.readPage(&file1, resident, page);
+		try
+		{
+			file1 = file2;
+			PRINT_ERROR("ERROR :: Closing a file with a pinned page should throw.");
+		}
+		catch(PagePinnedException&)
+		{
+		}
+		//Its frame is free again, so both frames of the pool can be pinned
+		buffers.readPage(&file2, evicted, page);
+		buffers.readPage(&file2, resident, page);
+		buffers.unPinPage(&file2, evicted, false);
+		buffers.unPinPage(&file2, resident, false);
+	}
 
-	//Delete files
+	//Pages outlive the File object that brought them in while another for the file is open
+	{
+		File file1 = File::open(filename1);
+		PageId copied;
+		{
+			File copy = file1;
+			buffers.allocPage(&copy, copied, page);
+			page->insertRecord("FROM_COPY");
+			buffers.unPinPage(&copy, copied, true);
+		}
+		buffers.flushFile(&file1);
+		{
+			File copy = file1;
+			buffers.readPage(&copy, copied, page);
+			page->insertRecord("FROM_COPY");
+			buffers.unPinPage(&copy, copied, true);
+		}
+		//Evicting the page writes it through the file still open
+		buffers.readPage(&file1, evicted, page);
+		buffers.unPinPage(&file1, evicted, false);
+		buffers.readPage(&file1, resident, page);
+		buffers.unPinPage(&file1, resident, false);
+		if(file1.readPage(copied).getRecord({copied, 2}) != "FROM_COPY")
+		{
+			PRINT_ERROR("ERROR :: Pages brought in through a copy should be written after the copy is gone.");
+		}
+	}
 	File::remove(filename1);
 	File::remove(filename2);
-	File::remove(filename3);
-	File::remove(filename4);
-	File::remove(filename5);
 
-	std::cout << "\n" << "Passed all tests." << "\n";
+	std::cout << "Reused file id test passed" << "\n";
 }
 
-void test1()
+void testDescriptorCache()
 {
-	//Allocating pages in a file...
-	for (i = 0; i < num; i++)
+	const int num_files = 5;
+	std::string names[num_files];
+	for (int f = 0; f < num_files; f++)
 	{
-		bufMgr->allocPage(file1ptr, pid[i], page);
-		sprintf((char*)tmpbuf, "test.1 Page %d %7.1f", pid[i], (float)pid[i]);
-		rid[i] = page->insertRecord(tmpbuf);
-		bufMgr->unPinPage(file1ptr, pid[i], true);
+		names[f] = "test.fd" + std::to_string(f);
+		try
+		{
+			File::remove(names[f]);
+		}
+		catch(FileNotFoundException&)
+		{
+		}
 	}
 
-	//Reading pages back...
-	for (i = 0; i < num; i++)
+	const std::size_t old_limit = File::descriptorLimit();
+	File::setDescriptorLimit(2);
 	{
-		bufMgr->readPage(file1ptr, pid[i], page);
-		sprintf((char*)&tmpbuf, "test.1 Page %d %7.1f", pid[i], (float)pid[i]);
-		if(strncmp(page->getRecord(rid[i]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+		std::vector<File> files;
+		PageId page_numbers[num_files];
+		for (int f = 0; f < num_files; f++)
 		{
-			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			files.push_back(File::create(names[f]));
+			Page new_page = files[f].allocatePage();
+			new_page.insertRecord(names[f]);
+			files[f].writePage(new_page);
+			page_numbers[f] = new_page.page_number();
+		}
+		const DescriptorCacheStats before = File::descriptorStats();
+
+		//Every file stays usable although only two descriptors may be open
+		for (int round = 0; round < 3; round++)
+		{
+			for (int f = 0; f < num_files; f++)
+			{
+				if(files[f].readPage(page_numbers[f]).getRecord({page_numbers[f], 1}) != names[f])
+				{
+					PRINT_ERROR("ERROR :: Page read through a re-opened descriptor is wrong.");
+				}
+			}
+		}
+		const DescriptorCacheStats after = File::descriptorStats();
+		if(after.open_descriptors > 2 || after.reopens <= before.reopens ||
+			 after.evictions <= before.evictions)
+		{
+			PRINT_ERROR("ERROR :: Descriptor cache should stay within its limit by re-opening files.");
 		}
-		bufMgr->unPinPage(file1ptr, pid[i], false);
 	}
-	std::cout<< "Test 1 passed" << "\n";
+	File::setDescriptorLimit(old_limit);
+	for (int f = 0; f < num_files; f++)
+	{
+		File::remove(names[f]);
+	}
+
+	std::cout << "Descriptor cache test passed" << "\n";
 }
 
-void test2()
+void testMultiPageIo()
 {
-	//Writing and reading back multiple files
-	//The page number and the value should match
+	const std::string& filename = "test.v";
+	try
+	{
+		File::remove(filename);
+	}
+	catch(FileNotFoundException&)
+	{
+	}
 
-	for (i = 0; i < num/3; i++) 
 	{
-		bufMgr->allocPage(file2ptr, pageno2, page2);
-		sprintf((char*)tmpbuf, "test.2 Page %d %7.1f", pageno2, (float)pageno2);
-		rid2 = page2->insertRecord(tmpbuf);
+		File file = File::create(filename);
+		const int num_pages = 12;
+		Page pages[num_pages];
+		for (int n = 0; n < num_pages; n++)
+		{
+			pages[n] = file.allocatePage();
+		}
 
-		int index = rand() % num;
-        pageno1 = pid[index];
-		bufMgr->readPage(file1ptr, pageno1, page);
-		sprintf((char*)tmpbuf, "test.1 Page %d %7.1f", pageno1, (float)pageno1);
-		if(strncmp(page->getRecord(rid[index]).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+		//Pages given out of order, with a gap, are written by page number
+		std::vector<const Page*> to_write;
+		for (int n = num_pages - 1; n >= 0; n--)
 		{
-			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			if(n == 5)
+			{
+				continue;
+			}
+			sprintf((char*)tmpbuf, "vectored Page %d", pages[n].page_number());
+			pages[n].insertRecord(tmpbuf);
+			to_write.push_back(&pages[n]);
 		}
+		file.writePages(to_write);
 
-		bufMgr->allocPage(file3ptr, pageno3, page3);
-		sprintf((char*)tmpbuf, "test.3 Page %d %7.1f", pageno3, (float)pageno3);
-		rid3 = page3->insertRecord(tmpbuf);
+		Page read[num_pages];
+		file.readPages(1, num_pages, read);
+		for (int n = 0; n < num_pages; n++)
+		{
+			if(n == 5)
+			{
+				if(read[n].getFreeSpace() != pages[n].getFreeSpace())
+				{
+					PRINT_ERROR("ERROR :: Page left out of writePages should be unchanged.");
+				}
+				continue;
+			}
+			sprintf((char*)tmpbuf, "vectored Page %d", n + 1);
+			if(read[n].page_number() != PageId(n + 1) ||
+				 read[n].getRecord({PageId(n + 1), 1}) != tmpbuf)
+			{
+				PRINT_ERROR("ERROR :: readPages should return the pages written by writePages.");
+			}
+		}
 
-		bufMgr->readPage(file2ptr, pageno2, page2);
-		sprintf((char*)&tmpbuf, "test.2 Page %d %7.1f", pageno2, (float)pageno2);
-		if(strncmp(page2->getRecord(rid2).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+		file.deletePage(7);
+		try
+		{
+			file.readPages(5, 4, read);
+			PRINT_ERROR("ERROR :: readPages of a deleted page should throw.");
+		}
+		catch(InvalidPageException&)
 		{
-			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
 		}
+	}
+	File::remove(filename);
 
-		bufMgr->readPage(file3ptr, pageno3, page3);
-		sprintf((char*)&tmpbuf, "test.3 Page %d %7.1f", pageno3, (float)pageno3);
-		if(strncmp(page3->getRecord(rid3).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+	std::cout << "Multi-page I/O test passed" << "\n";
+}
+
+void testCompression()
+{
+	const std::string& filename = "test.z";
+	try
+	{
+		File::remove(filename);
+	}
+	catch(FileNotFoundException&)
+	{
+	}
+
+	const int num_pages = 20;
+	{
+		File file = File::create(filename, true /* compressed */);
+		if(!file.compressed())
 		{
-			PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+			PRINT_ERROR("ERROR :: File should be created compressed.");
+		}
+		std::vector<Page> pages(num_pages);
+		std::vector<const Page*> to_write;
+		for (int n = 0; n < num_pages; n++)
+		{
+			pages[n] = file.allocatePage();
+			for (int record = 0; record < 100; record++)
+			{
+				sprintf((char*)tmpbuf, "compressed page %d record %d", n + 1, record);
+				pages[n].insertRecord(tmpbuf);
+			}
+			to_write.push_back(&pages[n]);
 		}
+		file.writePages(to_write);
 
-		bufMgr->unPinPage(file1ptr, pageno1, false);
+		const CompressionStats stats = file.compressionStats();
+		if(stats.pages != PageId(num_pages) || stats.stored_bytes >= num_pages * Page::SIZE / 2)
+		{
+			PRINT_ERROR("ERROR :: Repetitive pages should take less than half their size.");
+		}
+
+		//Rewrites and deletes leave old images behind until space is reclaimed
+		file.deletePage(3);
+		to_write.erase(to_write.begin() + 2);
+		for (int round = 0; round < 3; round++)
+		{
+			file.writePages(to_write);
+		}
+		if(file.compressionStats().garbage_bytes == 0)
+		{
+			PRINT_ERROR("ERROR :: Rewritten pages should leave garbage behind.");
+		}
+		file.reclaimSpace();
+		if(file.compressionStats().garbage_bytes != 0 ||
+			 file.compressionStats().pages != PageId(num_pages - 1))
+		{
+			PRINT_ERROR("ERROR :: reclaimSpace should drop old images.");
+		}
 	}
 
-	for (i = 0; i < num/3; i++) {
-		bufMgr->unPinPage(file2ptr, i+1, true);
-		bufMgr->unPinPage(file2ptr, i+1, true);
-		bufMgr->unPinPage(file3ptr, i+1, true);
-		bufMgr->unPinPage(file3ptr, i+1, true);
+	{
+		File file = File::open(filename);
+		if(!file.compressed())
+		{
+			PRINT_ERROR("ERROR :: Compression setting should persist.");
+		}
+		std::vector<Page> read(num_pages);
+		file.readPages(4, num_pages - 3, &read[0]);
+		for (int n = 1; n <= num_pages; n++)
+		{
+			if(n == 3)
+			{
+				continue;
+			}
+			const Page page = n < 4 ? file.readPage(n) : read[n - 4];
+			sprintf((char*)tmpbuf, "compressed page %d record %d", n, 99);
+			if(page.page_number() != PageId(n) ||
+				 page.getRecord({PageId(n), 100}) != tmpbuf)
+			{
+				PRINT_ERROR("ERROR :: Compressed pages should read back as written.");
+			}
+		}
+		int pages_seen = 0;
+		for (FileIterator iter = file.begin(); iter != file.end(); ++iter)
+		{
+			pages_seen++;
+		}
+		if(pages_seen != num_pages - 1)
+		{
+			PRINT_ERROR("ERROR :: Iterator should visit every used compressed page.");
+		}
+
+		//A page that does not compress is stored as it is
+		Page noise = file.allocatePage();
+		std::string random_bytes(Page::DATA_SIZE / 2, '\0');
+		for (std::size_t i = 0; i < random_bytes.size(); i++)
+		{
+			random_bytes[i] = static_cast<char>(rand());
+		}
+		const RecordId rid = noise.insertRecord(random_bytes);
+		file.writePage(noise);
+		if(file.readPage(noise.page_number()).getRecord(rid) != random_bytes)
+		{
+			PRINT_ERROR("ERROR :: Incompressible page should read back as written.");
+		}
 	}
+	File::remove(filename);
 
-	std::cout << "Test 2 passed" << "\n";
+	std::cout << "Compression test passed" << "\n";
 }
 
-void test3()
+/**
+ * Flips one byte of the first occurrence of <text> in the named file.
+ */
+void corruptFile(const std::string& filename, const std::string& text)
+{
+	std::fstream stream(filename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+	const std::string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	const std::size_t position = contents.find(text);
+	if(position == std::string::npos)
+	{
+		PRINT_ERROR("ERROR :: Text to corrupt not found in file.");
+	}
+	stream.clear();
+	stream.seekp(position);
+	stream.put(contents[position] ^ 0x20);
+}
+
+void testChecksums()
 {
+	const std::string& filename = "test.k";
 	try
 	{
-		bufMgr->readPage(file4ptr, 1, page);
-		PRINT_ERROR("ERROR :: File4 should not exist. Exception should have been thrown before execution reaches this point.");
+		File::remove(filename);
 	}
-	catch(InvalidPageException e)
+	catch(FileNotFoundException&)
 	{
 	}
 
-	std::cout << "Test 3 passed" << "\n";
+	//Known answer from RFC 3720
+	if(Crc32c::extend(0, "123456789", 9) != 0xe3069283 ||
+		 Crc32c::extendPortable(0, "123456789", 9) != 0xe3069283 ||
+		 Crc32c::extend(Crc32c::extend(0, "1234", 4), "56789", 5) != 0xe3069283)
+	{
+		PRINT_ERROR("ERROR :: CRC-32C gave the wrong checksum.");
+	}
+	std::vector<char> bytes(3 * Page::SIZE);
+	for (std::size_t n = 0; n < bytes.size(); n++)
+	{
+		bytes[n] = static_cast<char>(n * 131 + n / 7);
+	}
+	for (std::size_t length = 0; length < bytes.size(); length += 61)
+	{
+		if(Crc32c::extend(7, &bytes[0], length) != Crc32c::extendPortable(7, &bytes[0], length))
+		{
+			PRINT_ERROR("ERROR :: CRC-32C implementations disagree.");
+		}
+	}
+
+	{
+		File file = File::create(filename);
+		for (int n = 1; n <= 3; n++)
+		{
+			Page new_page = file.allocatePage();
+			sprintf((char*)tmpbuf, "checksummed page %d", n);
+			new_page.insertRecord(tmpbuf);
+			file.writePage(new_page);
+		}
+		file.sync();
+
+		//Without verification a damaged page reads back silently
+		corruptFile(filename, "checksummed page 1");
+		if(file.checksums() || file.readPage(1).getRecord({1, 1}) != "Checksummed page 1")
+		{
+			PRINT_ERROR("ERROR :: Damaged page should read back without checksums.");
+		}
+
+		//Turning verification on stamps pages whose checksums do not match
+		file.setChecksums(true);
+		if(!file.checksums() || file.readPage(1).getRecord({1, 1}) != "Checksummed page 1")
+		{
+			PRINT_ERROR("ERROR :: Enabling checksums should accept existing pages.");
+		}
+	}
+
+	corruptFile(filename, "checksummed page 2");
+	{
+		File file = File::open(filename);
+		if(!file.checksums())
+		{
+			PRINT_ERROR("ERROR :: Checksum setting should persist.");
+		}
+		file.readPage(3);
+		try
+		{
+			file.readPage(2);
+			PRINT_ERROR("ERROR :: Reading a damaged page should throw.");
+		}
+		catch(CorruptPageException&)
+		{
+		}
+		Page pages[3];
+		try
+		{
+			file.readPages(1, 3, pages);
+			PRINT_ERROR("ERROR :: Reading a damaged page should throw.");
+		}
+		catch(CorruptPageException&)
+		{
+		}
+
+		//Rewriting the page gives it a fresh checksum
+		file.setChecksums(false);
+		file.writePage(file.readPage(2));
+		file.setChecksums(true);
+		file.readPage(2);
+	}
+	File::remove(filename);
+
+	std::cout << "Checksum test passed" << "\n";
 }
 
-void test4()
+void testFixedRecordFile()
 {
-	bufMgr->allocPage(file4ptr, i, page);
-	bufMgr->unPinPage(file4ptr, i, true);
+	const std::string& filename = "test.fixed";
 	try
 	{
-		bufMgr->unPinPage(file4ptr, i, false);
-		PRINT_ERROR("ERROR :: Page is already unpinned. Exception should have been thrown before execution reaches this point.");
+		File::remove(filename);
 	}
-	catch(PageNotPinnedException e)
+	catch(FileNotFoundException&)
 	{
 	}
 
-	std::cout << "Test 4 passed" << "\n";
-}
+	const int num_pages = 3;
+	std::vector<RecordId> rids;
+	{
+		File file = File::create(filename, false /* compressed */, 24 /* record_size */);
+		BufMgr buffers(num_pages + 1);
+		for (int n = 0; n < num_pages; n++)
+		{
+			PageId page_number;
+			Page* page;
+			buffers.allocPage(&file, page_number, page);
+			FixedPage<24> fixed(*page);
+			while(fixed.hasSpaceForRecord())
+			{
+				sprintf((char*)tmpbuf, "page %d record %06d....", n, (int)rids.size());
+				rids.push_back(fixed.insertRecord(tmpbuf));
+			}
+			buffers.unPinPage(&file, page_number, true);
+		}
+		buffers.flushFile(&file);
+	}
 
-void test5()
-{
-	for (i = 0; i < num; i++) {
-		bufMgr->allocPage(file5ptr, pid[i], page);
-		sprintf((char*)tmpbuf, "test.5 Page %d %7.1f", pid[i], (float)pid[i]);
-		rid[i] = page->insertRecord(tmpbuf);
+	{
+		File file = File::open(filename);
+		if(file.recordSize() != 24)
+		{
+			PRINT_ERROR("ERROR :: Record size should persist with the file.");
+		}
+		std::size_t n = 0;
+		for (FileIterator iter = file.begin(); iter != file.end(); ++iter)
+		{
+			Page page = *iter;
+			FixedPage<24> fixed(page);
+			for (FixedPage<24>::ViewIterator iter = fixed.beginViews(); iter != fixed.endViews(); ++iter, n++)
+			{
+				sprintf((char*)tmpbuf, "page %d record %06d....", (int)(page.page_number() - 1), (int)n);
+				if(n >= rids.size() || iter.record_id() != rids[n] || (*iter).str() != tmpbuf)
+				{
+					PRINT_ERROR("ERROR :: Fixed records should read back from the file.");
+				}
+			}
+		}
+		if(n != rids.size())
+		{
+			PRINT_ERROR("ERROR :: Every fixed record should read back from the file.");
+		}
 	}
+	File::remove(filename);
 
-	PageId tmp;
+	std::cout << "Fixed record file test passed" << "\n";
+}
+
+void testColumnarFile()
+{
+	const std::string& filename = "test.pax";
 	try
 	{
-		bufMgr->allocPage(file5ptr, tmp, page);
-		PRINT_ERROR("ERROR :: No more frames left for allocation. Exception should have been thrown before execution reaches this point.");
+		File::remove(filename);
 	}
-	catch(BufferExceededException e)
+	catch(FileNotFoundException&)
 	{
 	}
 
-	std::cout << "Test 5 passed" << "\n";
+	std::vector<std::uint16_t> widths;
+	widths.push_back(8);
+	widths.push_back(4);
+	const PaxSchema schema(widths);
+	RecordId last_rid;
+	{
+		File file = File::create(filename, false /* compressed */, 12 /* record_size */, true /* columnar */);
+		Page page = file.allocatePage();
+		PaxPage pax(page, schema);
+		while(pax.hasSpaceForRecord())
+		{
+			last_rid = pax.insertRecord("columnar.rec");
+		}
+		file.writePage(page);
+	}
 
-	for (i = 1; i <= num; i++)
-		bufMgr->unPinPage(file5ptr, i, true);
+	{
+		File file = File::open(filename);
+		if(!file.columnar() || file.recordSize() != 12)
+		{
+			PRINT_ERROR("ERROR :: Columnar layout should persist with the file.");
+		}
+		Page page = file.readPage(last_rid.page_number);
+		const PaxPage pax(page, schema);
+		if(pax.getNumRecords() != schema.capacity() ||
+			 std::memcmp(pax.getField(last_rid, 1), ".rec", 4) != 0)
+		{
+			PRINT_ERROR("ERROR :: Columnar records should read back from the file.");
+		}
+	}
+	File::remove(filename);
+
+	std::cout << "Columnar file test passed" << "\n";
 }
 
-void test6()
+void testRecordScanFile()
 {
-	//flushing file with pages still pinned. Should generate an error
-	for (i = 1; i <= num; i++) {
-		bufMgr->readPage(file1ptr, i, page);
-	}
-
+	const std::string& filename = "test.scan";
 	try
 	{
-		bufMgr->flushFile(file1ptr);
-		PRINT_ERROR("ERROR :: Pages pinned for file being flushed. Exception should have been thrown before execution reaches this point.");
+		File::remove(filename);
 	}
-	catch(PagePinnedException e)
+	catch(FileNotFoundException&)
 	{
 	}
 
-	std::cout << "Test 6 passed" << "\n";
+	const int num_pages = 3;
+	std::vector<RecordId> expected;
+	{
+		File file = File::create(filename);
+		BufMgr buffers(2);
+		for (int n = 0, i = 0; n < num_pages; n++)
+		{
+			PageId page_number;
+			Page* page;
+			buffers.allocPage(&file, page_number, page);
+			for (; page->hasSpaceForRecord(16); i++)
+			{
+				const std::int32_t key = i % 10;
+				std::memcpy(tmpbuf, &key, 4);
+				sprintf((char*)tmpbuf + 4, "record %05d", i);
+				const RecordId rid = page->insertRecord(tmpbuf, 16);
+				if(key < 3)
+				{
+					expected.push_back(rid);
+				}
+			}
+			buffers.unPinPage(&file, page_number, true);
+		}
 
-	for (i = 1; i <= num; i++) 
-		bufMgr->unPinPage(file1ptr, i, true);
+		//More pages than frames, so the scan reads pages back and unpins them
+		const RecordScanner scanner(RecordPredicate::int32Between(0, 0, 2));
+		std::vector<RecordId> rids;
+		scanner.scanFile(file, buffers, rids);
+		if(rids != expected)
+		{
+			PRINT_ERROR("ERROR :: File scan should find the matching records of every page.");
+		}
+		buffers.flushFile(&file);
+	}
+	File::remove(filename);
 
-	bufMgr->flushFile(file1ptr);
-}
\ No newline at end of file
+	std::cout << "Record scan file test passed" << "\n";
+}
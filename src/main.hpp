@@ -18,6 +18,7 @@
  *     <ol>
  *       <li> @ref file_management_sec
  *       <li> @ref file_data_sec
+ *       <li> @ref durability_sec
  *       <li> @ref page_sec
  *     </ol>
  *   </ol>
@@ -157,6 +158,21 @@
  *   }
  * @endcode
  *
+ * @subsubsection durability_sec Making writes durable
+ *
+ * Writes reach the operating system as soon as the File call that issued them
+ * returns, but are only guaranteed to survive a crash once they have been
+ * synced to disk.  By default BadgerDB never syncs on its own; call
+ * File::sync() when you need everything written so far to be durable.  A
+ * different DurabilityPolicy can be set per file:
+ * @code
+ *   // Sync after every 1 MB written or every 50 ms, whichever comes first.
+ *   badgerdb::DurabilityPolicy policy =
+ *       {badgerdb::DURABILITY_GROUP_COMMIT, 1 << 20, 50};
+ *   db_file.setDurability(policy);
+ * @endcode
+ * See DurabilityMode for exactly what each mode guarantees.
+ *
  * @subsubsection page_sec Reading and writing data in a page
  *
  * Pages hold variable-length records containing arbitrary data.
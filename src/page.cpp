@@ -5,7 +5,7 @@
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
 
-#include <cassert>
+#include <cstring>
 
 #include "exceptions/insufficient_space_exception.h"
 #include "exceptions/invalid_record_exception.h"
@@ -16,51 +16,108 @@
 
 namespace badgerdb {
 
+const std::uint16_t CompactPageSlot::USED;
+
 Page::Page() {
   initialize();
 }
 
 void Page::initialize() {
-  header_.free_space_lower_bound = 0;
+  header_.fragmented_space = 0;
   header_.free_space_upper_bound = DATA_SIZE;
   header_.num_slots = 0;
-  header_.num_free_slots = 0;
+  header_.compact_slots = true;
+  header_.first_free_slot = INVALID_SLOT;
   header_.current_page_number = INVALID_NUMBER;
   header_.next_page_number = INVALID_NUMBER;
-  data_.assign(DATA_SIZE, char());
+  std::memset(data_, 0, DATA_SIZE);
 }
 
 RecordId Page::insertRecord(const std::string& record_data) {
-  if (!hasSpaceForRecord(record_data)) {
-    throw InsufficientSpaceException(
-        page_number(), record_data.length(), getFreeSpace());
+  return insertRecord(record_data.data(), record_data.length());
+}
+
+RecordId Page::insertRecord(const char* data, const std::size_t length) {
+  if (!hasSpaceForRecord(length)) {
+    throw InsufficientSpaceException(page_number(), length, getFreeSpace());
   }
+  reserveContiguousSpace(header_.first_free_slot == INVALID_SLOT
+                         ? length + getSlotSize() : length);
   const SlotId slot_number = getAvailableSlot();
-  insertRecordInSlot(slot_number, record_data);
+  insertRecordInSlot(slot_number, data, length);
   return {page_number(), slot_number};
 }
 
+std::size_t Page::insertRecords(const RecordView* records,
+                                const std::size_t count,
+                                RecordId* record_ids) {
+  std::size_t inserted = 0;
+  while (inserted < count && hasSpaceForRecord(records[inserted].length)) {
+    reserveContiguousSpace(header_.first_free_slot == INVALID_SLOT
+                           ? records[inserted].length + getSlotSize()
+                           : records[inserted].length);
+    const SlotId slot_number = getAvailableSlot();
+    insertRecordInSlot(slot_number, records[inserted].data,
+                       records[inserted].length);
+    record_ids[inserted] = {page_number(), slot_number};
+    ++inserted;
+  }
+  return inserted;
+}
+
 std::string Page::getRecord(const RecordId& record_id) const {
   validateRecordId(record_id);
-  const PageSlot& slot = getSlot(record_id.slot_number);
-  return data_.substr(slot.item_offset, slot.item_length);
+  const PageSlot slot = getSlot(record_id.slot_number);
+  return std::string(data_ + slot.item_offset, slot.item_length);
+}
+
+RecordView Page::getRecordView(const RecordId& record_id) const {
+  validateRecordId(record_id);
+  const PageSlot slot = getSlot(record_id.slot_number);
+  const RecordView view = {data_ + slot.item_offset, slot.item_length};
+  return view;
 }
 
 void Page::updateRecord(const RecordId& record_id,
                         const std::string& record_data) {
+  updateRecord(record_id, record_data.data(), record_data.length());
+}
+
+void Page::updateRecord(const RecordId& record_id, const char* data,
+                        const std::size_t length) {
   validateRecordId(record_id);
-  const PageSlot* slot = getSlot(record_id.slot_number);
+  PageSlot slot = getSlot(record_id.slot_number);
+  if (length <= slot.item_length) {
+    // The new version fits where the old one is, so overwrite it there.  The
+    // bytes it no longer needs go back to the free space if the record sits
+    // at the boundary (keeping it flush against the boundary), and become a
+    // hole otherwise.
+    const std::uint16_t shrink =
+        static_cast<std::uint16_t>(slot.item_length - length);
+    if (slot.item_offset == header_.free_space_upper_bound) {
+      slot.item_offset += shrink;
+      header_.free_space_upper_bound += shrink;
+    } else {
+      header_.fragmented_space += shrink;
+    }
+    slot.item_length = static_cast<std::uint16_t>(length);
+    setSlot(record_id.slot_number, slot);
+    std::memmove(data_ + slot.item_offset, data, length);
+    return;
+  }
+
   const std::size_t free_space_after_delete =
-      getFreeSpace() + slot->item_length;
-  if (record_data.length() > free_space_after_delete) {
+      getFreeSpace() + slot.item_length;
+  if (length > free_space_after_delete) {
     throw InsufficientSpaceException(
-        page_number(), record_data.length(), free_space_after_delete);
+        page_number(), length, free_space_after_delete);
   }
   // We have to disallow slot compaction here because we're going to place the
   // record data in the same slot, and compaction might delete the slot if we
   // permit it.
   deleteRecord(record_id, false /* allow_slot_compaction */);
-  insertRecordInSlot(record_id.slot_number, record_data);
+  reserveContiguousSpace(length);
+  insertRecordInSlot(record_id.slot_number, data, length);
 }
 
 void Page::deleteRecord(const RecordId& record_id) {
@@ -70,125 +127,207 @@ void Page::deleteRecord(const RecordId& record_id) {
 void Page::deleteRecord(const RecordId& record_id,
                         const bool allow_slot_compaction) {
   validateRecordId(record_id);
-  PageSlot* slot = getSlot(record_id.slot_number);
-  data_.replace(slot->item_offset, slot->item_length, slot->item_length, '\0');
+  const PageSlot slot = getSlot(record_id.slot_number);
 
-  // Compact the data by removing the hole left by this record (if necessary).
-  std::uint16_t move_offset = slot->item_offset; 
-  std::size_t move_bytes = 0;
-  for (SlotId i = 1; i <= header_.num_slots; ++i) {
-    PageSlot* other_slot = getSlot(i);
-    if (other_slot->used && other_slot->item_offset < slot->item_offset) {
-      if (other_slot->item_offset < move_offset) {
-        move_offset = other_slot->item_offset;
-      }
-      move_bytes += other_slot->item_length;
-      // Update the slot for the other data to reflect the soon-to-be-new
-      // location.
-      other_slot->item_offset += slot->item_length;
-    }
-  }
-  // If we have data to move, shift it to the right.
-  if (move_bytes > 0) {
-    const std::string& data_to_move = data_.substr(move_offset, move_bytes);
-    data_.replace(move_offset + slot->item_length, move_bytes, data_to_move);
+  // Leave the record's bytes where they are.  Only a record at the free space
+  // boundary can be given back directly; anything else becomes a hole that
+  // compactData() reclaims once the space is needed.
+  if (slot.item_offset == header_.free_space_upper_bound) {
+    header_.free_space_upper_bound += slot.item_length;
+  } else {
+    header_.fragmented_space += slot.item_length;
   }
-  header_.free_space_upper_bound += slot->item_length;
 
-  // Mark slot as unused.
-  slot->used = false;
-  slot->item_offset = 0;
-  slot->item_length = 0;
-  ++header_.num_free_slots;
+  linkFreeSlot(record_id.slot_number);
 
   if (allow_slot_compaction && record_id.slot_number == header_.num_slots) {
     // Last slot in the list, so we need to free any unused slots that are at
-    // the end of the slot list.
-    int num_slots_to_delete = 1;
-    for (SlotId i = 1; i < header_.num_slots; ++i) {
-      // Traverse list backwards, looking for unused slots.
-      const PageSlot* other_slot = getSlot(header_.num_slots - i);
-      if (!other_slot->used) {
-        ++num_slots_to_delete;
-      } else {
-        // Stop at the first used slot we find, since we can't move used slots
-        // without affecting record IDs.
-        break;
-      }
+    // the end of the slot list.  Stop at the first used slot we find, since
+    // we can't move used slots without affecting record IDs.
+    while (header_.num_slots > 0 && !getSlot(header_.num_slots).used) {
+      unlinkFreeSlot(header_.num_slots);
+      --header_.num_slots;
+    }
+  }
+
+  if (header_.free_space_upper_bound + header_.fragmented_space == DATA_SIZE) {
+    // No records left, so every hole is free space again.
+    header_.free_space_upper_bound = DATA_SIZE;
+    header_.fragmented_space = 0;
+  }
+}
+
+void Page::compactData() {
+  if (!header_.compact_slots) {
+    // Every record is touched anyway, so bring older pages up to date.
+    useCompactSlots();
+  }
+  // Pack the records into a scratch copy of the data area, then copy the
+  // packed region back in one go.
+  char packed[DATA_SIZE];
+  std::uint16_t upper_bound = DATA_SIZE;
+  for (SlotId i = 1; i <= header_.num_slots; ++i) {
+    PageSlot slot = getSlot(i);
+    if (slot.used) {
+      upper_bound -= slot.item_length;
+      std::memcpy(packed + upper_bound, data_ + slot.item_offset,
+                  slot.item_length);
+      slot.item_offset = upper_bound;
+      setSlot(i, slot);
     }
-    header_.num_slots -= num_slots_to_delete;
-    header_.num_free_slots -= num_slots_to_delete;
-    header_.free_space_lower_bound -= sizeof(PageSlot) * num_slots_to_delete;
   }
+  std::memcpy(data_ + upper_bound, packed + upper_bound,
+              DATA_SIZE - upper_bound);
+  // Keep unused space zeroed, as on a new page.
+  std::memset(data_ + getFreeSpaceLowerBound(), 0,
+              upper_bound - getFreeSpaceLowerBound());
+  header_.free_space_upper_bound = upper_bound;
+  header_.fragmented_space = 0;
 }
 
-bool Page::hasSpaceForRecord(const std::string& record_data) const {
-  std::size_t record_size = record_data.length();
-  if (header_.num_free_slots == 0) {
-    record_size += sizeof(PageSlot);
+bool Page::hasSpaceForRecord(const std::size_t length) const {
+  std::size_t record_size = length;
+  if (header_.first_free_slot == INVALID_SLOT) {
+    record_size += getSlotSize();
   }
   return record_size <= getFreeSpace();
 }
 
-PageSlot* Page::getSlot(const SlotId slot_number) {
-  return reinterpret_cast<PageSlot*>(
-      &data_[(slot_number - 1) * sizeof(PageSlot)]);
+void Page::setSlot(const SlotId slot_number, const PageSlot& slot) {
+  if (header_.compact_slots) {
+    CompactPageSlot* compact = reinterpret_cast<CompactPageSlot*>(
+        &data_[(slot_number - 1) * sizeof(CompactPageSlot)]);
+    compact->offset_and_used =
+        slot.used ? slot.item_offset | CompactPageSlot::USED
+                  : slot.item_offset;
+    compact->item_length = slot.item_length;
+  } else {
+    *reinterpret_cast<PageSlot*>(
+        &data_[(slot_number - 1) * sizeof(PageSlot)]) = slot;
+  }
 }
 
-const PageSlot& Page::getSlot(const SlotId slot_number) const {
-  return *reinterpret_cast<const PageSlot*>(
-      &data_[(slot_number - 1) * sizeof(PageSlot)]);
+void Page::useCompactSlots() {
+  // Slot i moves from offset 6(i-1) to 4(i-1), so converting in order never
+  // overwrites a slot before it has been read.
+  header_.compact_slots = true;
+  for (SlotId i = 1; i <= header_.num_slots; ++i) {
+    const PageSlot slot = *reinterpret_cast<const PageSlot*>(
+        &data_[(i - 1) * sizeof(PageSlot)]);
+    setSlot(i, slot);
+  }
 }
 
 SlotId Page::getAvailableSlot() {
-  SlotId slot_number = INVALID_SLOT;
-  if (header_.num_free_slots > 0) {
-    // Have an allocated but unused slot that we can reuse.
-    for (SlotId i = 1; i <= header_.num_slots; ++i) {
-      const PageSlot* slot = getSlot(i);
-      if (!slot->used) {
-        // We don't decrement the number of free slots until someone actually
-        // puts data in the slot.
-        slot_number = i;
+  if (header_.first_free_slot == INVALID_SLOT) {
+    // Have to allocate a new slot.  Its bytes may be left over from a record
+    // that used to live there; linking it overwrites all of them.  We don't
+    // take it out of the chain until someone actually puts data in the slot.
+    ++header_.num_slots;
+    linkFreeSlot(header_.num_slots);
+  }
+  return header_.first_free_slot;
+}
+
+SlotId Page::findNextUsedSlot(const SlotId start) const {
+  SlotId i = start + 1;
+  // Skip over runs of unused slots four at a time, testing the four used
+  // flags together.
+  if (header_.compact_slots) {
+    // The flags are bits 15 and 47 of each (little-endian) 8-byte pair of
+    // slots.
+    static const std::uint64_t USED_BITS =
+        std::uint64_t(CompactPageSlot::USED) << 32 | CompactPageSlot::USED;
+    for (; i + 3 <= header_.num_slots; i += 4) {
+      std::uint64_t words[2];
+      std::memcpy(words, &data_[(i - 1) * sizeof(CompactPageSlot)],
+                  sizeof(words));
+      if ((words[0] | words[1]) & USED_BITS) {
         break;
       }
     }
   } else {
-    // Have to allocate a new slot.
-    slot_number = header_.num_slots + 1;
-    ++header_.num_slots;
-    ++header_.num_free_slots;
-    header_.free_space_lower_bound = sizeof(PageSlot) * header_.num_slots;
+    for (; i + 3 <= header_.num_slots; i += 4) {
+      const char* flags = &data_[(i - 1) * sizeof(PageSlot)];
+      if (flags[0] | flags[sizeof(PageSlot)] | flags[2 * sizeof(PageSlot)] |
+          flags[3 * sizeof(PageSlot)]) {
+        break;
+      }
+    }
+  }
+  for (; i <= header_.num_slots; ++i) {
+    if (getSlot(i).used) {
+      return i;
+    }
+  }
+  return INVALID_SLOT;
+}
+
+void Page::linkFreeSlot(const SlotId slot_number) {
+  const PageSlot slot = {false /* used */, header_.first_free_slot /* next */,
+                         INVALID_SLOT /* previous */};
+  setSlot(slot_number, slot);
+  if (header_.first_free_slot != INVALID_SLOT) {
+    PageSlot next = getSlot(header_.first_free_slot);
+    next.item_length = slot_number;
+    setSlot(header_.first_free_slot, next);
+  }
+  header_.first_free_slot = slot_number;
+}
+
+void Page::unlinkFreeSlot(const SlotId slot_number) {
+  const PageSlot slot = getSlot(slot_number);
+  const SlotId next = slot.item_offset;
+  const SlotId previous = slot.item_length;
+  if (previous != INVALID_SLOT) {
+    PageSlot previous_slot = getSlot(previous);
+    previous_slot.item_offset = next;
+    setSlot(previous, previous_slot);
+  } else {
+    header_.first_free_slot = next;
+  }
+  if (next != INVALID_SLOT) {
+    PageSlot next_slot = getSlot(next);
+    next_slot.item_length = previous;
+    setSlot(next, next_slot);
   }
-  assert(slot_number != INVALID_SLOT);
-  return static_cast<SlotId>(slot_number);
 }
 
-void Page::insertRecordInSlot(const SlotId slot_number,
-                              const std::string& record_data) {
+void Page::rebuildFreeSlotChain() {
+  header_.first_free_slot = INVALID_SLOT;
+  for (SlotId i = header_.num_slots; i >= 1; --i) {
+    if (!getSlot(i).used) {
+      linkFreeSlot(i);
+    }
+  }
+}
+
+void Page::insertRecordInSlot(const SlotId slot_number, const char* data,
+                              const std::size_t length) {
   if (slot_number > header_.num_slots ||
       slot_number == INVALID_SLOT) {
     throw InvalidSlotException(page_number(), slot_number);
   }
-  PageSlot* slot = getSlot(slot_number);
-  if (slot->used) {
+  if (getSlot(slot_number).used) {
     throw SlotInUseException(page_number(), slot_number);
   }
-  const int record_length = record_data.length();
-  slot->used = true;
-  slot->item_length = record_length;
-  slot->item_offset = header_.free_space_upper_bound - record_length;
-  header_.free_space_upper_bound = slot->item_offset;
-  --header_.num_free_slots;
-  data_.replace(slot->item_offset, slot->item_length, record_data);
+  unlinkFreeSlot(slot_number);
+  header_.free_space_upper_bound -= length;
+  const PageSlot slot = {true /* used */, header_.free_space_upper_bound,
+                         static_cast<std::uint16_t>(length)};
+  setSlot(slot_number, slot);
+  std::memcpy(data_ + slot.item_offset, data, length);
 }
 
 void Page::validateRecordId(const RecordId& record_id) const {
   if (record_id.page_number != page_number()) {
     throw InvalidRecordException(record_id, page_number());
   }
-  const PageSlot& slot = getSlot(record_id.slot_number);
-  if (!slot.used) {
+  // Check the range first: past num_slots, getSlot() would decode record
+  // bytes (or bytes past the page) as a slot.
+  if (record_id.slot_number < 1 ||
+      record_id.slot_number > header_.num_slots ||
+      !getSlot(record_id.slot_number).used) {
     throw InvalidRecordException(record_id, page_number());
   }
 }
@@ -202,4 +341,12 @@ PageIterator Page::end() {
   return PageIterator(this, end_record_id);
 }
 
+PageViewIterator Page::beginViews() const {
+  return PageViewIterator(this);
+}
+
+PageViewIterator Page::endViews() const {
+  return PageViewIterator(this, Page::INVALID_SLOT);
+}
+
 }
@@ -24,10 +24,14 @@ namespace badgerdb {
  */
 struct PageHeader {
   /**
-   * Lower bound of the free space.  This is the offset of the first unused byte
-   * after the slot array.
+   * Bytes of record data freed by deletes and updates but still lying between
+   * live records.  Deleting a record leaves a hole rather than shifting the
+   * records below it; the holes are squeezed out in one pass when an insert
+   * or update needs more contiguous space than there is.  (Files written by
+   * format version 1 kept the free space lower bound here instead; it is now
+   * computed from the number of slots.)
    */
-  std::uint16_t free_space_lower_bound;
+  std::uint16_t fragmented_space;
 
   /**
    * Upper bound of the free space.  This is the offset of the last unused byte
@@ -40,12 +44,22 @@ struct PageHeader {
    * are unused but are in the middle of the slot array (due to record
    * deletions).
    */
-  SlotId num_slots;
+  SlotId num_slots : 15;
 
   /**
-   * Number of slots allocated but not in use.
+   * Whether the slot array holds 4-byte CompactPageSlots rather than 6-byte
+   * PageSlots.  Pages written before the compact format existed have it
+   * clear, since they never have 2^15 slots; they switch formats the next
+   * time their data is compacted.
    */
-  SlotId num_free_slots;
+  SlotId compact_slots : 1;
+
+  /**
+   * First slot in the chain of slots allocated but not in use, or
+   * Page::INVALID_SLOT if every slot is in use.  (Files written by format
+   * versions 1 and 2 kept the number of free slots here instead.)
+   */
+  SlotId first_free_slot;
 
   /**
    * Number of the page within the file.
@@ -53,7 +67,9 @@ struct PageHeader {
   PageId current_page_number;
 
   /**
-   * Number of the next used page in the file.
+   * Number of the next used page in the file.  Only meaningful in memory:
+   * the used list is kept in the file's allocation bitmap, so on disk this
+   * field holds the page's checksum instead (see File::setChecksums()).
    */
   PageId next_page_number;
 
@@ -65,7 +81,8 @@ struct PageHeader {
    */
   bool operator==(const PageHeader& rhs) const {
     return num_slots == rhs.num_slots &&
-        num_free_slots == rhs.num_free_slots &&
+        compact_slots == rhs.compact_slots &&
+        first_free_slot == rhs.first_free_slot &&
         current_page_number == rhs.current_page_number &&
         next_page_number == rhs.next_page_number;
   }
@@ -73,6 +90,9 @@ struct PageHeader {
 
 /**
  * @brief Slot metadata that tracks where a record is in the data space.
+ *
+ * This is also the slot layout of pages written before CompactPageSlot was
+ * introduced.
  */
 struct PageSlot {
   /**
@@ -82,17 +102,73 @@ struct PageSlot {
   bool used;
 
   /**
-   * Offset of the data item in the page.
+   * Offset of the data item in the page.  In an unused slot, the number of
+   * the next slot in the page's free slot chain instead.
    */
   std::uint16_t item_offset;
 
   /**
-   * Length of the data item in this slot.
+   * Length of the data item in this slot.  In an unused slot, the number of
+   * the previous slot in the page's free slot chain instead.
+   */
+  std::uint16_t item_length;
+};
+
+/**
+ * @brief Four-byte encoding of a PageSlot, used by pages with
+ * PageHeader::compact_slots set.
+ *
+ * Offsets and lengths within a page fit in 13 bits, so the used flag rides
+ * in the top bit of the offset.  For a small record the slot is a big part
+ * of its cost; 4 bytes instead of 6 fits about 5% more 30-byte records on a
+ * page.
+ */
+struct CompactPageSlot {
+  /**
+   * Bit of <offset_and_used> set when the slot holds data.
+   */
+  static const std::uint16_t USED = 0x8000;
+
+  /**
+   * PageSlot::item_offset, ORed with USED if the slot is in use.
+   */
+  std::uint16_t offset_and_used;
+
+  /**
+   * PageSlot::item_length.
    */
   std::uint16_t item_length;
 };
 
+/**
+ * @brief Read-only view of a record's bytes in place on its page.
+ *
+ * A view points into the page it was taken from, so it is only valid while
+ * that page stays in memory (for a buffer pool page, while it is pinned) and
+ * until the page is next modified.
+ */
+struct RecordView {
+  /**
+   * First byte of the record.
+   */
+  const char* data;
+
+  /**
+   * Length of the record in bytes.
+   */
+  std::size_t length;
+
+  /**
+   * Returns a copy of the record's bytes.
+   *
+   * @return  The record.
+   */
+  std::string str() const { return std::string(data, length); }
+};
+
 class PageIterator;
+class PageViewIterator;
+template <std::size_t RecordSize> class FixedPage;
 
 /**
  * @brief Class which represents a fixed-size database page containing records.
@@ -128,10 +204,23 @@ class Page {
   static const SlotId INVALID_SLOT = 0;
 
   /**
-   * Constructs a new, uninitialized page.
+   * Tag selecting the constructor that leaves a page's memory untouched.
+   */
+  struct Uninitialized {};
+
+  /**
+   * Constructs a new, empty page with no header information or data.
    */
   Page();
 
+  /**
+   * Constructs a page without writing to its memory, so the page holds
+   * whatever bytes were there before.  Used for buffer pool frames, which are
+   * always filled by a read before use; constructing them this way leaves
+   * freshly mapped memory unfaulted.
+   */
+  explicit Page(Uninitialized) {}
+
   /**
    * Inserts a new record into the page.
    *
@@ -140,6 +229,39 @@ class Page {
    */
   RecordId insertRecord(const std::string& record_data);
 
+  /**
+   * Inserts a new record into the page, taking its bytes straight from the
+   * caller's buffer.
+   *
+   * @param data    First byte of the record.
+   * @param length  Length of the record in bytes.
+   * @return  ID of the newly inserted record.
+   */
+  RecordId insertRecord(const char* data, const std::size_t length);
+
+  /**
+   * Inserts a new record into the page.
+   *
+   * @param record  Bytes that compose the record.
+   * @return  ID of the newly inserted record.
+   */
+  RecordId insertRecord(const RecordView& record) {
+    return insertRecord(record.data, record.length);
+  }
+
+  /**
+   * Inserts records into the page in order until one does not fit.  Use for
+   * bulk loading: the records not inserted go on the next page.
+   *
+   * @param records     Records to insert.
+   * @param count       Number of records in <records>.
+   * @param record_ids  Receives the IDs of the inserted records; must have
+   *                    room for <count> IDs.
+   * @return  Number of records inserted, from the start of <records>.
+   */
+  std::size_t insertRecords(const RecordView* records, const std::size_t count,
+                            RecordId* record_ids);
+
   /**
    * Returns the record with the given ID.  Returned data is a copy of what is
    * stored on the page; use updateRecord to change it.
@@ -150,10 +272,21 @@ class Page {
    */
   std::string getRecord(const RecordId& record_id) const;
 
+  /**
+   * Returns a view of the record with the given ID without copying it.  The
+   * view stays valid until the page is modified or leaves memory.
+   *
+   * @see getRecord
+   * @param record_id  ID of the record to return.
+   * @return  View of the record's bytes on this page.
+   */
+  RecordView getRecordView(const RecordId& record_id) const;
+
   /**
    * Updates the record with the given ID, replacing its data with a new
    * version.  This is equivalent to deleting the old record and inserting a
-   * new one, with the exception that the record ID will not change.
+   * new one, with the exception that the record ID will not change.  A new
+   * version no longer than the old one overwrites it in place.
    *
    * @param record_id   ID of record to update.
    * @param record_data Updated bytes that compose the record.
@@ -161,9 +294,30 @@ class Page {
   void updateRecord(const RecordId& record_id, const std::string& record_data);
 
   /**
-   * Deletes the record with the given ID.  Page is compacted upon delete to
-   * ensure that data of all records is contiguous.  Slot array is compacted if
-   * the slot deleted is at the end of the slot array.
+   * Updates the record with the given ID, taking the new bytes straight from
+   * the caller's buffer.
+   *
+   * @param record_id   ID of record to update.
+   * @param data        First byte of the updated record.
+   * @param length      Length of the updated record in bytes.
+   */
+  void updateRecord(const RecordId& record_id, const char* data,
+                    const std::size_t length);
+
+  /**
+   * Updates the record with the given ID.
+   *
+   * @param record_id   ID of record to update.
+   * @param record      Updated bytes that compose the record.
+   */
+  void updateRecord(const RecordId& record_id, const RecordView& record) {
+    updateRecord(record_id, record.data, record.length);
+  }
+
+  /**
+   * Deletes the record with the given ID.  The record's space is only marked
+   * free; it is reclaimed when a later insert or update needs it.  Slot array
+   * is compacted if the slot deleted is at the end of the slot array.
    *
    * @param record_id   ID of the record to delete.
    */
@@ -175,15 +329,49 @@ class Page {
    * @param record_data Bytes that compose the record.
    * @return  Whether the page can hold the data.
    */
-  bool hasSpaceForRecord(const std::string& record_data) const;
+  bool hasSpaceForRecord(const std::string& record_data) const {
+    return hasSpaceForRecord(record_data.length());
+  }
+
+  /**
+   * Returns true if the page has enough free space to hold a record of the
+   * given length.
+   *
+   * @param length  Length of the record in bytes.
+   * @return  Whether the page can hold the record.
+   */
+  bool hasSpaceForRecord(const std::size_t length) const;
+
+  /**
+   * Returns true if the page has enough free space to hold the given data.
+   *
+   * @param record  Bytes that compose the record.
+   * @return  Whether the page can hold the data.
+   */
+  bool hasSpaceForRecord(const RecordView& record) const {
+    return hasSpaceForRecord(record.length);
+  }
 
   /**
-   * Returns this page's free space in bytes.
+   * Returns this page's free space in bytes, including space freed by deletes
+   * that has not been compacted yet.
    *
    * @return  Free space in bytes.
    */
-  std::uint16_t getFreeSpace() const { return header_.free_space_upper_bound -
-                                              header_.free_space_lower_bound; }
+  std::uint16_t getFreeSpace() const {
+    return getContiguousFreeSpace() + header_.fragmented_space;
+  }
+
+  /**
+   * Returns the bytes of page space each record's slot takes: 4 on pages in
+   * the compact slot format (see CompactPageSlot), 6 on older pages.  A
+   * record needs a new slot unless an unused one is left by a delete.
+   *
+   * @return  Slot size in bytes.
+   */
+  std::size_t getSlotSize() const {
+    return header_.compact_slots ? sizeof(CompactPageSlot) : sizeof(PageSlot);
+  }
 
   /**
    * Returns this page's number in its file.
@@ -214,6 +402,22 @@ class Page {
    */
   PageIterator end();
 
+  /**
+   * Returns an iterator yielding views of the records in the page, starting
+   * at the first record.
+   *
+   * @return  View iterator at first record of page.
+   */
+  PageViewIterator beginViews() const;
+
+  /**
+   * Returns a view iterator representing the record after the last record in
+   * the page.  This iterator should not be dereferenced.
+   *
+   * @return  View iterator representing record after the last record.
+   */
+  PageViewIterator endViews() const;
+
  private:
   /**
    * Initializes this page as a new page with no header information or data.
@@ -239,10 +443,10 @@ class Page {
   }
 
   /**
-   * Deletes the record with the given ID.  Page is compacted upon delete to
-   * ensure that data of all records is contiguous.  Slot array is compacted if
-   * the slot deleted is at the end of the slot array and
-   * <allow_slot_compaction> is set.
+   * Deletes the record with the given ID, leaving its space as a hole (or
+   * moving the free space upper bound, if the record is the lowest on the
+   * page).  Slot array is compacted if the slot deleted is at the end of the
+   * slot array and <allow_slot_compaction> is set.
    *
    * @param record_id             ID of the record to delete.
    * @param allow_slot_compaction If true, the slot array will be compacted if
@@ -252,33 +456,83 @@ class Page {
                     const bool allow_slot_compaction);
 
   /**
-   * Returns the slot with the given number.  This method will return
-   * unallocated slots if requested; it is up to the caller to ensure they
-   * have a valid slot number.
+   * Returns the offset of the first unused byte after the slot array.
+   */
+  std::uint16_t getFreeSpaceLowerBound() const {
+    return header_.num_slots * getSlotSize();
+  }
+
+  /**
+   * Returns the free space between the slot array and the records, which is
+   * all an insert can use without compacting the page.
+   */
+  std::uint16_t getContiguousFreeSpace() const {
+    return header_.free_space_upper_bound - getFreeSpaceLowerBound();
+  }
+
+  /**
+   * Makes sure there are at least <length> bytes of contiguous free space,
+   * compacting the page if the holes left by deletes are needed.  Callers
+   * must have checked that the page has that much free space in total.
    *
-   * @param slot_number   Number of slot to retrieve.
-   * @return  Pointer to the slot.
+   * @param length  Number of bytes needed.
+   */
+  void reserveContiguousSpace(const std::size_t length) {
+    if (getContiguousFreeSpace() < length) {
+      compactData();
+    }
+  }
+
+  /**
+   * Moves every record up against the end of the page, merging the holes
+   * left by deletes into the free space.  Records keep their slots.
    */
-  PageSlot* getSlot(const SlotId slot_number);
+  void compactData();
 
   /**
-   * Returns the slot with the given number.  This method will return
-   * unallocated slots if requested; it is up to the caller to ensure they
-   * have a valid slot number.
-   * 
+   * Returns the slot with the given number, decoded from whichever format
+   * the page uses.  This method will return unallocated slots if requested;
+   * it is up to the caller to ensure they have a valid slot number.
+   *
    * @param slot_number   Number of slot to retrieve.
    * @return  The slot.
    */
-  const PageSlot& getSlot(const SlotId slot_number) const;
+  PageSlot getSlot(const SlotId slot_number) const {
+    if (header_.compact_slots) {
+      const CompactPageSlot& compact = *reinterpret_cast<const CompactPageSlot*>(
+          &data_[(slot_number - 1) * sizeof(CompactPageSlot)]);
+      const PageSlot slot = {
+          (compact.offset_and_used & CompactPageSlot::USED) != 0,
+          static_cast<std::uint16_t>(compact.offset_and_used &
+                                     ~CompactPageSlot::USED),
+          compact.item_length};
+      return slot;
+    }
+    return *reinterpret_cast<const PageSlot*>(
+        &data_[(slot_number - 1) * sizeof(PageSlot)]);
+  }
 
   /**
-   * Returns the slot number of an available slot.  If no slots are available
-   * to be reused, allocates a new slot.  Updates available slot count in the
-   * header metadata, but does not mark returned slot as used.  If a new slot is
-   * allocated, updates the free space lower bound.
+   * Stores the slot with the given number in the page's slot format.
    *
-   * Callers are responsible for making sure there is enough space to allocate a
-   * new slot before calling this method.
+   * @param slot_number   Number of slot to store.
+   * @param slot          New contents of the slot.
+   */
+  void setSlot(const SlotId slot_number, const PageSlot& slot);
+
+  /**
+   * Switches a page in the 6-byte slot format to the compact one, rewriting
+   * the slot array in place.  The free space grows by 2 bytes per slot.
+   */
+  void useCompactSlots();
+
+  /**
+   * Returns the slot number of an available slot: the head of the free slot
+   * chain, or else a newly allocated slot added to the chain.  Does not mark
+   * the returned slot as used.
+   *
+   * Callers are responsible for making sure there is enough contiguous space
+   * to allocate a new slot before calling this method.
    *
    * Since the returned slot is not marked as used, callers must take care to
    * fill the slot or mark it used before someone else calls this method.
@@ -287,21 +541,66 @@ class Page {
    */
   SlotId getAvailableSlot();
 
+  /**
+   * Returns the next used slot after the given slot, or INVALID_SLOT if no
+   * slot after it is used.
+   *
+   * @param start   Slot to start search after.
+   * @return  Next used slot after <start> or INVALID_SLOT.
+   */
+  SlotId getNextUsedSlot(const SlotId start) const {
+    if (header_.first_free_slot == INVALID_SLOT) {
+      // Every slot is in use.
+      return start < header_.num_slots ? start + 1 : INVALID_SLOT;
+    }
+    return findNextUsedSlot(start);
+  }
+
+  /**
+   * Does the work of getNextUsedSlot() for pages with unused slots.
+   *
+   * @param start   Slot to start search after.
+   * @return  Next used slot after <start> or INVALID_SLOT.
+   */
+  SlotId findNextUsedSlot(const SlotId start) const;
+
+  /**
+   * Marks the given slot unused and puts it at the head of the free slot
+   * chain.
+   *
+   * @param slot_number   Number of slot to free.
+   */
+  void linkFreeSlot(const SlotId slot_number);
+
+  /**
+   * Takes the given unused slot out of the free slot chain.
+   *
+   * @param slot_number   Number of slot to take out of the chain.
+   */
+  void unlinkFreeSlot(const SlotId slot_number);
+
+  /**
+   * Rebuilds the free slot chain from the slots' used flags.  Used to bring
+   * pages written by older format versions up to date.
+   */
+  void rebuildFreeSlotChain();
+
   /**
    * Inserts record data into the given slot.  The slot should not be currently
    * in use.  <slot_number> must be less than <header_.num_slots>.
    *
-   * Callers are responsible for making sure there is enough space to hold the
-   * record before calling this method.
+   * Callers are responsible for making sure there is enough contiguous space
+   * to hold the record before calling this method.
    *
    * @param slot_number   Number of slot to insert record into.
-   * @param record_data   Bytes that compose the record.
+   * @param data          First byte of the record.
+   * @param length        Length of the record in bytes.
    * @throws  InvalidSlotException  Thrown when given slot number refers to an
    *                                unallocated slot.
    * @throws  SlotInUseException  Thrown when given slot is in use.
    */
-  void insertRecordInSlot(const SlotId slot_number,
-                          const std::string& record_data);
+  void insertRecordInSlot(const SlotId slot_number, const char* data,
+                          const std::size_t length);
 
   /**
    * Throws an exception if the given record ID is not valid for this page
@@ -327,13 +626,17 @@ class Page {
 
   /**
    * Data stored on the page.  Includes bookkeeping information about slots as
-   * well as actual content.
+   * well as actual content.  Stored inline so that a page is one flat
+   * SIZE-byte object that can live in any suitably aligned memory.
    */
-
-  std::string data_;
+  char data_[DATA_SIZE];
 
   friend class File;
   friend class PageIterator;
+  friend class PageViewIterator;
+  template <std::size_t RecordSize> friend class FixedPage;
+  friend class PaxPage;
+  friend class RecordScanner;
   friend class PageTest;
   friend class BufferTest;
 };
@@ -342,5 +645,7 @@ static_assert(Page::SIZE > sizeof(PageHeader),
               "Page size must be large enough to hold header and data.");
 static_assert(Page::DATA_SIZE > 0,
               "Page must have some space to hold data.");
+static_assert(sizeof(Page) == Page::SIZE,
+              "In-memory page must have the same layout as a page on disk.");
 
 }
@@ -0,0 +1,76 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief A cache that holds pages evicted from the buffer pool.
+ *
+ * BufMgr offers every page it evicts to its tiers and asks them for every
+ * page it misses on before reading the page from its file.  Tiers are
+ * exclusive with the pool: a page handed back by fetch() is dropped from the
+ * tier, since the pool now holds it and any change to it will reach the tier
+ * again only through a later eviction.  Like the pool, a tier only sees
+ * pages moved through BufMgr; pages written with File directly must not be
+ * cached at the same time.
+ *
+ * Pages are identified by the FileId of the file they belong to.  A FileId
+ * is reused as soon as its file is closed, so a tier's copies of a file's
+ * pages live no longer than the file stays open: BufMgr calls
+ * invalidateFile() when a file closes, and after that the tier must never
+ * hand back a page stored under the old id.
+ */
+class PageCacheTier {
+ public:
+  virtual ~PageCacheTier() {}
+
+  /**
+   * Keeps a copy of a clean page evicted from the pool, replacing any copy
+   * already held.  The tier may decline to keep it.
+   *
+   * @param file_id       File the page belongs to.
+   * @param page_number   Number of the page.
+   * @param page          Contents of the page.
+   */
+  virtual void store(const FileId file_id, const PageId page_number,
+                     const Page& page) = 0;
+
+  /**
+   * Looks for a page and, if found, copies it into <page> and drops it from
+   * the tier.
+   *
+   * @param file_id       File the page belongs to.
+   * @param page_number   Number of the page.
+   * @param page          Set to the page's contents on a hit.
+   * @return  True on a hit.
+   */
+  virtual bool fetch(const FileId file_id, const PageId page_number,
+                     Page& page) = 0;
+
+  /**
+   * Drops any copy of a page, because it has been deleted or rewritten.
+   *
+   * @param file_id       File the page belongs to.
+   * @param page_number   Number of the page.
+   */
+  virtual void invalidate(const FileId file_id, const PageId page_number) = 0;
+
+  /**
+   * Drops every copy of a page of a file, because the file is being closed
+   * and its id will be given to another file.
+   *
+   * @param file_id       File being closed.
+   */
+  virtual void invalidateFile(const FileId file_id) = 0;
+};
+
+}
@@ -0,0 +1,231 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "page_codec.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Number of entries in the compressor's match-finding hash table.
+ */
+const int HASH_BITS = 12;
+
+/**
+ * Bytes at the end of the input that are always emitted as literals, so the
+ * compressor can read 4 bytes at any position it tries to match.
+ */
+const std::size_t LAST_LITERALS = 5;
+
+/**
+ * Largest distance a back-reference can span.
+ */
+const std::size_t MAX_DISTANCE = 65535;
+
+std::uint32_t read32(const char* p) {
+  std::uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+std::uint64_t read64(const char* p) {
+  std::uint64_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+std::uint32_t hashOf(const std::uint32_t value) {
+  return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/**
+ * Appends the continuation bytes of a length whose nibble was 15.  Returns
+ * false if they do not fit.
+ */
+bool putLength(std::size_t length, char*& out, const char* out_end) {
+  while (length >= 255) {
+    if (out >= out_end) {
+      return false;
+    }
+    *out++ = static_cast<char>(255);
+    length -= 255;
+  }
+  if (out >= out_end) {
+    return false;
+  }
+  *out++ = static_cast<char>(length);
+  return true;
+}
+
+/**
+ * Reads the continuation bytes of a length whose nibble was 15 and adds them
+ * to <length>.  Returns false on truncated input.
+ */
+bool getLength(const unsigned char*& in, const unsigned char* in_end,
+               std::size_t& length) {
+  unsigned char byte;
+  do {
+    if (in >= in_end) {
+      return false;
+    }
+    byte = *in++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/**
+ * Appends one block.  A <match_length> of 0 marks the final, literals-only
+ * block.  Returns false if the block does not fit.
+ */
+bool putBlock(const char* literals, const std::size_t literal_length,
+              const std::size_t distance, const std::size_t match_length,
+              char*& out, const char* out_end) {
+  if (out >= out_end) {
+    return false;
+  }
+  char* token = out++;
+  const std::size_t match_code =
+      match_length == 0 ? 0 : match_length - PageCodec::MIN_MATCH;
+  *token = static_cast<char>(
+      ((literal_length < 15 ? literal_length : 15) << 4) |
+      (match_code < 15 ? match_code : 15));
+  if (literal_length >= 15 && !putLength(literal_length - 15, out, out_end)) {
+    return false;
+  }
+  if (static_cast<std::size_t>(out_end - out) < literal_length) {
+    return false;
+  }
+  std::memcpy(out, literals, literal_length);
+  out += literal_length;
+  if (match_length == 0) {
+    return true;
+  }
+  if (out_end - out < 2) {
+    return false;
+  }
+  *out++ = static_cast<char>(distance & 0xff);
+  *out++ = static_cast<char>(distance >> 8);
+  return match_code < 15 || putLength(match_code - 15, out, out_end);
+}
+
+}
+
+std::size_t PageCodec::compress(const char* source, const std::size_t length,
+                                char* dest, const std::size_t capacity) {
+  std::int32_t table[1 << HASH_BITS];
+  std::memset(table, 0xff, sizeof(table));
+  char* out = dest;
+  const char* out_end = dest + capacity;
+
+  std::size_t anchor = 0;
+  std::size_t position = 0;
+  const std::size_t match_limit =
+      length > LAST_LITERALS ? length - LAST_LITERALS : 0;
+  while (position + MIN_MATCH <= match_limit) {
+    const std::uint32_t value = read32(source + position);
+    const std::uint32_t hash = hashOf(value);
+    const std::int32_t candidate = table[hash];
+    table[hash] = static_cast<std::int32_t>(position);
+    if (candidate < 0 || position - candidate > MAX_DISTANCE ||
+        read32(source + candidate) != value) {
+      ++position;
+      continue;
+    }
+    std::size_t match_length = MIN_MATCH;
+    // Extend a word at a time while whole words match.
+    while (position + match_length + 8 <= match_limit) {
+      const std::uint64_t diff = read64(source + candidate + match_length) ^
+                                 read64(source + position + match_length);
+      if (diff != 0) {
+        match_length += __builtin_ctzll(diff) / 8;
+        break;
+      }
+      match_length += 8;
+    }
+    while (position + match_length < match_limit &&
+           source[candidate + match_length] == source[position + match_length]) {
+      ++match_length;
+    }
+    if (!putBlock(source + anchor, position - anchor, position - candidate,
+                  match_length, out, out_end)) {
+      return 0;
+    }
+    position += match_length;
+    anchor = position;
+  }
+  if (!putBlock(source + anchor, length - anchor, 0, 0, out, out_end)) {
+    return 0;
+  }
+  return out - dest;
+}
+
+bool PageCodec::decompress(const char* source, const std::size_t length,
+                           char* dest, const std::size_t expected) {
+  const unsigned char* in = reinterpret_cast<const unsigned char*>(source);
+  const unsigned char* in_end = in + length;
+  std::size_t produced = 0;
+  while (in < in_end) {
+    const unsigned char token = *in++;
+    std::size_t literal_length = token >> 4;
+    if (literal_length == 15 && !getLength(in, in_end, literal_length)) {
+      return false;
+    }
+    if (static_cast<std::size_t>(in_end - in) < literal_length ||
+        expected - produced < literal_length) {
+      return false;
+    }
+    std::memcpy(dest + produced, in, literal_length);
+    in += literal_length;
+    produced += literal_length;
+    if (in == in_end) {
+      // Final block.
+      break;
+    }
+
+    if (in_end - in < 2) {
+      return false;
+    }
+    const std::size_t distance = in[0] | (std::size_t(in[1]) << 8);
+    in += 2;
+    std::size_t match_length = token & 0x0f;
+    if (match_length == 15 && !getLength(in, in_end, match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (distance == 0 || distance > produced ||
+        expected - produced < match_length) {
+      return false;
+    }
+    const char* from = dest + produced - distance;
+    char* to = dest + produced;
+    if (distance == 1) {
+      // A run of one repeated byte, typically zeroed free space.
+      std::memset(to, *from, match_length);
+    } else {
+      std::size_t i = 0;
+      if (distance >= 8) {
+        // Words at least <distance> apart never overlap.
+        for (; i + 8 <= match_length; i += 8) {
+          std::memcpy(to + i, from + i, 8);
+        }
+      }
+      // Byte by byte: the match may overlap the bytes it produces.
+      for (; i < match_length; ++i) {
+        to[i] = from[i];
+      }
+    }
+    produced += match_length;
+  }
+  return produced == expected;
+}
+
+}
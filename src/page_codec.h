@@ -0,0 +1,56 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace badgerdb {
+
+/**
+ * @brief A small, fast byte-oriented LZ77 codec for page images.
+ *
+ * The format is a sequence of blocks, each a token byte followed by
+ * literals and a back-reference.  The token's high nibble is the number of
+ * literals and its low nibble the match length minus MIN_MATCH; a nibble of
+ * 15 is continued by bytes of 255 and a final byte below 255.  The literals
+ * are followed by a 2-byte little-endian distance back into the output,
+ * except in the last block, which holds literals only.
+ *
+ * Pages compress well because their free space is zero-filled and records
+ * tend to repeat; a mostly empty page shrinks to a few dozen bytes.
+ * Compression uses a single hash probe per position, favouring speed over
+ * ratio.
+ */
+class PageCodec {
+ public:
+  /**
+   * Shortest back-reference the codec emits.
+   */
+  static const std::size_t MIN_MATCH = 4;
+
+  /**
+   * Compresses <length> bytes at <source> into at most <capacity> bytes at
+   * <dest>.
+   *
+   * @return  Compressed length, or 0 if the output would not fit in
+   *          <capacity> bytes.
+   */
+  static std::size_t compress(const char* source, const std::size_t length,
+                              char* dest, const std::size_t capacity);
+
+  /**
+   * Decompresses <length> bytes at <source>, which must decompress to
+   * exactly <expected> bytes, into <dest>.
+   *
+   * @return  False if the input is malformed or has the wrong length.
+   */
+  static bool decompress(const char* source, const std::size_t length,
+                         char* dest, const std::size_t expected);
+};
+
+}
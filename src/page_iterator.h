@@ -109,15 +109,7 @@ class PageIterator {
    * @return  Next used slot after given slot or Page::INVALID_SLOT.
    */
   SlotId getNextUsedSlot(const SlotId start) const {
-    SlotId slot_number = Page::INVALID_SLOT;
-    for (SlotId i = start + 1; i <= page_->header_.num_slots; ++i) {
-      const PageSlot* slot = page_->getSlot(i);
-      if (slot->used) {
-        slot_number = i;
-        break;
-      }
-    }
-    return slot_number;
+    return page_->getNextUsedSlot(start);
   }
 
  private:
@@ -133,4 +125,108 @@ class PageIterator {
 
 };
 
+/**
+ * @brief Iterator for scanning the records in a page without copying them.
+ *
+ * Like PageIterator, but dereferencing yields a RecordView into the page
+ * instead of a copy of the record, so a scan allocates nothing.  The views,
+ * and the iterator itself, are valid only while the page is unchanged.
+ */
+class PageViewIterator {
+ public:
+  /**
+   * Constructs an empty iterator.
+   */
+  PageViewIterator()
+      : page_(NULL),
+        slot_number_(Page::INVALID_SLOT) {
+  }
+
+  /**
+   * Constructs an iterator over the records in the given page, starting at
+   * the first record.  Page must not be null.
+   *
+   * @param page  Page to iterate over.
+   */
+  explicit PageViewIterator(const Page* page)
+      : page_(page) {
+    assert(page_ != NULL);
+    slot_number_ = page_->getNextUsedSlot(Page::INVALID_SLOT /* start */);
+  }
+
+  /**
+   * Constructs an iterator over the records in the given page, starting at
+   * the given slot.
+   *
+   * @param page          Page to iterate over.
+   * @param slot_number   Slot to start iterator at.
+   */
+  PageViewIterator(const Page* page, const SlotId slot_number)
+      : page_(page),
+        slot_number_(slot_number) {
+  }
+
+  /**
+   * Advances the iterator to the next record in the page.
+   */
+  PageViewIterator& operator++() {
+    assert(page_ != NULL);
+    slot_number_ = page_->getNextUsedSlot(slot_number_);
+    return *this;
+  }
+
+  PageViewIterator operator++(int) {
+    PageViewIterator tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  /**
+   * Returns true if this iterator is equal to the given iterator.
+   *
+   * @param rhs   Iterator to compare against.
+   * @return    True if other iterator is equal to this one.
+   */
+  bool operator==(const PageViewIterator& rhs) const {
+    return page_ == rhs.page_ && slot_number_ == rhs.slot_number_;
+  }
+
+  bool operator!=(const PageViewIterator& rhs) const {
+    return !(*this == rhs);
+  }
+
+  /**
+   * Dereferences the iterator, returning a view of the current record.
+   *
+   * @return  View of record in page.
+   */
+  RecordView operator*() const {
+    const PageSlot slot = page_->getSlot(slot_number_);
+    const RecordView view = {page_->data_ + slot.item_offset,
+                             slot.item_length};
+    return view;
+  }
+
+  /**
+   * Returns the ID of the current record.
+   *
+   * @return  ID of record in page.
+   */
+  RecordId record_id() const {
+    const RecordId record_id = {page_->page_number(), slot_number_};
+    return record_id;
+  }
+
+ private:
+  /**
+   * Page we're iterating over.
+   */
+  const Page* page_;
+
+  /**
+   * Slot of the record the iterator is currently pointing to.
+   */
+  SlotId slot_number_;
+};
+
 }
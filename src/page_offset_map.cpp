@@ -0,0 +1,86 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "page_offset_map.h"
+
+#include <algorithm>
+
+namespace badgerdb {
+
+const std::size_t PageOffsetMap::EXTENTS_PER_PAGE;
+const std::uint32_t PageOffsetMap::MAP_PAGES_PER_GROUP;
+const std::uint64_t PageOffsetMap::HALF_BYTES;
+
+PageOffsetMap::PageOffsetMap() {
+}
+
+void PageOffsetMap::resize(const PageId num_pages) {
+  const PageExtent empty = {0 /* offset */, 0 /* length */, 0 /* reserved */};
+  const std::size_t num_extents = num_pages <= 1 ? 0 : num_pages - 1;
+  for (std::size_t i = num_extents; i < extents_.size(); ++i) {
+    setExtent(i + 1, empty);
+  }
+  extents_.resize(num_extents, empty);
+  const std::size_t num_groups =
+      num_pages <= 1 ? 0 : AllocationMap::groupOf(num_pages - 1) + 1;
+  cursors_.resize(num_groups, 0);
+  live_bytes_.resize(num_groups, 0);
+}
+
+PageId PageOffsetMap::pagesInGroup(const std::uint32_t group) const {
+  const std::size_t first = std::size_t(group) * AllocationMap::PAGES_PER_GROUP;
+  return static_cast<PageId>(std::min<std::size_t>(
+      extents_.size() - first, AllocationMap::PAGES_PER_GROUP));
+}
+
+void PageOffsetMap::setExtent(const PageId page_number,
+                              const PageExtent& extent) {
+  PageExtent& current = extents_[page_number - 1];
+  const std::uint32_t group = AllocationMap::groupOf(page_number);
+  live_bytes_[group] += extent.length;
+  live_bytes_[group] -= current.length;
+  current = extent;
+}
+
+void PageOffsetMap::recount() {
+  for (std::uint32_t group = 0; group < numGroups(); ++group) {
+    const PageExtent* extents = groupExtents(group);
+    // Bytes used in each half, up to the end of its last live image.
+    std::uint64_t used[2] = {0, 0};
+    std::uint64_t live = 0;
+    for (PageId i = 0; i < pagesInGroup(group); ++i) {
+      if (extents[i].length == 0) {
+        continue;
+      }
+      const std::uint64_t start = halfStart(extents[i].offset);
+      const int half = start == 0 ? 0 : 1;
+      used[half] = std::max(used[half],
+                            extents[i].offset + extents[i].length - start);
+      live += extents[i].length;
+    }
+    live_bytes_[group] = live;
+    if (used[1] == 0 || (used[0] != 0 && used[0] <= used[1])) {
+      cursors_[group] = used[0];
+    } else {
+      cursors_[group] = HALF_BYTES + used[1];
+    }
+  }
+}
+
+bool PageOffsetMap::hasStrays(const std::uint32_t group) const {
+  const std::uint64_t start = halfStart(cursors_[group]);
+  const PageExtent* extents =
+      &extents_[std::size_t(group) * AllocationMap::PAGES_PER_GROUP];
+  for (PageId i = 0; i < pagesInGroup(group); ++i) {
+    if (extents[i].length != 0 && halfStart(extents[i].offset) != start) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}
@@ -0,0 +1,215 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "allocation_map.h"
+#include "page.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Where a page of a compressed file is stored.
+ *
+ * Stored as is in the file's offset map, eight bytes per page.
+ */
+struct PageExtent {
+  /**
+   * Offset of the page's image within its group's data area.
+   */
+  std::uint32_t offset;
+
+  /**
+   * Length of the image in bytes: 0 if the page has no image (it was never
+   * written or has been deleted), Page::SIZE if it is stored uncompressed.
+   */
+  std::uint16_t length;
+
+  /**
+   * Unused; always 0.
+   */
+  std::uint16_t reserved;
+};
+
+/**
+ * @brief In-memory copy of a compressed file's page-offset map.
+ *
+ * In a compressed file each group of AllocationMap::PAGES_PER_GROUP pages
+ * owns a data area made of two halves of HALF_BYTES each.  Page images are
+ * compressed and appended, one after another, at the group's write cursor in
+ * the current half; a page is never overwritten in place, so the map entry
+ * is the only thing that changes when a page is rewritten.  Images left
+ * behind by rewrites and deletes are garbage, and once the current half
+ * fills up the live images are copied to the start of the other half (see
+ * File).  A half holds twice the bytes of a group of uncompressed pages, so
+ * after such a copy at least half of the new half is free.
+ *
+ * The map keeps the extent of every page, the write cursor of every group,
+ * and the number of bytes of live images in every group.
+ *
+ * @warning This class is not threadsafe.
+ */
+class PageOffsetMap {
+ public:
+  /**
+   * Number of extents stored in one page of the on-disk map.
+   */
+  static const std::size_t EXTENTS_PER_PAGE = Page::SIZE / sizeof(PageExtent);
+
+  /**
+   * Number of pages holding one group's extents on disk.
+   */
+  static const std::uint32_t MAP_PAGES_PER_GROUP =
+      AllocationMap::PAGES_PER_GROUP / EXTENTS_PER_PAGE;
+
+  /**
+   * Size of each half of a group's data area.
+   */
+  static const std::uint64_t HALF_BYTES =
+      2 * std::uint64_t(AllocationMap::PAGES_PER_GROUP) * Page::SIZE;
+
+  /**
+   * Returns the start of the half of a data area holding <offset>.
+   */
+  static std::uint64_t halfStart(const std::uint64_t offset) {
+    return offset < HALF_BYTES ? 0 : HALF_BYTES;
+  }
+
+  /**
+   * Constructs an empty map describing a file with no pages.
+   */
+  PageOffsetMap();
+
+  /**
+   * Resizes the map to describe page numbers below <num_pages>.  Newly
+   * described pages have no image; pages that fall off lose theirs.
+   *
+   * @param num_pages   Number of pages in the file, counting the header.
+   */
+  void resize(const PageId num_pages);
+
+  /**
+   * Returns the number of groups described by the map.
+   */
+  std::uint32_t numGroups() const {
+    return static_cast<std::uint32_t>(cursors_.size());
+  }
+
+  /**
+   * Returns the number of pages of the given group the map describes.
+   *
+   * @param group   Group number.
+   */
+  PageId pagesInGroup(const std::uint32_t group) const;
+
+  /**
+   * Returns the extent of the given page.
+   *
+   * @param page_number   Number of page.
+   */
+  const PageExtent& extent(const PageId page_number) const {
+    return extents_[page_number - 1];
+  }
+
+  /**
+   * Sets the extent of the given page.
+   *
+   * @param page_number   Number of page.
+   * @param extent        New extent.
+   */
+  void setExtent(const PageId page_number, const PageExtent& extent);
+
+  /**
+   * Returns the first extent of the given group; the group's extents follow
+   * it in page number order, as they are stored on disk.
+   *
+   * @param group   Group number.
+   */
+  PageExtent* groupExtents(const std::uint32_t group) {
+    return &extents_[std::size_t(group) * AllocationMap::PAGES_PER_GROUP];
+  }
+
+  /**
+   * Returns the offset in the group's data area where the next image goes.
+   *
+   * @param group   Group number.
+   */
+  std::uint64_t cursor(const std::uint32_t group) const {
+    return cursors_[group];
+  }
+
+  /**
+   * Moves the group's write cursor.
+   *
+   * @param group   Group number.
+   * @param cursor  New offset in the group's data area.
+   */
+  void setCursor(const std::uint32_t group, const std::uint64_t cursor) {
+    cursors_[group] = cursor;
+  }
+
+  /**
+   * Returns the number of bytes of live images in the group.
+   *
+   * @param group   Group number.
+   */
+  std::uint64_t liveBytes(const std::uint32_t group) const {
+    return live_bytes_[group];
+  }
+
+  /**
+   * Returns the number of bytes taken by images in the group's current half,
+   * live or not.
+   *
+   * @param group   Group number.
+   */
+  std::uint64_t usedBytes(const std::uint32_t group) const {
+    return cursors_[group] - halfStart(cursors_[group]);
+  }
+
+  /**
+   * Recomputes the live byte counts and write cursors from the extents.  Must
+   * be called after filling groups through groupExtents().
+   *
+   * A group normally has all of its images in one half, and its cursor is
+   * placed after the last of them.  If a copy to the other half was cut
+   * short, images are found in both halves; the cursor is then placed in the
+   * half where the images end earlier, which always has room for the images
+   * in the other half, and hasStrays() reports the group.
+   */
+  void recount();
+
+  /**
+   * Returns true if the group has live images outside the half holding its
+   * cursor.
+   *
+   * @param group   Group number.
+   */
+  bool hasStrays(const std::uint32_t group) const;
+
+ private:
+  /**
+   * Extent of every page; entry (n - 1) describes page n.
+   */
+  std::vector<PageExtent> extents_;
+
+  /**
+   * Write cursor of every group.
+   */
+  std::vector<std::uint64_t> cursors_;
+
+  /**
+   * Bytes of live images in every group.
+   */
+  std::vector<std::uint64_t> live_bytes_;
+};
+
+}
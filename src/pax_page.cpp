@@ -0,0 +1,252 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "pax_page.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "exceptions/insufficient_space_exception.h"
+#include "exceptions/invalid_record_exception.h"
+#include "exceptions/invalid_schema_exception.h"
+#include "exceptions/page_layout_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Rounds <bytes> up to a whole number of 8-byte words.
+ */
+std::size_t roundToWords(const std::size_t bytes) {
+  return (bytes + 7) / 8 * 8;
+}
+
+}
+
+PaxSchema::PaxSchema(const std::vector<std::uint16_t>& column_widths)
+    : widths_(column_widths),
+      record_size_(0) {
+  if (widths_.empty()) {
+    throw InvalidSchemaException("no columns");
+  }
+  for (std::size_t column = 0; column < widths_.size(); ++column) {
+    if (widths_[column] == 0) {
+      throw InvalidSchemaException("a column of width 0");
+    }
+    field_offsets_.push_back(record_size_);
+    record_size_ += widths_[column];
+  }
+
+  // The header, the column widths and a single record, with its bitmap
+  // word, must fit on a page, and the record size must fit the header.
+  const std::size_t fixed_bytes =
+      sizeof(FixedPageHeader) + roundToWords(widths_.size() * 2);
+  if (record_size_ > UINT16_MAX ||
+      fixed_bytes + record_size_ + 8 > Page::DATA_SIZE) {
+    throw InvalidSchemaException("records too large for a page");
+  }
+
+  // Start from the count that would fit without any rounding, and take
+  // records away until the rounded-up layout fits too.
+  std::size_t n = (Page::DATA_SIZE - fixed_bytes) * 8 / (record_size_ * 8 + 1);
+  while (n > 0 && pageBytes(n) > Page::DATA_SIZE) {
+    --n;
+  }
+  capacity_ = static_cast<SlotId>(n);
+  bitmap_offset_ = fixed_bytes;
+  bitmap_words_ = (n + 63) / 64;
+
+  std::size_t offset = bitmap_offset_ + bitmap_words_ * 8;
+  for (std::size_t column = 0; column < widths_.size(); ++column) {
+    minipage_offsets_.push_back(offset);
+    offset += roundToWords(n * widths_[column]);
+  }
+}
+
+std::size_t PaxSchema::pageBytes(const std::size_t n) const {
+  std::size_t bytes = sizeof(FixedPageHeader) +
+      roundToWords(widths_.size() * 2) + (n + 63) / 64 * 8;
+  for (std::size_t column = 0; column < widths_.size(); ++column) {
+    bytes += roundToWords(n * widths_[column]);
+  }
+  return bytes;
+}
+
+PaxPage::PaxPage(Page& page, const PaxSchema& schema)
+    : page_(page),
+      schema_(schema) {
+  const PageHeader& header = page_.header_;
+  if (header.num_slots == 0 &&
+      header.free_space_upper_bound == Page::DATA_SIZE) {
+    format();
+    return;
+  }
+  const FixedPageHeader& pax_header = pageHeader();
+  if (header.num_slots != 0 || header.free_space_upper_bound != 0 ||
+      pax_header.record_size != schema_.recordSize() ||
+      pax_header.num_columns != schema_.numColumns() ||
+      std::memcmp(page_.data_ + sizeof(FixedPageHeader), &schema_.widths_[0],
+                  schema_.numColumns() * 2) != 0) {
+    throw PageLayoutException(page_.page_number());
+  }
+}
+
+RecordId PaxPage::insertRecord(const char* record) {
+  FixedPageHeader& header = pageHeader();
+  if (header.num_records == schema_.capacity()) {
+    throw InsufficientSpaceException(page_.page_number(),
+                                     schema_.recordSize(), 0);
+  }
+  // Every word before first_open_word is full, and the bits past the last
+  // record are set at format time, so the search always stops at a record.
+  std::size_t word_index = header.first_open_word;
+  std::uint64_t word = loadWord(word_index);
+  while (word == ~std::uint64_t(0)) {
+    word = loadWord(++word_index);
+  }
+  header.first_open_word = static_cast<std::uint16_t>(word_index);
+  storeWord(word_index, word | (word + 1));
+  ++header.num_records;
+  const SlotId slot_number = static_cast<SlotId>(
+      word_index * 64 + __builtin_ctzll(~word) + 1);
+  for (std::size_t column = 0; column < schema_.numColumns(); ++column) {
+    std::memcpy(field(slot_number, column), record + schema_.fieldOffset(column),
+                schema_.columnWidth(column));
+  }
+  const RecordId record_id = {page_.page_number(), slot_number};
+  return record_id;
+}
+
+void PaxPage::getRecord(const RecordId& record_id, char* record) const {
+  validateRecordId(record_id);
+  for (std::size_t column = 0; column < schema_.numColumns(); ++column) {
+    std::memcpy(record + schema_.fieldOffset(column),
+                field(record_id.slot_number, column),
+                schema_.columnWidth(column));
+  }
+}
+
+const char* PaxPage::getField(const RecordId& record_id,
+                              const std::size_t column) const {
+  validateRecordId(record_id);
+  return field(record_id.slot_number, column);
+}
+
+void PaxPage::updateRecord(const RecordId& record_id, const char* record) {
+  validateRecordId(record_id);
+  for (std::size_t column = 0; column < schema_.numColumns(); ++column) {
+    std::memmove(field(record_id.slot_number, column),
+                 record + schema_.fieldOffset(column),
+                 schema_.columnWidth(column));
+  }
+}
+
+void PaxPage::updateField(const RecordId& record_id, const std::size_t column,
+                          const char* value) {
+  validateRecordId(record_id);
+  std::memmove(field(record_id.slot_number, column), value,
+               schema_.columnWidth(column));
+}
+
+void PaxPage::deleteRecord(const RecordId& record_id) {
+  validateRecordId(record_id);
+  const std::size_t index = record_id.slot_number - 1;
+  const std::size_t word_index = index / 64;
+  storeWord(word_index,
+            loadWord(word_index) & ~(std::uint64_t(1) << index % 64));
+  FixedPageHeader& header = pageHeader();
+  --header.num_records;
+  if (word_index < header.first_open_word) {
+    header.first_open_word = static_cast<std::uint16_t>(word_index);
+  }
+}
+
+ColumnView PaxPage::getColumn(const std::size_t column) const {
+  std::size_t num_words = schema_.bitmap_words_;
+  while (num_words > 0 && getOccupancy(num_words - 1) == 0) {
+    --num_words;
+  }
+  const std::size_t num_slots = num_words * 64;
+  const ColumnView view = {
+      field(1, column), schema_.columnWidth(column),
+      static_cast<SlotId>(num_slots < schema_.capacity() ? num_slots
+                                                         : schema_.capacity())};
+  return view;
+}
+
+std::uint64_t PaxPage::getOccupancy(const std::size_t word_index) const {
+  const SlotId capacity = schema_.capacity();
+  if (capacity % 64 != 0 && word_index == schema_.bitmap_words_ - 1) {
+    return loadWord(word_index) & ~(~std::uint64_t(0) << capacity % 64);
+  }
+  return loadWord(word_index);
+}
+
+PaxPage::ColumnIterator PaxPage::beginColumn(const std::size_t column) const {
+  return ColumnIterator(this, column);
+}
+
+PaxPage::ColumnIterator PaxPage::endColumn() const {
+  return ColumnIterator();
+}
+
+PaxPage::ColumnIterator::ColumnIterator(const PaxPage* page,
+                                        const std::size_t column)
+    : page_(page),
+      fields_(page->field(1, column)),
+      width_(page->schema_.columnWidth(column)),
+      word_index_(0),
+      word_(page->schema_.bitmap_words_ > 0 ? page->getOccupancy(0) : 0),
+      slot_number_(Page::INVALID_SLOT) {
+  if (page->schema_.bitmap_words_ == 0) {
+    page_ = NULL;
+    return;
+  }
+  ++*this;
+}
+
+void PaxPage::format() {
+  FixedPageHeader& header = pageHeader();
+  header.record_size = static_cast<std::uint16_t>(schema_.recordSize());
+  header.num_records = 0;
+  header.first_open_word = 0;
+  header.num_columns = static_cast<std::uint16_t>(schema_.numColumns());
+  std::memcpy(page_.data_ + sizeof(FixedPageHeader), &schema_.widths_[0],
+              schema_.numColumns() * 2);
+  for (std::size_t i = 0; i < schema_.bitmap_words_; ++i) {
+    storeWord(i, 0);
+  }
+  const SlotId capacity = schema_.capacity();
+  if (capacity % 64 != 0) {
+    storeWord(schema_.bitmap_words_ - 1, ~std::uint64_t(0) << capacity % 64);
+  }
+  page_.header_.free_space_upper_bound = 0;
+  page_.header_.fragmented_space = 0;
+}
+
+void PaxPage::validateRecordId(const RecordId& record_id) const {
+  const std::size_t index = record_id.slot_number - 1;
+  if (record_id.page_number != page_.page_number() ||
+      record_id.slot_number == Page::INVALID_SLOT ||
+      index >= schema_.capacity() ||
+      (loadWord(index / 64) & std::uint64_t(1) << index % 64) == 0) {
+    throw InvalidRecordException(record_id, page_.page_number());
+  }
+}
+
+std::uint64_t PaxPage::loadWord(const std::size_t i) const {
+  std::uint64_t word;
+  std::memcpy(&word, page_.data_ + schema_.bitmap_offset_ + i * 8, 8);
+  return word;
+}
+
+void PaxPage::storeWord(const std::size_t i, const std::uint64_t word) {
+  std::memcpy(page_.data_ + schema_.bitmap_offset_ + i * 8, &word, 8);
+}
+
+}
@@ -0,0 +1,441 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "fixed_page.h"
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief The fixed-width columns of the records of a PaxPage, and where each
+ * column's minipage goes on the page.
+ *
+ * A record is the concatenation of its fields in column order, so a schema
+ * of {4, 4, 8} describes 16-byte records whose third field starts at byte 8.
+ * Building a schema works out the page layout once; every PaxPage over pages
+ * of the same columns can share it.
+ */
+class PaxSchema {
+ public:
+  /**
+   * Constructs the schema of records with columns of the given widths.
+   *
+   * @param column_widths   Width in bytes of each column, in record order.
+   *                        There must be at least one, none may be 0, and
+   *                        at least one record must fit on a page.
+   * @throws  InvalidSchemaException If there are no columns, one is 0 wide,
+   *                                 or not even one record fits on a page.
+   */
+  explicit PaxSchema(const std::vector<std::uint16_t>& column_widths);
+
+  /**
+   * Returns the number of columns.
+   */
+  std::size_t numColumns() const { return widths_.size(); }
+
+  /**
+   * Returns the width in bytes of the given column.
+   *
+   * @param column  Column number, from 0.
+   */
+  std::size_t columnWidth(const std::size_t column) const {
+    return widths_[column];
+  }
+
+  /**
+   * Returns the offset of the given column's field within a record.
+   *
+   * @param column  Column number, from 0.
+   */
+  std::size_t fieldOffset(const std::size_t column) const {
+    return field_offsets_[column];
+  }
+
+  /**
+   * Returns the length of a record in bytes: the sum of the column widths.
+   */
+  std::size_t recordSize() const { return record_size_; }
+
+  /**
+   * Returns the number of records that fit on a page.
+   */
+  SlotId capacity() const { return capacity_; }
+
+ private:
+  friend class PaxPage;
+
+  /**
+   * Returns the bytes of data area taken by a page of <n> records: the
+   * bookkeeping, the column widths, the occupancy bitmap and one minipage
+   * per column, each rounded up to whole 8-byte words.
+   */
+  std::size_t pageBytes(const std::size_t n) const;
+
+  /**
+   * Width of each column.
+   */
+  std::vector<std::uint16_t> widths_;
+
+  /**
+   * Offset of each column's field within a record.
+   */
+  std::vector<std::size_t> field_offsets_;
+
+  /**
+   * Offset of each column's minipage within the page's data area.
+   */
+  std::vector<std::size_t> minipage_offsets_;
+
+  /**
+   * Length of a record.
+   */
+  std::size_t record_size_;
+
+  /**
+   * Offset of the occupancy bitmap within the page's data area.
+   */
+  std::size_t bitmap_offset_;
+
+  /**
+   * Number of 64-bit words in the occupancy bitmap.
+   */
+  std::size_t bitmap_words_;
+
+  /**
+   * Number of records that fit on a page.
+   */
+  SlotId capacity_;
+};
+
+/**
+ * @brief One column of a PaxPage, as a dense array of fields.
+ *
+ * The field of slot n is at data + (n - 1) * width.  Fields of unused slots
+ * hold stale bytes, so a scan over the array must be masked with the page's
+ * occupancy (see PaxPage::getOccupancy()).  Valid until the page is modified
+ * or leaves memory.
+ */
+struct ColumnView {
+  /**
+   * Field of slot 1.
+   */
+  const char* data;
+
+  /**
+   * Width of each field in bytes.
+   */
+  std::size_t width;
+
+  /**
+   * Number of fields in the array: one past the last used slot, rounded up
+   * to a multiple of 64 (or the page's capacity, if smaller).  Slots after
+   * it are all unused.
+   */
+  SlotId num_slots;
+};
+
+/**
+ * @brief View of a page as fixed-length records stored column by column
+ * (the PAX layout).
+ *
+ * A PaxPage holds the same records as a FixedPage of the schema's record
+ * size, and assigns slots the same way, but splits the page into one
+ * minipage per column: the fields of one column for every slot sit next to
+ * each other.  Reading or writing a whole record costs a copy per column,
+ * but a scan that filters on one column reads only that column's bytes,
+ * several times fewer cache lines than a row layout, as a dense array a
+ * compiler can vectorize.  Use getColumn() and getOccupancy() to scan a
+ * column as an array, or beginColumn() to visit the fields of used slots.
+ *
+ * Pages of a file created columnar (see File::create()) hold this layout and
+ * must only be accessed through a PaxPage of the file's schema.  As with
+ * FixedPage, the view wraps a Page from File or the buffer manager, formats
+ * a newly allocated page, and leaves the Page header looking like a full
+ * page with no slots.  Each page records its column widths, so a page is
+ * checked against the schema it is viewed with.
+ *
+ * @warning This class is not threadsafe.
+ */
+class PaxPage {
+ public:
+  /**
+   * Wraps <page>, formatting it if it is newly allocated.  The schema must
+   * outlive the view.
+   *
+   * @param page    Page holding records of <schema>, or an empty page.
+   * @param schema  Columns of the page's records.
+   * @throws  PageLayoutException   If the page holds other records.
+   */
+  PaxPage(Page& page, const PaxSchema& schema);
+
+  /**
+   * Inserts a new record into the page.
+   *
+   * @param record  First byte of the record, which has the schema's record
+   *                size and its fields in column order.
+   * @return  ID of the newly inserted record.
+   * @throws  InsufficientSpaceException  If the page is full.
+   */
+  RecordId insertRecord(const char* record);
+
+  /**
+   * Copies the record with the given ID, field by field, into <record>.
+   *
+   * @param record_id   ID of the record to read.
+   * @param record      Receives the record; must have room for the
+   *                    schema's record size.
+   * @throws  InvalidRecordException  If the ID names no record on this page.
+   */
+  void getRecord(const RecordId& record_id, char* record) const;
+
+  /**
+   * Returns one field of the record with the given ID, in place on the page.
+   *
+   * @param record_id   ID of the record.
+   * @param column      Column of the field, from 0.
+   * @return  First byte of the field.
+   * @throws  InvalidRecordException  If the ID names no record on this page.
+   */
+  const char* getField(const RecordId& record_id,
+                       const std::size_t column) const;
+
+  /**
+   * Overwrites the record with the given ID.
+   *
+   * @param record_id   ID of record to update.
+   * @param record      First byte of the new version.
+   * @throws  InvalidRecordException  If the ID names no record on this page.
+   */
+  void updateRecord(const RecordId& record_id, const char* record);
+
+  /**
+   * Overwrites one field of the record with the given ID.
+   *
+   * @param record_id   ID of record to update.
+   * @param column      Column of the field, from 0.
+   * @param value       First byte of the new value.
+   * @throws  InvalidRecordException  If the ID names no record on this page.
+   */
+  void updateField(const RecordId& record_id, const std::size_t column,
+                   const char* value);
+
+  /**
+   * Deletes the record with the given ID.  Its slot is reused by a later
+   * insert.
+   *
+   * @param record_id   ID of the record to delete.
+   * @throws  InvalidRecordException  If the ID names no record on this page.
+   */
+  void deleteRecord(const RecordId& record_id);
+
+  /**
+   * Returns true if the page has room for another record.
+   */
+  bool hasSpaceForRecord() const {
+    return pageHeader().num_records < schema_.capacity();
+  }
+
+  /**
+   * Returns the number of records on the page.
+   */
+  SlotId getNumRecords() const { return pageHeader().num_records; }
+
+  /**
+   * Returns the given column as a dense array of fields.
+   *
+   * @param column  Column number, from 0.
+   * @return  View of the column's minipage.
+   */
+  ColumnView getColumn(const std::size_t column) const;
+
+  /**
+   * Returns which of 64 slots are in use: bit i of word w is set if slot
+   * w * 64 + i + 1 holds a record.
+   *
+   * @param word_index  Index of the word, from 0.
+   * @return  Occupancy bits of slots word_index * 64 + 1 onwards.
+   */
+  std::uint64_t getOccupancy(const std::size_t word_index) const;
+
+  class ColumnIterator;
+
+  /**
+   * Returns an iterator over the fields of the given column, in slot order,
+   * skipping unused slots.
+   *
+   * @param column  Column number, from 0.
+   * @return  Column iterator at the first record of the page.
+   */
+  ColumnIterator beginColumn(const std::size_t column) const;
+
+  /**
+   * Returns a column iterator representing the record after the last record
+   * in the page.  This iterator should not be dereferenced.
+   *
+   * @return  Column iterator past the last record.
+   */
+  ColumnIterator endColumn() const;
+
+  /**
+   * @brief Iterator over one column of a PaxPage, yielding each used slot's
+   * field in place.
+   */
+  class ColumnIterator {
+   public:
+    /**
+     * Constructs an end iterator.
+     */
+    ColumnIterator()
+        : page_(NULL),
+          fields_(NULL),
+          width_(0),
+          word_index_(0),
+          word_(0),
+          slot_number_(Page::INVALID_SLOT) {
+    }
+
+    /**
+     * Constructs an iterator at the first record of <page>.
+     *
+     * @param page    Page to iterate over.
+     * @param column  Column to yield.
+     */
+    ColumnIterator(const PaxPage* page, const std::size_t column);
+
+    /**
+     * Advances the iterator to the next record in the page.
+     */
+    ColumnIterator& operator++() {
+      while (word_ == 0) {
+        if (++word_index_ == page_->schema_.bitmap_words_) {
+          page_ = NULL;
+          slot_number_ = Page::INVALID_SLOT;
+          return *this;
+        }
+        word_ = page_->getOccupancy(word_index_);
+      }
+      slot_number_ =
+          static_cast<SlotId>(word_index_ * 64 + __builtin_ctzll(word_) + 1);
+      word_ &= word_ - 1;
+      return *this;
+    }
+
+    bool operator==(const ColumnIterator& rhs) const {
+      return page_ == rhs.page_ && slot_number_ == rhs.slot_number_;
+    }
+
+    bool operator!=(const ColumnIterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+    /**
+     * Returns the field of the record the iterator is at.
+     *
+     * @return  First byte of the field.
+     */
+    const char* operator*() const {
+      return fields_ + (slot_number_ - 1) * width_;
+    }
+
+    /**
+     * Returns the ID of the record the iterator is at.
+     *
+     * @return  ID of current record.
+     */
+    RecordId record_id() const {
+      const RecordId record_id = {page_->page_.page_number(), slot_number_};
+      return record_id;
+    }
+
+   private:
+    /**
+     * Page being iterated over, or NULL at the end.
+     */
+    const PaxPage* page_;
+
+    /**
+     * Field of slot 1 in the column's minipage.
+     */
+    const char* fields_;
+
+    /**
+     * Width of each field.
+     */
+    std::size_t width_;
+
+    /**
+     * Index of the occupancy word holding the current record's bit.
+     */
+    std::size_t word_index_;
+
+    /**
+     * Bits of the records after the current one in that word.
+     */
+    std::uint64_t word_;
+
+    /**
+     * Slot of the current record.
+     */
+    SlotId slot_number_;
+  };
+
+ private:
+  /**
+   * Lays out an empty page: the column widths, an empty bitmap with the bits
+   * past the last record set, and a header that gives the Page interface no
+   * space.
+   */
+  void format();
+
+  /**
+   * Throws an exception if the given record ID does not name a record on
+   * this page.
+   *
+   * @param record_id   Record ID to validate.
+   * @throws  InvalidRecordException  If the ID has a bad page or slot number.
+   */
+  void validateRecordId(const RecordId& record_id) const;
+
+  FixedPageHeader& pageHeader() {
+    return *reinterpret_cast<FixedPageHeader*>(page_.data_);
+  }
+
+  const FixedPageHeader& pageHeader() const {
+    return *reinterpret_cast<const FixedPageHeader*>(page_.data_);
+  }
+
+  std::uint64_t loadWord(const std::size_t i) const;
+
+  void storeWord(const std::size_t i, const std::uint64_t word);
+
+  /**
+   * Returns the field of the given slot in the given column.
+   */
+  char* field(const SlotId slot_number, const std::size_t column) const {
+    return page_.data_ + schema_.minipage_offsets_[column] +
+        (slot_number - 1) * schema_.widths_[column];
+  }
+
+  /**
+   * Page being viewed.
+   */
+  Page& page_;
+
+  /**
+   * Columns of the page's records.
+   */
+  const PaxSchema& schema_;
+};
+
+}
@@ -0,0 +1,285 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+class BufMgr;
+class File;
+
+/**
+ * @brief A condition on a record's bytes that a RecordScanner evaluates in
+ * place on the page.
+ *
+ * Numbers are read in the machine's (little-endian) byte order.  A record
+ * too short to hold the bytes a predicate looks at does not match it.
+ */
+class RecordPredicate {
+ public:
+  /**
+   * Kinds of predicate.
+   */
+  enum Kind {
+    /**
+     * The record has the given bytes at the given offset.
+     */
+    PREDICATE_BYTES_AT,
+
+    /**
+     * The record contains the given bytes anywhere.
+     */
+    PREDICATE_CONTAINS,
+
+    /**
+     * The 32-bit signed integer at the given offset is within a range.
+     */
+    PREDICATE_INT32_RANGE,
+
+    /**
+     * The 64-bit signed integer at the given offset is within a range.
+     */
+    PREDICATE_INT64_RANGE
+  };
+
+  /**
+   * Returns a predicate matching records with <bytes> at <offset>.
+   *
+   * @param offset  Offset of the bytes in the record.
+   * @param bytes   Bytes to match; must not be empty.
+   * @throws  InvalidPredicateException  If <bytes> is empty, or the bytes
+   *                                     would end past Page::DATA_SIZE.
+   */
+  static RecordPredicate bytesAt(const std::size_t offset,
+                                 const std::string& bytes);
+
+  /**
+   * Returns a predicate matching records that start with <bytes>.
+   *
+   * @param bytes   Bytes to match; must not be empty.
+   * @throws  InvalidPredicateException  If <bytes> is empty or longer than
+   *                                     Page::DATA_SIZE.
+   */
+  static RecordPredicate prefix(const std::string& bytes) {
+    return bytesAt(0, bytes);
+  }
+
+  /**
+   * Returns a predicate matching records that contain <bytes>.
+   *
+   * @param bytes   Bytes to look for; must not be empty.
+   * @throws  InvalidPredicateException  If <bytes> is empty or longer than
+   *                                     Page::DATA_SIZE.
+   */
+  static RecordPredicate contains(const std::string& bytes);
+
+  /**
+   * Returns a predicate matching records whose 32-bit integer at <offset>
+   * is at least <low> and at most <high>.
+   *
+   * @param offset  Offset of the integer in the record.
+   * @param low     Smallest value to match.
+   * @param high    Largest value to match; must not be below <low>.
+   * @throws  InvalidPredicateException  If <low> is above <high>, or the
+   *                                     integer would end past
+   *                                     Page::DATA_SIZE.
+   */
+  static RecordPredicate int32Between(const std::size_t offset,
+                                      const std::int32_t low,
+                                      const std::int32_t high);
+
+  /**
+   * Returns a predicate matching records whose 64-bit integer at <offset>
+   * is at least <low> and at most <high>.
+   *
+   * @param offset  Offset of the integer in the record.
+   * @param low     Smallest value to match.
+   * @param high    Largest value to match; must not be below <low>.
+   * @throws  InvalidPredicateException  If <low> is above <high>, or the
+   *                                     integer would end past
+   *                                     Page::DATA_SIZE.
+   */
+  static RecordPredicate int64Between(const std::size_t offset,
+                                      const std::int64_t low,
+                                      const std::int64_t high);
+
+  /**
+   * Returns true if the record matches.  This is the portable definition
+   * the scanner's kernels must agree with.
+   *
+   * @param data    First byte of the record.
+   * @param length  Length of the record in bytes.
+   * @return  Whether the record matches.
+   */
+  bool matches(const char* data, const std::size_t length) const;
+
+  /**
+   * Returns the kind of predicate.
+   */
+  Kind kind() const { return kind_; }
+
+ private:
+  friend class RecordScanner;
+
+  RecordPredicate(const Kind kind, const std::size_t offset,
+                  const std::string& bytes, const std::int64_t low,
+                  const std::int64_t high);
+
+  /**
+   * Kind of predicate.
+   */
+  Kind kind_;
+
+  /**
+   * Offset of the bytes or integer looked at, for all kinds but
+   * PREDICATE_CONTAINS.
+   */
+  std::size_t offset_;
+
+  /**
+   * Bytes matched, for PREDICATE_BYTES_AT and PREDICATE_CONTAINS.
+   */
+  std::string bytes_;
+
+  /**
+   * Range matched, for the integer kinds.
+   */
+  std::int64_t low_;
+  std::int64_t high_;
+};
+
+/**
+ * @brief Instruction sets RecordScanner can evaluate predicates with.
+ */
+enum ScanKernel {
+  /**
+   * Portable code only.
+   */
+  SCAN_SCALAR,
+
+  /**
+   * 16-byte SSE2 compares for byte predicates.  Integer ranges use the
+   * scalar code.
+   */
+  SCAN_SSE2,
+
+  /**
+   * 32-byte AVX2 compares for byte predicates, and range compares of eight
+   * (or four) records' integers at once.
+   */
+  SCAN_AVX2
+};
+
+/**
+ * @brief Finds the records matching a RecordPredicate by testing their bytes
+ * where they lie on the page, without copying them.
+ *
+ * Scanning a page yields the IDs (or views) of its matching records, in slot
+ * order.  Scanning a file goes through the buffer manager: each used page is
+ * pinned while it is scanned, so a page already in the pool is not read
+ * again, and only the IDs of matches are returned.
+ *
+ * The byte predicates are evaluated with vector compares: a whole pattern of
+ * up to 16 or 32 bytes in one compare for PREDICATE_BYTES_AT, and for
+ * PREDICATE_CONTAINS a compare of the pattern's first and last bytes at 16 or
+ * 32 positions at once, with a full compare only where both agree.  Integer
+ * ranges are evaluated on eight records at a time.  Vector loads may read
+ * past the end of a record, but never past the end of its page.
+ *
+ * @warning A scanner is threadsafe, but the pages it scans must not change
+ *          while it runs.
+ */
+class RecordScanner {
+ public:
+  /**
+   * Constructs a scanner for <predicate> using the best kernel the CPU
+   * supports.
+   *
+   * @param predicate   Condition records must meet.
+   */
+  explicit RecordScanner(const RecordPredicate& predicate);
+
+  /**
+   * Constructs a scanner for <predicate> using at most the given kernel, or
+   * the best the CPU supports if that is less.  For tests and benchmarks.
+   *
+   * @param predicate   Condition records must meet.
+   * @param kernel      Most capable kernel to use.
+   */
+  RecordScanner(const RecordPredicate& predicate, const ScanKernel kernel);
+
+  /**
+   * Returns the best kernel the CPU supports.
+   */
+  static ScanKernel bestKernel();
+
+  /**
+   * Returns the kernel this scanner uses.
+   */
+  ScanKernel kernel() const { return kernel_; }
+
+  /**
+   * Appends the IDs of the page's matching records to <matches>.
+   *
+   * @param page      Page to scan.
+   * @param matches   Receives the IDs of matching records.
+   */
+  void scanPage(const Page& page, std::vector<RecordId>& matches) const;
+
+  /**
+   * Appends views of the page's matching records to <matches>.  The views
+   * are valid as long as the page stays in memory unchanged.
+   *
+   * @param page      Page to scan.
+   * @param matches   Receives views of matching records.
+   */
+  void scanPage(const Page& page, std::vector<RecordView>& matches) const;
+
+  /**
+   * Appends the IDs of the matching records of every used page of <file>
+   * to <matches>, pinning each page in <buffers> while it is scanned.
+   *
+   * @param file      File of variable-length records to scan.
+   * @param buffers   Buffer manager to read the pages through.
+   * @param matches   Receives the IDs of matching records.
+   */
+  void scanFile(File& file, BufMgr& buffers,
+                std::vector<RecordId>& matches) const;
+
+ private:
+  /**
+   * Finds the page's matching records.
+   *
+   * @param page    Page to scan.
+   * @param slots   Receives the slot numbers of matches; must have room for
+   *                every record of the page.
+   * @param views   If not NULL, receives views of matches, likewise.
+   * @return  Number of matches.
+   */
+  std::size_t findMatches(const Page& page, SlotId* slots,
+                          RecordView* views) const;
+
+  /**
+   * Condition records must meet.
+   */
+  RecordPredicate predicate_;
+
+  /**
+   * Kernel evaluating the predicate.
+   */
+  ScanKernel kernel_;
+};
+
+}
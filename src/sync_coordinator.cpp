@@ -0,0 +1,90 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "sync_coordinator.h"
+
+#include <cerrno>
+#include <unistd.h>
+
+namespace badgerdb {
+
+SyncCoordinator::SyncCoordinator()
+    : written_(0),
+      durable_(0),
+      unsynced_bytes_(0),
+      sync_in_progress_(false),
+      num_syncs_(0),
+      last_sync_(std::chrono::steady_clock::now()) {
+}
+
+std::uint64_t SyncCoordinator::noteWrite(const std::size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  unsynced_bytes_ += bytes;
+  return ++written_;
+}
+
+int SyncCoordinator::syncThrough(const int fd, const std::uint64_t sequence) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (durable_ < sequence) {
+    if (sync_in_progress_) {
+      // Someone else is syncing; their sync may well cover our write.
+      sync_done_.wait(lock);
+      continue;
+    }
+    // Become the leader for everything written so far, including the writes
+    // of any callers currently waiting on us.
+    sync_in_progress_ = true;
+    const std::uint64_t target = written_;
+    const std::uint64_t target_bytes = unsynced_bytes_;
+    lock.unlock();
+    const int result = ::fdatasync(fd) == 0 ? 0 : errno;
+    lock.lock();
+    sync_in_progress_ = false;
+    ++num_syncs_;
+    if (result == 0) {
+      durable_ = target;
+      unsynced_bytes_ -= target_bytes;
+      last_sync_ = std::chrono::steady_clock::now();
+    }
+    sync_done_.notify_all();
+    if (result != 0) {
+      return result;
+    }
+  }
+  return 0;
+}
+
+int SyncCoordinator::syncAll(const int fd) {
+  return syncThrough(fd, writtenSequence());
+}
+
+std::uint64_t SyncCoordinator::writtenSequence() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return written_;
+}
+
+std::uint64_t SyncCoordinator::durableSequence() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return durable_;
+}
+
+std::uint64_t SyncCoordinator::unsyncedBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return unsynced_bytes_;
+}
+
+std::chrono::steady_clock::duration SyncCoordinator::timeSinceSync() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::chrono::steady_clock::now() - last_sync_;
+}
+
+std::uint64_t SyncCoordinator::numSyncs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_syncs_;
+}
+
+}
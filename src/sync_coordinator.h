@@ -0,0 +1,132 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace badgerdb {
+
+/**
+ * @brief Merges concurrent fdatasync requests on one file descriptor.
+ *
+ * Every write issued against the descriptor is stamped with a sequence number
+ * by noteWrite().  A caller that needs its writes to be durable asks for a sync
+ * through that sequence number.  Only one fdatasync runs at a time; callers
+ * that arrive while it is in flight wait for it, and if their write was not
+ * covered by it, one of them issues a single follow-up sync on behalf of all
+ * of the waiters.  A burst of N concurrent sync requests therefore costs at
+ * most two fdatasync calls instead of N.
+ *
+ * This class is threadsafe.
+ */
+class SyncCoordinator {
+ public:
+  /**
+   * Constructs a coordinator with no writes outstanding.
+   */
+  SyncCoordinator();
+
+  /**
+   * Records that a write of <bytes> bytes has been issued to the descriptor.
+   *
+   * @param bytes   Number of bytes written.
+   * @return  Sequence number of the write.
+   */
+  std::uint64_t noteWrite(const std::size_t bytes);
+
+  /**
+   * Makes every write up to and including <sequence> durable, issuing an
+   * fdatasync on <fd> only if no other caller's sync already covers it.
+   *
+   * @param fd        Descriptor to sync.
+   * @param sequence  Sequence number that must be durable on return.
+   * @return  0 on success, otherwise the errno reported by fdatasync.
+   */
+  int syncThrough(const int fd, const std::uint64_t sequence);
+
+  /**
+   * Makes every write issued so far durable.
+   *
+   * @param fd  Descriptor to sync.
+   * @return  0 on success, otherwise the errno reported by fdatasync.
+   */
+  int syncAll(const int fd);
+
+  /**
+   * Returns the sequence number of the most recently issued write.
+   */
+  std::uint64_t writtenSequence() const;
+
+  /**
+   * Returns the sequence number through which all writes are durable.
+   */
+  std::uint64_t durableSequence() const;
+
+  /**
+   * Returns the number of bytes written since the last completed sync.
+   */
+  std::uint64_t unsyncedBytes() const;
+
+  /**
+   * Returns the time elapsed since the last completed sync (or since the
+   * coordinator was created if no sync has happened yet).
+   */
+  std::chrono::steady_clock::duration timeSinceSync() const;
+
+  /**
+   * Returns the number of fdatasync calls actually issued.
+   */
+  std::uint64_t numSyncs() const;
+
+ private:
+  /**
+   * Protects all of the fields below.
+   */
+  mutable std::mutex mutex_;
+
+  /**
+   * Signalled whenever an in-flight sync completes.
+   */
+  std::condition_variable sync_done_;
+
+  /**
+   * Sequence number of the most recently issued write.
+   */
+  std::uint64_t written_;
+
+  /**
+   * Sequence number through which all writes are durable.
+   */
+  std::uint64_t durable_;
+
+  /**
+   * Bytes written after the write numbered <durable_>.
+   */
+  std::uint64_t unsynced_bytes_;
+
+  /**
+   * Whether some caller is currently inside fdatasync.
+   */
+  bool sync_in_progress_;
+
+  /**
+   * Number of fdatasync calls issued.
+   */
+  std::uint64_t num_syncs_;
+
+  /**
+   * Completion time of the last sync.
+   */
+  std::chrono::steady_clock::time_point last_sync_;
+};
+
+}
@@ -19,6 +19,11 @@ typedef std::uint32_t PageId;
  */
 typedef std::uint16_t SlotId;
 
+/**
+ * @brief Identifier for an open file; see FileRegistry.
+ */
+typedef std::uint32_t FileId;
+
 /**
  * @brief Identifier for a frame in buffer pool.
  */